@@ -187,7 +187,8 @@ static int draw_condition_binary_le(ivl_expr_t expr)
       }
 
       char use_opcode = ivl_expr_opcode(expr);
-      char s_flag = (ivl_expr_signed(le) && ivl_expr_signed(re)) ? 's' : 'u';
+      const char*s_flag = vec4_opcode_suffix(le, re,
+					      ivl_expr_signed(le) && ivl_expr_signed(re));
 
       if (test_immediate_vec4_ok(le) && !test_immediate_vec4_ok(re)) {
 	    tmp = le;
@@ -246,15 +247,15 @@ static int draw_condition_binary_le(ivl_expr_t expr)
       if (ivl_expr_width(re)==use_wid && test_immediate_vec4_ok(re)) {
 	      /* Special case: If the right operand can be handled as
 		 an immediate operand, then use that instead. */
-	    char opcode[8];
-	    snprintf(opcode, sizeof opcode, "%%cmpi/%c", s_flag);
+	    char opcode[16];
+	    snprintf(opcode, sizeof opcode, "%%cmpi/%s", s_flag);
 	    draw_immediate_vec4(re, opcode);
 
       } else {
 	    draw_eval_vec4(re);
 	    resize_vec4_wid(re, use_wid);
 
-	    fprintf(vvp_out, "    %%cmp/%c;\n", s_flag);
+	    fprintf(vvp_out, "    %%cmp/%s;\n", s_flag);
       }
 
       switch (use_opcode) {
@@ -108,6 +108,20 @@ void draw_immediate_vec4(ivl_expr_t re, const char*opcode)
       fprintf(vvp_out, "    %s %lu, %lu, %u;\n", opcode, val0, valx, wid);
 }
 
+/*
+ * The compare and arithmetic instructions have 2-state forms that the
+ * code generator can use if both operands are 2-state. Return the
+ * opcode suffix that selects the signed or unsigned flavor, and the
+ * 2-state form if it applies.
+ */
+const char* vec4_opcode_suffix(ivl_expr_t le, ivl_expr_t re, int signed_flag)
+{
+      if (ivl_expr_value(le) == IVL_VT_BOOL && ivl_expr_value(re) == IVL_VT_BOOL)
+	    return signed_flag? "2s" : "2u";
+      else
+	    return signed_flag? "s" : "u";
+}
+
 static void draw_binary_vec4_arith(ivl_expr_t expr)
 {
       ivl_expr_t le = ivl_expr_oper1(expr);
@@ -124,6 +138,10 @@ static void draw_binary_vec4_arith(ivl_expr_t expr)
 	   right hand operand (the exponent) is signed. */
       int signed_flag = (ivl_expr_signed(le) || is_power_op) && ivl_expr_signed(re) ? 1 : 0;
       const char*signed_string = signed_flag? "/s" : "";
+      const char*div_suffix = vec4_opcode_suffix(le, re, signed_flag);
+	/* The add, subtract and multiply results do not depend on the
+	   signedness, so their 2-state forms have no signed flavor. */
+      int two_state = div_suffix[0] == '2';
 
 	/* All the arithmetic operations handled here (except for the power
 	   operation) require that the operands (and the result) be the same
@@ -141,13 +159,13 @@ static void draw_binary_vec4_arith(ivl_expr_t expr)
       if (rwid==ewid && test_immediate_vec4_ok(re)) {
 	    switch (ivl_expr_opcode(expr)) {
 		case '+':
-		  draw_immediate_vec4(re, "%addi");
+		  draw_immediate_vec4(re, two_state? "%addi/2" : "%addi");
 		  return;
 		case '-':
-		  draw_immediate_vec4(re, "%subi");
+		  draw_immediate_vec4(re, two_state? "%subi/2" : "%subi");
 		  return;
 		case '*':
-		  draw_immediate_vec4(re, "%muli");
+		  draw_immediate_vec4(re, two_state? "%muli/2" : "%muli");
 		  return;
 		default:
 		  break;
@@ -161,19 +179,25 @@ static void draw_binary_vec4_arith(ivl_expr_t expr)
 
       switch (ivl_expr_opcode(expr)) {
 	  case '+':
-	    fprintf(vvp_out, "    %%add;\n");
+	    fprintf(vvp_out, "    %%add%s;\n", two_state? "/2" : "");
 	    break;
 	  case '-':
-	    fprintf(vvp_out, "    %%sub;\n");
+	    fprintf(vvp_out, "    %%sub%s;\n", two_state? "/2" : "");
 	    break;
 	  case '*':
-	    fprintf(vvp_out, "    %%mul;\n");
+	    fprintf(vvp_out, "    %%mul%s;\n", two_state? "/2" : "");
 	    break;
 	  case '/':
-	    fprintf(vvp_out, "    %%div%s;\n", signed_string);
+	    if (two_state)
+		  fprintf(vvp_out, "    %%div/%s;\n", div_suffix);
+	    else
+		  fprintf(vvp_out, "    %%div%s;\n", signed_string);
 	    break;
 	  case '%':
-	    fprintf(vvp_out, "    %%mod%s;\n", signed_string);
+	    if (two_state)
+		  fprintf(vvp_out, "    %%mod/%s;\n", div_suffix);
+	    else
+		  fprintf(vvp_out, "    %%mod%s;\n", signed_string);
 	    break;
 	  case 'p':
 	    fprintf(vvp_out, "    %%pow%s;\n", signed_string);
@@ -556,7 +580,8 @@ static void draw_binary_vec4_le(ivl_expr_t expr)
       }
 
       char use_opcode = ivl_expr_opcode(expr);
-      char s_flag = (ivl_expr_signed(le) && ivl_expr_signed(re)) ? 's' : 'u';
+      const char*s_flag = vec4_opcode_suffix(le, re,
+					      ivl_expr_signed(le) && ivl_expr_signed(re));
 
 	/* If this is a > or >=, then convert it to < or <= by
 	   swapping the operands. Adjust the opcode to match. */
@@ -606,15 +631,15 @@ static void draw_binary_vec4_le(ivl_expr_t expr)
       if (ivl_expr_width(re)==use_wid && test_immediate_vec4_ok(re)) {
 	      /* Special case: If the right operand can be handled as
 		 an immediate operand, then use that instead. */
-	    char opcode[8];
-	    snprintf(opcode, sizeof opcode, "%%cmpi/%c", s_flag);
+	    char opcode[16];
+	    snprintf(opcode, sizeof opcode, "%%cmpi/%s", s_flag);
 	    draw_immediate_vec4(re, opcode);
 
       } else {
 	    draw_eval_vec4(re);
 	    resize_vec4_wid(re, use_wid);
 
-	    fprintf(vvp_out, "    %%cmp/%c;\n", s_flag);
+	    fprintf(vvp_out, "    %%cmp/%s;\n", s_flag);
       }
 
       switch (use_opcode) {
@@ -260,6 +260,7 @@ extern void show_stmt_file_line(ivl_statement_t net, const char*desc);
  */
 extern int test_immediate_vec4_ok(ivl_expr_t expr);
 extern void draw_immediate_vec4(ivl_expr_t expr, const char*opcode);
+extern const char* vec4_opcode_suffix(ivl_expr_t le, ivl_expr_t re, int signed_flag);
 
 /*
  * Draw a delay statement.
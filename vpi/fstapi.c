@@ -790,6 +790,7 @@ unsigned char already_in_close; /* in case control-c handlers interrupt */
 
 #ifdef FST_WRITER_PARALLEL
 pthread_mutex_t mutex;
+pthread_cond_t block_done;
 pthread_t thread;
 pthread_attr_t thread_attr;
 struct fstWriterContext *xc_parent;
@@ -1189,6 +1190,7 @@ if((!nam)||
                 xc->nan = strtod("NaN", NULL);
 #ifdef FST_WRITER_PARALLEL
                 pthread_mutex_init(&xc->mutex, NULL);
+                pthread_cond_init(&xc->block_done, NULL);
                 pthread_attr_init(&xc->thread_attr);
                 pthread_attr_setdetachstate(&xc->thread_attr, PTHREAD_CREATE_DETACHED);
 #endif
@@ -1803,6 +1805,21 @@ xc->already_in_flush = 0;
 
 
 #ifdef FST_WRITER_PARALLEL
+/*
+ * waits until the block that is being written by a thread (if any) is
+ * finished, the block thread signals block_done when it clears in_pthread
+ */
+static void fstWriterWaitForBlock(struct fstWriterContext *xc)
+{
+pthread_mutex_lock(&xc->mutex);
+while(xc->in_pthread)
+        {
+        pthread_cond_wait(&xc->block_done, &xc->mutex);
+        }
+pthread_mutex_unlock(&xc->mutex);
+}
+
+
 static void *fstWriterFlushContextPrivate1(void *ctx)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
@@ -1816,10 +1833,11 @@ free(xc->curval_mem);
 free(xc->valpos_mem);
 free(xc->vchg_mem);
 tmpfile_close(&xc->tchn_handle, &xc->tchn_handle_nam);
-free(xc);
 
 xc->xc_parent->in_pthread = 0;
+pthread_cond_broadcast(&(xc->xc_parent->block_done));
 pthread_mutex_unlock(&(xc->xc_parent->mutex));
+free(xc);
 
 return(NULL);
 }
@@ -1834,8 +1852,9 @@ if(xc->parallel_enabled)
         struct fstWriterContext *xc2 = (struct fstWriterContext *)malloc(sizeof(struct fstWriterContext));
         unsigned int i;
 
-        pthread_mutex_lock(&xc->mutex);
-        pthread_mutex_unlock(&xc->mutex);
+        /* the previous block must be finished before the context is copied,
+           as that thread updates the section position in the parent */
+        fstWriterWaitForBlock(xc);
 
         xc->xc_parent = xc;
         memcpy(xc2, xc, sizeof(struct fstWriterContext));
@@ -1868,14 +1887,8 @@ if(xc->parallel_enabled)
         xc->section_header_only = 0;
         xc->secnum++;
 
-	while (xc->in_pthread) 
-		{ 
-		pthread_mutex_lock(&xc->mutex); 
-		pthread_mutex_unlock(&xc->mutex); 
-		};
-
         pthread_mutex_lock(&xc->mutex);
-	xc->in_pthread = 1;
+        xc->in_pthread = 1;
         pthread_mutex_unlock(&xc->mutex);
 
         pthread_create(&xc->thread, &xc->thread_attr, fstWriterFlushContextPrivate1, xc2);
@@ -1921,8 +1934,8 @@ struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 #ifdef FST_WRITER_PARALLEL
 if(xc)
         {
-        pthread_mutex_lock(&xc->mutex);
-        pthread_mutex_unlock(&xc->mutex);
+        /* a block that is still being written may need to emit the next section header */
+        fstWriterWaitForBlock(xc);
         }
 #endif
 
@@ -1956,14 +1969,7 @@ if(xc && !xc->already_in_close && !xc->already_in_flush)
                                 }
                         fstWriterFlushContextPrivate(xc);
 #ifdef FST_WRITER_PARALLEL
-                        pthread_mutex_lock(&xc->mutex);
-                        pthread_mutex_unlock(&xc->mutex);
-
-			while (xc->in_pthread) 
-				{ 
-				pthread_mutex_lock(&xc->mutex); 
-				pthread_mutex_unlock(&xc->mutex); 
-				};
+                        fstWriterWaitForBlock(xc);
 #endif
                         }
                 }
@@ -2253,6 +2259,7 @@ if(xc && !xc->already_in_close && !xc->already_in_flush)
 
 #ifdef FST_WRITER_PARALLEL
         pthread_mutex_destroy(&xc->mutex);
+        pthread_cond_destroy(&xc->block_done);
         pthread_attr_destroy(&xc->thread_attr);
 #endif
 
@@ -2565,6 +2572,23 @@ if(xc)
 }
 
 
+/*
+ * sets the amount of value change data that is buffered before a block
+ * is compressed and written, this also disables the automatic growth
+ * of the block size for designs with many signals
+ */
+void fstWriterSetBreakSize(void *ctx, uint64_t numbytes)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc && numbytes)
+        {
+        if(numbytes > FST_BREAK_SIZE_MAX) numbytes = FST_BREAK_SIZE_MAX;
+        xc->fst_break_size = xc->fst_orig_break_size = numbytes;
+        xc->fst_huge_break_size = numbytes;
+        }
+}
+
+
 void fstWriterSetDumpSizeLimit(void *ctx, uint64_t numbytes)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
@@ -373,6 +373,7 @@ int             fstWriterGetFseekFailed(void *ctx);
 void            fstWriterSetAttrBegin(void *ctx, enum fstAttrType attrtype, int subtype,
                         const char *attrname, uint64_t arg);
 void            fstWriterSetAttrEnd(void *ctx);
+void            fstWriterSetBreakSize(void *ctx, uint64_t numbytes);
 void            fstWriterSetComment(void *ctx, const char *comm);
 void            fstWriterSetDate(void *ctx, const char *dat);
 void            fstWriterSetDumpSizeLimit(void *ctx, uint64_t numbytes);
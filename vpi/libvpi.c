@@ -284,6 +284,37 @@ void vpip_set_return_value(int value)
       assert(vpip_routines);
       vpip_routines->set_return_value(value);
 }
+vpipBatch vpip_batch_create(vpiHandle*list, unsigned count)
+{
+      assert(vpip_routines);
+      return vpip_routines->batch_create(list, count);
+}
+unsigned vpip_batch_size(vpipBatch batch)
+{
+      assert(vpip_routines);
+      return vpip_routines->batch_size(batch);
+}
+void vpip_batch_get(vpipBatch batch, s_vpi_vecval*buf, PLI_UINT32*changed)
+{
+      assert(vpip_routines);
+      vpip_routines->batch_get(batch, buf, changed);
+}
+void vpip_batch_put(vpipBatch batch, const s_vpi_vecval*buf,
+                    const PLI_UINT32*mask)
+{
+      assert(vpip_routines);
+      vpip_routines->batch_put(batch, buf, mask);
+}
+void vpip_batch_free(vpipBatch batch)
+{
+      assert(vpip_routines);
+      vpip_routines->batch_free(batch);
+}
+void vpip_mcd_flush_all(void)
+{
+      assert(vpip_routines);
+      vpip_routines->mcd_flush_all();
+}
 
 DLLEXPORT PLI_UINT32 vpip_set_callback(vpip_routines_s*routines, PLI_UINT32 version)
 {
@@ -55,8 +55,20 @@ static PLI_INT32 my_mcd_printf(PLI_UINT32 mcd, const char *fmt, ...)
       if (IS_MCD(mcd)) {
 	    r = vpi_mcd_vprintf(mcd, fmt, ap);
       } else {
-	    FILE *fp = vpi_get_file(mcd);
-	    if (fp) r = vfprintf(fp, fmt, ap);
+	      /* Format the text and pass it on, so the file does not
+		 need to be synchronized for a direct write. */
+	    char buffer[1024];
+	    char*buf = buffer;
+	    va_list saved_ap;
+	    va_copy(saved_ap, ap);
+	    r = vsnprintf(buffer, sizeof buffer, fmt, ap);
+	    if (r >= (int)sizeof buffer) {
+		  buf = malloc(r + 1);
+		  r = vsnprintf(buf, r + 1, fmt, saved_ap);
+	    }
+	    va_end(saved_ap);
+	    if (r > 0) vpip_mcd_rawwrite(mcd, buf, r);
+	    if (buf != buffer) free(buf);
       }
 
       va_end(ap);
@@ -65,19 +77,7 @@ static PLI_INT32 my_mcd_printf(PLI_UINT32 mcd, const char *fmt, ...)
 
 static void my_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t count)
 {
-      if (IS_MCD(mcd)) {
-	    vpip_mcd_rawwrite(mcd, buf, count);
-      } else {
-	    FILE*fp = vpi_get_file(mcd);
-	    if (fp) {
-		  while (count > 0) {
-			size_t rc = fwrite(buf, 1, count, fp);
-			if (rc == 0) break;
-			count -= rc;
-			buf += rc;
-		  }
-	    }
-      }
+      vpip_mcd_rawwrite(mcd, buf, count);
 }
 
 struct timeformat_info_s timeformat_info = { 0, 0, 0, 20 };
@@ -291,25 +291,268 @@ static void get_time_real(char *rtn, double value, int prec,
   sprintf(rtn, "%0.*f%s", prec, value, timeformat_info.suff);
 }
 
-static unsigned int get_format_char(char **rtn, int ljust, int plus,
-                                    int ld_zero, int width, int prec,
-                                    char fmt, const struct strobe_cb_info *info,
-                                    unsigned int *idx)
+/*
+ * The formatted output is built in a display_buf_s, which grows as
+ * needed. The text can have NULL characters in it (from %u and %z), so
+ * the length is kept, and there is always room for a trailing '\0'.
+ */
+struct display_buf_s {
+      char*data;
+      unsigned len, size;
+};
+
+/* Make room for cnt more characters and a trailing '\0'. */
+static char*display_buf_reserve(struct display_buf_s*buf, unsigned cnt)
+{
+      if (buf->len + cnt + 1 > buf->size) {
+	    buf->size = 2 * (buf->len + cnt + 1);
+	    if (buf->size < 256) buf->size = 256;
+	    buf->data = realloc(buf->data, buf->size);
+      }
+      return buf->data + buf->len;
+}
+
+static void display_buf_append(struct display_buf_s*buf, const char*text,
+                               unsigned cnt)
+{
+      memcpy(display_buf_reserve(buf, cnt), text, cnt);
+      buf->len += cnt;
+}
+
+static void display_buf_fill(struct display_buf_s*buf, char ch, unsigned cnt)
+{
+      memset(display_buf_reserve(buf, cnt), ch, cnt);
+      buf->len += cnt;
+}
+
+/* Append the text padded with spaces to width, which is the same as
+ * sprintf() with a %*s or %-*s format. */
+static void display_buf_pad(struct display_buf_s*buf, const char*text,
+                            unsigned len, int width, int ljust)
+{
+      unsigned pad = (width > 0 && (unsigned)width > len)? width - len : 0;
+      if (ljust == 0) display_buf_fill(buf, ' ', pad);
+      display_buf_append(buf, text, len);
+      if (ljust != 0) display_buf_fill(buf, ' ', pad);
+}
+
+/* Return the value format that the conversion gets its argument in. */
+static PLI_INT32 get_conv_value_format(char fmt)
+{
+      switch (fmt) {
+	  case 'b':
+	  case 'B':
+	    return vpiBinStrVal;
+	  case 'o':
+	  case 'O':
+	    return vpiOctStrVal;
+	  case 'h':
+	  case 'H':
+	  case 'x':
+	  case 'X':
+	    return vpiHexStrVal;
+	  case 'c':
+	  case 'C':
+	    return vpiIntVal;
+	  case 'd':
+	  case 'D':
+	    return vpiDecStrVal;
+	  case 's':
+	  case 'S':
+	    return vpiStringVal;
+	  default:
+	    return vpiRealVal;
+      }
+}
+
+/* Return the printf() format for an e/f/g conversion. The user needs
+ * to free the returned string. */
+static char *get_real_format(int ljust, int plus, int ld_zero, int width,
+                             int prec, char fmt)
+{
+      char *fmtb = format_as_string(ljust, plus, ld_zero, width, prec,
+                                    fmt == 'F'? 'f' : fmt);
+      size_t len = strlen(fmtb);
+	/* Remove the <> around the format. */
+      memmove(fmtb, fmtb+1, len-2);
+      fmtb[len-2] = '\0';
+      return fmtb;
+}
+
+/*
+ * These append the result of a conversion to the buffer, given the
+ * value of the argument. The caller has already checked the format
+ * and the value. Where the default width depends on the argument,
+ * def_width is that width, or -1 to get it from the item.
+ */
+
+/* The binary, octal and hex conversions. */
+static void format_radix(struct display_buf_s*buf, const char*str,
+                         int ljust, int ld_zero, int width)
+{
+      unsigned len = strlen(str);
+
+      if (ld_zero == 1) {
+	      /* Strip the leading zeros if a width is not given, or for
+	       * a left aligned value. */
+	    if (width == -1 || ljust != 0) {
+		  while (*str == '0' && *(str+1) != '\0') str++;
+		  len = strlen(str);
+	      /* Pad with leading zeros. */
+	    } else if ((signed)len < width) {
+		  display_buf_fill(buf, '0', (unsigned)width - len);
+		  display_buf_append(buf, str, len);
+		  return;
+	    }
+      }
+      display_buf_pad(buf, str, len, width, ljust);
+}
+
+static void format_char(struct display_buf_s*buf, char ch, int ljust,
+                        int ld_zero, int width)
+{
+	/* If the width is less than one then use a width of one. */
+      if (width < 1) width = 1;
+      if (ljust == 0) {
+	    display_buf_fill(buf, ld_zero == 1? '0' : ' ', width-1);
+	    display_buf_fill(buf, ch, 1);
+      } else {
+	    display_buf_fill(buf, ch, 1);
+	    display_buf_fill(buf, ' ', width-1);
+      }
+}
+
+static void format_decimal(struct display_buf_s*buf, const char*str,
+                           int ljust, int plus, int ld_zero, int width,
+                           int def_width, vpiHandle item)
+{
+      char sign = 0;
+      unsigned pad = 0;
+      unsigned swidth = strlen(str) + (str[0] == '-'? 0 : (unsigned)plus);
+      unsigned len, tlen;
+
+	/* Zero padding goes between the sign and the digits. */
+      if (ljust == 0 && ld_zero == 1 && (signed)swidth < width)
+	    pad = (unsigned)width - swidth;
+      if (plus == 1 && *str != '-') {
+	    sign = '+';
+      } else if (*str == '-') {
+	    sign = '-';
+	    str += 1;
+      }
+      len = strlen(str);
+      tlen = (sign? 1 : 0) + pad + len;
+
+	/* If a width was not given, use the default, unless we have a
+	 * leading zero (width of zero). Because the width of a real in
+	 * Icarus is 1 the string length will set the width of a real
+	 * displayed using %d. */
+      if (width == -1) {
+	    width = def_width;
+	    if (width == -1)
+		  width = (ld_zero == 1)? 0 : vpi_get_dec_size(item);
+      }
+
+      if (ljust == 0 && (signed)tlen < width)
+	    display_buf_fill(buf, ' ', width - tlen);
+      if (sign) display_buf_fill(buf, sign, 1);
+      display_buf_fill(buf, '0', pad);
+      display_buf_append(buf, str, len);
+      if (ljust != 0 && (signed)tlen < width)
+	    display_buf_fill(buf, ' ', width - tlen);
+}
+
+/* Strings are not numeric and are not zero filled, so %08s => %8s. */
+static void format_string(struct display_buf_s*buf, const char*str,
+                          int ljust, int ld_zero, int width, int def_width,
+                          vpiHandle item)
+{
+      if (width == -1) {
+	    width = def_width;
+	      /* If all we have is a leading zero then we want a zero
+	       * width. Otherwise use the value width. */
+	    if (width == -1)
+		  width = (ld_zero == 1)? 0 : (vpi_get(vpiSize, item)+7) / 8;
+      }
+      display_buf_pad(buf, str, strlen(str), width, ljust);
+}
+
+/* The e/f/g conversions, given the printf() format. */
+static void format_real(struct display_buf_s*buf, const char*real_fmt,
+                        double value, int width, int prec)
+{
+	/* This should always give enough space. The maximum double is
+	 * approximately 1.8*10^308 this means we could need 310
+	 * characters plus the precision. We'll use 320 to give some
+	 * extra buffer space. To be safe we add the precision to the
+	 * maximum size (think %6.300f when passed 1.2*10^308). */
+      unsigned size = width + 1;
+      char *cp;
+      if (size < 320) size = 320;
+      size += prec;
+      cp = display_buf_reserve(buf, size);
+#if !defined(__GNUC__)
+      if (isnan(value))
+	    sprintf(cp, "%s", "nan");
+      else
+	    sprintf(cp, real_fmt, value);
+#else
+      sprintf(cp, real_fmt, value);
+#endif
+      buf->len += strlen(cp);
+}
+
+static void format_scope(struct display_buf_s*buf, vpiHandle scope,
+                         int ljust, int width)
+{
+      char *cp = vpi_get_str(vpiFullName, scope);
+      display_buf_pad(buf, cp, strlen(cp), width, ljust);
+}
+
+/* Append the bytes of a vector value, in endian order. With the bval
+ * flag the bval of each word follows its aval. */
+static void format_vector_bytes(struct display_buf_s*buf,
+                                const s_vpi_value*value, vpiHandle item,
+                                int with_bval)
+{
+      PLI_INT32 veclen, word, elem, bits, byte;
+      unsigned nelem = with_bval? 2 : 1;
+      char *cp;
+
+      veclen = (vpi_get(vpiSize, item)+31)/32;
+      cp = display_buf_reserve(buf, nelem * veclen * 4);
+      for (word = 0; word < veclen; word += 1) {
+	    for (elem = 0; elem < (PLI_INT32)nelem; elem += 1) {
+		  bits = *(&value->value.vector[word].aval+elem);
+		    /* The %u format only gives the 0 and 1 bits. */
+		  if (! with_bval)
+			bits &= ~value->value.vector[word].bval;
+#ifdef WORDS_BIGENDIAN
+		  for (byte = 3; byte >= 0; byte -= 1) {
+#else
+		  for (byte = 0; byte <= 3; byte += 1) {
+#endif
+			*cp = (bits >> byte*8) & 0xff;
+			cp += 1;
+		  }
+	    }
+      }
+      buf->len += nelem * veclen * 4;
+}
+
+/* Append the conversion to the buffer. On an error, this prints a
+ * warning and appends the format itself. */
+static void get_format_char(struct display_buf_s*buf, int ljust, int plus,
+                            int ld_zero, int width, int prec,
+                            char fmt, const struct strobe_cb_info *info,
+                            unsigned int *idx)
 {
   s_vpi_value value;
-  char *result, *fmtb;
-  unsigned int size;
-  unsigned int ini_size = 512;  /* The initial size of the buffer. */
+  char *fmtb;
+  int error = 1; /* Append the full format if there is an error. */
 
-  /* Make sure the width fits in the initial buffer. */
   assert(width >= -1);
-  if ((unsigned int)(width+1) > ini_size) ini_size = width + 1;
-
-  /* The default return value is the full format. */
-  result = malloc(ini_size*sizeof(char));
   fmtb = format_as_string(ljust, plus, ld_zero, width, prec, fmt);
-  strcpy(result, fmtb);
-  size = strlen(result) + 1; /* fallback value if errors */
   switch (fmt) {
 
     case '%':
@@ -319,8 +562,8 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
         vpi_printf("WARNING: %s:%d: invalid format %s%s.\n",
                    info->filename, info->lineno, info->name, fmtb);
       }
-      strcpy(result, "%");
-      size = strlen(result) + 1;
+      display_buf_append(buf, "%", 1);
+      error = 0;
       break;
 
     case 'b':
@@ -340,56 +583,14 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
         vpi_printf("WARNING: %s:%d: missing argument for %s%s.\n",
                    info->filename, info->lineno, info->name, fmtb);
       } else {
-        switch (fmt) {
-          case 'b':
-          case 'B':
-            value.format = vpiBinStrVal;
-            break;
-          case 'o':
-          case 'O':
-            value.format = vpiOctStrVal;
-            break;
-          case 'h':
-          case 'H':
-          case 'x':
-          case 'X':
-            value.format = vpiHexStrVal;
-            break;
-        }
+        value.format = get_conv_value_format(fmt);
         vpi_get_value(info->items[*idx], &value);
         if (value.format == vpiSuppressVal) {
           vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
                      info->filename, info->lineno, info->name, fmtb);
         } else {
-          unsigned swidth = strlen(value.value.str), free_flag = 0;;
-          char *cp = value.value.str;
-
-          if (ld_zero == 1) {
-            /* Strip the leading zeros if a width is not given. */
-            if (width == -1) while (*cp == '0' && *(cp+1) != '\0') cp++;
-            /* Pad with leading zeros. */
-            else if (ljust == 0 && (signed)swidth < width) {
-              unsigned pad = (unsigned)width - swidth;
-              cp = malloc((width+1)*sizeof(char));
-              memset(cp, '0', pad);
-              strcpy(cp+pad, value.value.str);
-              free_flag = 1;
-            /* For a left aligned value also strip the leading zeros. */
-            } else if (ljust != 0) while (*cp == '0' && *(cp+1) != '\0') cp++;
-          }
-
-          /* If a width was not given, use a width of zero. */
-          if (width == -1) width = 0;
-
-          /* If the default buffer is too small, make it big enough. */
-          size = strlen(cp) + 1;
-          if ((signed)size < (width+1)) size = width+1;
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
-
-          if (ljust == 0) sprintf(result, "%*s", width, cp);
-          else sprintf(result, "%-*s", width, cp);
-          if (free_flag) free(cp);
-          size = strlen(result) + 1;
+          format_radix(buf, value.value.str, ljust, ld_zero, width);
+          error = 0;
         }
       }
       break;
@@ -411,25 +612,8 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
           vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
                      info->filename, info->lineno, info->name, fmtb);
         } else {
-          char ch = value.value.integer;
-
-          /* If the width is less than one then use a width of one. */
-          if (width < 1) width = 1;
-          size = width + 1;
-          assert(size <= ini_size);
-
-          if (ljust == 0) {
-            if (width > 1) {
-              memset(result, (ld_zero == 1 ? '0': ' '), width-1);
-            }
-            result[width-1] = ch;
-          } else {
-            result[0] = ch;
-            if (width > 1) {
-              memset(result+1, ' ', width-1);
-            }
-          }
-          result[width] = '\0';
+          format_char(buf, value.value.integer, ljust, ld_zero, width);
+          error = 0;
         }
       }
       break;
@@ -451,51 +635,9 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
           vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
                      info->filename, info->lineno, info->name, fmtb);
         } else {
-          unsigned pad = 0;
-          unsigned swidth = strlen(value.value.str) +
-                            (value.value.str[0] == '-' ? 0 : (unsigned)plus);
-          char *tbuf, *cpb, *cp = value.value.str;
-
-          /* Allocate storage and calculate the pad if needed. */
-          if (ljust == 0 && ld_zero == 1 && (signed)swidth < width) {
-            tbuf = malloc((width+1)*sizeof(char));
-            pad = (unsigned)width - swidth;
-          } else {
-            tbuf = malloc((swidth+1)*sizeof(char));
-          }
-          cpb = tbuf;
-
-          /* Insert the sign if needed. */
-          if (plus == 1 && *cp != '-') {
-            *cpb = '+';
-            cpb += 1;
-          } else if (*cp == '-') {
-            *cpb = '-';
-            cpb += 1;
-            cp += 1;
-          }
-
-          /* Now add padding if it is needed and then add the value. */
-          memset(cpb, '0', pad);
-          strcpy(cpb+pad, cp);
-
-          /* If a width was not given, use the default, unless we have a
-           * leading zero (width of zero). Because the width of a real in
-           * Icarus is 1 the string length will set the width of a real
-           * displayed using %d. */
-          if (width == -1) {
-            width = (ld_zero == 1) ? 0 : vpi_get_dec_size(info->items[*idx]);
-          }
-
-          /* If the default buffer is too small make it big enough. */
-          size = strlen(tbuf) + 1;
-          if ((signed)size < (width+1)) size = width+1;
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
-
-          if (ljust == 0) sprintf(result, "%*s", width, tbuf);
-          else sprintf(result, "%-*s", width, tbuf);
-          free(tbuf);
-          size = strlen(result) + 1;
+          format_decimal(buf, value.value.str, ljust, plus, ld_zero, width,
+                         -1, info->items[*idx]);
+          error = 0;
         }
       }
       break;
@@ -517,36 +659,11 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
           vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
                      info->filename, info->lineno, info->name, fmtb);
         } else {
-          char *cp = fmtb;
-
-          if (fmt == 'F') {
-            while (*cp != 'F') cp++;
-            *cp = 'f';
-          }
-          while (*cp != '>') cp++;
-          *cp = '\0';
-
-          /* If the default buffer is too small make it big enough.
-           *
-           * This should always give enough space. The maximum double
-           * is approximately 1.8*10^308 this means we could need 310
-           * characters plus the precision. We'll use 320 to give some
-           * extra buffer space. The initial buffers size should work
-           * for most cases, but to be safe we add the precision to
-           * the maximum size (think %6.300f when passed 1.2*10^308). */
-          size = width + 1;
-          if (size < 320) size = 320;
-          size += prec;
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
-#if !defined(__GNUC__)
-		  if (isnan(value.value.real))
-			  sprintf(result, "%s", "nan");
-		  else
-			  sprintf(result, fmtb+1, value.value.real);
-#else
-          sprintf(result, fmtb+1, value.value.real);
-#endif
-          size = strlen(result) + 1;
+          char *real_fmt = get_real_format(ljust, plus, ld_zero, width,
+                                           prec, fmt);
+          format_real(buf, real_fmt, value.value.real, width, prec);
+          free(real_fmt);
+          error = 0;
         }
       }
       break;
@@ -565,25 +682,12 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
         vpi_printf("WARNING: %s:%d: invalid format %s%s.\n",
                    info->filename, info->lineno, info->name, fmtb);
       }
-      /* If a width was not given, use a width of zero. */
-      if (width == -1) width = 0;
-
-      {
-        char *cp = vpi_get_str(vpiFullName, info->scope);
-        /* If the default buffer is too small, make it big enough. */
-        size = strlen(cp) + 1;
-        if ((signed)size < (width+1)) size = width+1;
-        if (size > ini_size) result = realloc(result, size*sizeof(char));
-
-        if (ljust == 0) sprintf(result, "%*s", width, cp);
-        else sprintf(result, "%-*s", width, cp);
-      }
-      size = strlen(result) + 1;
+      format_scope(buf, info->scope, ljust, width);
+      error = 0;
       break;
 
     case 's':
     case 'S':
-      /* Strings are not numeric and are not zero filled, so %08s => %8s. */
       *idx += 1;
       if (plus != 0 || prec != -1) {
         vpi_printf("WARNING: %s:%d: invalid format %s%s.\n",
@@ -599,19 +703,9 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
           vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
                      info->filename, info->lineno, info->name, fmtb);
         } else {
-          if (width == -1) {
-            /* If all we have is a leading zero then we want a zero width. */
-            if (ld_zero == 1) width = 0;
-            /* Otherwise if a width was not given, use the value width. */
-            else width = (vpi_get(vpiSize, info->items[*idx])+7) / 8;
-          }
-          /* If the default buffer is too small make it big enough. */
-          size = strlen(value.value.str) + 1;
-          if ((signed)size < (width+1)) size = width+1;
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
-          if (ljust == 0) sprintf(result, "%*s", width, value.value.str);
-          else sprintf(result, "%-*s", width, value.value.str);
-          size = strlen(result) + 1;
+          format_string(buf, value.value.str, ljust, ld_zero, width, -1,
+                        info->items[*idx]);
+          error = 0;
         }
       }
       break;
@@ -669,9 +763,8 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
               time_units += (3 + (time_units % 3)) % 3 + (time_prec - time_units);
           }
 
-          unsigned swidth, free_flag = 0;
+          unsigned swidth;
           unsigned suff_len = strlen(timeformat_info.suff);
-          char *cp;
 
           /* The 512 (513-1 for EOL) is more than enough for any double
            * value (309 digits plus a decimal point maximum). Because of
@@ -686,7 +779,6 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
           } else {
             get_time(tbuf, value.value.str, prec, time_units);
           }
-          cp = tbuf;
           swidth = strlen(tbuf);
 
           if (plus != 0) {
@@ -702,31 +794,23 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
             if (width == -1) width = 0;
             /* Pad with leading zeros. */
             else if (ljust == 0 && (signed)swidth < width) {
-              unsigned pad = (unsigned)width - swidth;
-              cp = malloc((width+1)*sizeof(char));
-              memset(cp, '0', pad);
-              strcpy(cp+pad, tbuf);
-              free_flag = 1;
+              display_buf_fill(buf, '0', (unsigned)width - swidth);
+              width = swidth;
             }
           }
           if (width == -1) width = timeformat_info.width;
 
-          /* If the default buffer is too small make it big enough. */
-          size = strlen(tbuf) + 1;
-          if ((signed)size < (width+1)) size = width+1;
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
-
-          if (ljust == 0) sprintf(result, "%*s", width, cp);
-          else sprintf(result, "%-*s", width, cp);
-          if (free_flag) free(cp);
+          display_buf_pad(buf, tbuf, swidth, width, ljust);
           free(tbuf);
-          size = strlen(result) + 1;
+          error = 0;
         }
       }
       break;
 
     case 'u':
     case 'U':
+    case 'z':
+    case 'Z':
       *idx += 1;
       if (ljust != 0  || plus != 0 || ld_zero != 0 || width != -1 ||
           prec != -1) {
@@ -743,31 +827,12 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
           vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
                      info->filename, info->lineno, info->name, fmtb);
         } else {
-          PLI_INT32 veclen, word, byte;
-          char *cp;
-
-          veclen = (vpi_get(vpiSize, info->items[*idx])+31)/32;
-          size = veclen * 4 + 1;
-          /* If the default buffer is too small, make it big enough. */
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
-          cp = result;
-          for (word = 0; word < veclen; word += 1) {
-            PLI_INT32 bits = value.value.vector[word].aval &
-                   ~value.value.vector[word].bval;
-#ifdef WORDS_BIGENDIAN
-            for (byte = 3; byte >= 0; byte -= 1) {
-#else
-            for (byte = 0; byte <= 3; byte += 1) {
-#endif
-              *cp = (bits >> byte*8) & 0xff;
-              cp += 1;
-            }
-          }
-          *cp = '\0';
+          /* These are binary strings (they can contain NULLs). */
+          format_vector_bytes(buf, &value, info->items[*idx],
+                              fmt == 'z' || fmt == 'Z');
+          error = 0;
         }
       }
-      /* size is defined above! We can't use strlen here since this can
-       * be a binary string (can contain NULLs). */
       break;
 
     case 'v':
@@ -791,91 +856,31 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
           PLI_INT32 nbits;
           int bit;
 
-          /* If a width was not given use a width of zero. */
-          if (width == -1) width = 0;
           nbits = vpi_get(vpiSize, info->items[*idx]);
           /* This is 4 chars for all but the last bit (strength + "_")
            * which only needs three chars (strength), but then you need
            * space for the EOS '\0', so it is just number of bits * 4. */
-          size = nbits*4;
-          rbuf = malloc(size*sizeof(char));
-          if ((signed)size < (width+1)) size = width+1;
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
+          rbuf = malloc(nbits*4*sizeof(char));
           strcpy(rbuf, "");
           for (bit = nbits-1; bit >= 0; bit -= 1) {
             vpip_format_strength(tbuf, &value, bit);
             strcat(rbuf, tbuf);
 	    if (bit > 0) strcat(rbuf, "_");
           }
-          if (ljust == 0) sprintf(result, "%*s", width, rbuf);
-          else sprintf(result, "%-*s", width, rbuf);
+          display_buf_pad(buf, rbuf, strlen(rbuf), width, ljust);
           free(rbuf);
-          size = strlen(result) + 1;
-        }
-      }
-      break;
-
-    case 'z':
-    case 'Z':
-      *idx += 1;
-      size = strlen(result) + 1; /* fallback value if errors */
-      if (ljust != 0  || plus != 0 || ld_zero != 0 || width != -1 ||
-          prec != -1) {
-        vpi_printf("WARNING: %s:%d: invalid format %s%s.\n",
-                   info->filename, info->lineno, info->name, fmtb);
-      }
-      if (*idx >= info->nitems) {
-        vpi_printf("WARNING: %s:%d: missing argument for %s%s.\n",
-                   info->filename, info->lineno, info->name, fmtb);
-      } else {
-        value.format = vpiVectorVal;
-        vpi_get_value(info->items[*idx], &value);
-        if (value.format == vpiSuppressVal) {
-          vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
-                     info->filename, info->lineno, info->name, fmtb);
-        } else {
-          PLI_INT32 veclen, word, elem, bits, byte;
-          char *cp;
-
-          veclen = (vpi_get(vpiSize, info->items[*idx])+31)/32;
-          size = 2 * veclen * 4 + 1;
-          /* If the default buffer is too small, make it big enough. */
-          if (size > ini_size) result = realloc(result, size*sizeof(char));
-          cp = result;
-          for (word = 0; word < veclen; word += 1) {
-            /* Write the aval followed by the bval in endian order. */
-            for (elem = 0; elem < 2; elem += 1) {
-              bits = *(&value.value.vector[word].aval+elem);
-#ifdef WORDS_BIGENDIAN
-              for (byte = 3; byte >= 0; byte -= 1) {
-#else
-              for (byte = 0; byte <= 3; byte += 1) {
-#endif
-                *cp = (bits >> byte*8) & 0xff;
-                cp += 1;
-              }
-            }
-          }
-          *cp = '\0';
+          error = 0;
         }
       }
-      /* size is defined above! We can't use strlen here since this can
-       * be a binary string (can contain NULLs). */
       break;
 
     default:
       vpi_printf("WARNING: %s:%d: unknown format %s%s.\n",
                  info->filename, info->lineno, info->name, fmtb);
-      size = strlen(result) + 1;
       break;
   }
+  if (error) display_buf_append(buf, fmtb, strlen(fmtb));
   free(fmtb);
-  /* We can't use strdup here since %u and %z can insert NULL
-   * characters into the stream. */
-  *rtn = malloc(size*sizeof(char));
-  memcpy(*rtn, result, size);
-  free(result);
-  return size - 1;
 }
 
 /* We can't use the normal str functions on the return value since
@@ -883,22 +888,17 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
 static unsigned int get_format(char **rtn, char *fmt,
                                const struct strobe_cb_info *info, unsigned int *idx)
 {
+  struct display_buf_s buf = { 0, 0, 0 };
   char *cp = fmt;
-  unsigned int size;
 
-  *rtn = strdup("");
-  size = 1;
   while (*cp) {
     size_t cnt = strcspn(cp, "%");
 
     if (cnt > 0) {
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, cp, cnt);
-      size += cnt;
+      display_buf_append(&buf, cp, cnt);
       cp += cnt;
     } else {
       int ljust = 0, plus = 0, ld_zero = 0, width = -1, prec = -1;
-      char *result;
 
       cp += 1;
       while ((*cp == '-') || (*cp == '+')) {
@@ -915,17 +915,14 @@ static unsigned int get_format(char **rtn, char *fmt,
         cp += 1;
         prec = strtoul(cp, &cp, 10);
       }
-      cnt = get_format_char(&result, ljust, plus, ld_zero, width, prec, *cp,
-                            info, idx);
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, result, cnt);
-      free(result);
-      size += cnt;
+      get_format_char(&buf, ljust, plus, ld_zero, width, prec, *cp,
+                      info, idx);
       if (*cp) cp += 1;
     }
   }
-  *(*rtn+size-1) = '\0';
-  return size - 1;
+  *display_buf_reserve(&buf, 0) = '\0';
+  *rtn = buf.data;
+  return buf.len;
 }
 
 static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
@@ -955,88 +952,31 @@ static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
   return strlen(*rtn);
 }
 
-/* In many places we can't use the normal str functions since %u and %z
- * can insert NULL characters into the stream. */
-static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+/* Format the item at *idx. A format string also uses the items that
+ * follow it, so this can move *idx on. We can't use the normal str
+ * functions on the return value since %u and %z can insert NULL
+ * characters into the stream. */
+static unsigned int get_display_item(char **rtn,
+                                     const struct strobe_cb_info *info,
+                                     unsigned int *idx)
 {
-  char *result, *fmt, *rtn, *func_name;
-  const char *cresult;
+  char *fmt, *func_name;
   s_vpi_value value;
-  unsigned int idx, size, width;
+  unsigned int width;
   char buf[256];
+  vpiHandle item = info->items[*idx];
 
-  rtn = strdup("");
-  size = 1;
-  for  (idx = 0; idx < info->nitems; idx += 1) {
-    vpiHandle item = info->items[idx];
-
-    switch (vpi_get(vpiType, item)) {
-
-      case vpiConstant:
-      case vpiParameter:
-        if (vpi_get(vpiConstType, item) == vpiStringConst) {
-          value.format = vpiStringVal;
-          vpi_get_value(item, &value);
-          fmt = strdup(value.value.str);
-          width = get_format(&result, fmt, info, &idx);
-          free(fmt);
-        } else if (vpi_get(vpiConstType, item) == vpiRealConst) {
-          value.format = vpiRealVal;
-          vpi_get_value(item, &value);
-#if !defined(__GNUC__)
-		  if (compatible_flag)
-			  sprintf(buf, "%g", value.value.real);
-		  else {
-			  if (value.value.real == 0.0 || value.value.real == -0.0)
-				  sprintf(buf, "%.05f", value.value.real);
-			  else
-				  sprintf(buf, "%#g", value.value.real);
-		  }
-#else
-          sprintf(buf, compatible_flag ? "%g" : "%#g", value.value.real);
-#endif
-          result = strdup(buf);
-          width = strlen(result);
-        } else {
-          width = get_numeric(&result, info, item);
-        }
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
-        free(result);
-        break;
-
-      case vpiNet:
-      case vpiReg:
-      case vpiBitVar:
-      case vpiByteVar:
-      case vpiShortIntVar:
-      case vpiIntVar:
-      case vpiLongIntVar:
-      case vpiIntegerVar:
-      case vpiMemoryWord:
-      case vpiPartSelect:
-        width = get_numeric(&result, info, item);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
-        free(result);
-        break;
-
-      /* It appears that this is not currently used! A time variable is
-         passed as an integer and processed above. Hence this code has
-         only been visually checked. */
-      case vpiTimeVar:
-        value.format = vpiDecStrVal;
-        vpi_get_value(item, &value);
-        get_time(buf, value.value.str, timeformat_info.prec,
-                 vpi_get(vpiTimeUnit, info->scope));
-        width = strlen(buf);
-        if (width  < timeformat_info.width) width = timeformat_info.width;
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        sprintf(rtn+size-1, "%*s", width, buf);
-        break;
+  switch (vpi_get(vpiType, item)) {
 
-      /* Realtime variables are also processed here. */
-      case vpiRealVar:
+    case vpiConstant:
+    case vpiParameter:
+      if (vpi_get(vpiConstType, item) == vpiStringConst) {
+        value.format = vpiStringVal;
+        vpi_get_value(item, &value);
+        fmt = strdup(value.value.str);
+        width = get_format(rtn, fmt, info, idx);
+        free(fmt);
+      } else if (vpi_get(vpiConstType, item) == vpiRealConst) {
         value.format = vpiRealVal;
         vpi_get_value(item, &value);
 #if !defined(__GNUC__)
@@ -1051,82 +991,140 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
 #else
         sprintf(buf, compatible_flag ? "%g" : "%#g", value.value.real);
 #endif
+        *rtn = strdup(buf);
+        width = strlen(*rtn);
+      } else {
+        width = get_numeric(rtn, info, item);
+      }
+      break;
+
+    case vpiNet:
+    case vpiReg:
+    case vpiBitVar:
+    case vpiByteVar:
+    case vpiShortIntVar:
+    case vpiIntVar:
+    case vpiLongIntVar:
+    case vpiIntegerVar:
+    case vpiMemoryWord:
+    case vpiPartSelect:
+      width = get_numeric(rtn, info, item);
+      break;
+
+    /* It appears that this is not currently used! A time variable is
+       passed as an integer and processed above. Hence this code has
+       only been visually checked. */
+    case vpiTimeVar:
+      value.format = vpiDecStrVal;
+      vpi_get_value(item, &value);
+      get_time(buf, value.value.str, timeformat_info.prec,
+               vpi_get(vpiTimeUnit, info->scope));
+      width = strlen(buf);
+      if (width  < timeformat_info.width) width = timeformat_info.width;
+      *rtn = malloc((width+1)*sizeof(char));
+      sprintf(*rtn, "%*s", width, buf);
+      break;
+
+    /* Realtime variables are also processed here. */
+    case vpiRealVar:
+      value.format = vpiRealVal;
+      vpi_get_value(item, &value);
+#if !defined(__GNUC__)
+	      if (compatible_flag)
+		      sprintf(buf, "%g", value.value.real);
+	      else {
+		      if (value.value.real == 0.0 || value.value.real == -0.0)
+			      sprintf(buf, "%.05f", value.value.real);
+		      else
+			      sprintf(buf, "%#g", value.value.real);
+	      }
+#else
+      sprintf(buf, compatible_flag ? "%g" : "%#g", value.value.real);
+#endif
+      *rtn = strdup(buf);
+      width = strlen(buf);
+      break;
+
+     /* Process string variables like string constants: interpret
+	the contained strings like format strings. */
+    case vpiStringVar:
+      value.format = vpiStringVal;
+      vpi_get_value(item, &value);
+      fmt = strdup(value.value.str);
+      width = get_format(rtn, fmt, info, idx);
+      free(fmt);
+      break;
+
+    case vpiSysFuncCall:
+      func_name = vpi_get_str(vpiName, item);
+      if (strcmp(func_name, "$time") == 0) {
+        value.format = vpiDecStrVal;
+        vpi_get_value(item, &value);
+        width = strlen(value.value.str);
+        if (width  < 20) width = 20;
+        *rtn = malloc((width+1)*sizeof(char));
+        sprintf(*rtn, "%*s", width, value.value.str);
+
+      } else if (strcmp(func_name, "$stime") == 0) {
+        value.format = vpiDecStrVal;
+        vpi_get_value(item, &value);
+        width = strlen(value.value.str);
+        if (width  < 10) width = 10;
+        *rtn = malloc((width+1)*sizeof(char));
+        sprintf(*rtn, "%*s", width, value.value.str);
+
+      } else if (strcmp(func_name, "$simtime") == 0) {
+        value.format = vpiDecStrVal;
+        vpi_get_value(item, &value);
+        width = strlen(value.value.str);
+        if (width  < 20) width = 20;
+        *rtn = malloc((width+1)*sizeof(char));
+        sprintf(*rtn, "%*s", width, value.value.str);
+
+      } else if (strcmp(func_name, "$realtime") == 0) {
+        /* Use the local scope precision. */
+        int use_prec = vpi_get(vpiTimeUnit, info->scope) -
+                       vpi_get(vpiTimePrecision, info->scope);
+        assert(use_prec >= 0);
+        value.format = vpiRealVal;
+        vpi_get_value(item, &value);
+        sprintf(buf, "%.*f", use_prec, value.value.real);
+        *rtn = strdup(buf);
         width = strlen(buf);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, buf, width);
-        break;
-
-       /* Process string variables like string constants: interpret
-	  the contained strings like format strings. */
-      case vpiStringVar:
-	value.format = vpiStringVal;
-	vpi_get_value(item, &value);
-	fmt = strdup(value.value.str);
-	width = get_format(&result, fmt, info, &idx);
-	free(fmt);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
-        free(result);
-	break;
-
-      case vpiSysFuncCall:
-        func_name = vpi_get_str(vpiName, item);
-        if (strcmp(func_name, "$time") == 0) {
-          value.format = vpiDecStrVal;
-          vpi_get_value(item, &value);
-          width = strlen(value.value.str);
-          if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
 
-        } else if (strcmp(func_name, "$stime") == 0) {
-          value.format = vpiDecStrVal;
-          vpi_get_value(item, &value);
-          width = strlen(value.value.str);
-          if (width  < 10) width = 10;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
+      } else {
+        vpi_printf("WARNING: %s:%d: %s does not support %s as an argument!\n",
+                   info->filename, info->lineno, info->name, func_name);
+        *rtn = strdup("<?>");
+        width = strlen(*rtn);
+      }
+      break;
 
-        } else if (strcmp(func_name, "$simtime") == 0) {
-          value.format = vpiDecStrVal;
-          vpi_get_value(item, &value);
-          width = strlen(value.value.str);
-          if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
-
-        } else if (strcmp(func_name, "$realtime") == 0) {
-          /* Use the local scope precision. */
-          int use_prec = vpi_get(vpiTimeUnit, info->scope) -
-                         vpi_get(vpiTimePrecision, info->scope);
-          assert(use_prec >= 0);
-          value.format = vpiRealVal;
-          vpi_get_value(item, &value);
-          sprintf(buf, "%.*f", use_prec, value.value.real);
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, buf);
+    default:
+      vpi_printf("WARNING: %s:%d: unknown argument type (%s) given to %s!\n",
+                 info->filename, info->lineno, vpi_get_str(vpiType, item),
+                 info->name);
+      *rtn = strdup("<?>");
+      width = strlen(*rtn);
+      break;
+  }
+  return width;
+}
 
-        } else {
-          vpi_printf("WARNING: %s:%d: %s does not support %s as an argument!\n",
-                     info->filename, info->lineno, info->name, func_name);
-          strcpy(buf, "<?>");
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          memcpy(rtn+size-1, buf, width);
-        }
-        break;
-
-      default:
-        vpi_printf("WARNING: %s:%d: unknown argument type (%s) given to %s!\n",
-                   info->filename, info->lineno, vpi_get_str(vpiType, item),
-                   info->name);
-        cresult = "<?>";
-        width = strlen(cresult);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, cresult, width);
-        break;
-    }
+/* In many places we can't use the normal str functions since %u and %z
+ * can insert NULL characters into the stream. */
+static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+{
+  char *result, *rtn;
+  unsigned int idx, size, width;
+
+  rtn = strdup("");
+  size = 1;
+  for  (idx = 0; idx < info->nitems; idx += 1) {
+    width = get_display_item(&result, info, &idx);
+    rtn = realloc(rtn, (size+width)*sizeof(char));
+    memcpy(rtn+size-1, result, width);
+    free(result);
     size += width;
   }
   rtn[size-1] = '\0';
@@ -1134,6 +1132,552 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
   return rtn;
 }
 
+/*
+ * The format strings given to $display and friends are almost always
+ * constants, so parsing them again on every call is wasted work. When
+ * the call is compiled, the arguments are made into a display program
+ * that is kept as the userdata of the call handle. The program has a
+ * step for each argument. A constant format string is parsed into a
+ * list of ops, each of which is some literal text or a conversion that
+ * is bound to the argument it uses. A common conversion that was
+ * checked is done by the same format_*() function that
+ * get_format_char() uses, and any other conversion is left to
+ * get_format_char() itself, so the output is exactly the same. Anything
+ * that is not known when the call is compiled (a string variable used
+ * as a format, for example) is left to get_display_item().
+ */
+enum display_op_type_e {
+      DISP_TEXT,     /* Literal text from the text pool. */
+      DISP_NUMERIC,  /* An item printed using the default format. */
+      DISP_CONV,     /* A checked conversion of the item. */
+      DISP_CONV_CHAR /* A conversion done by get_format_char(). */
+};
+
+struct display_op_s {
+      enum display_op_type_e type;
+      char fmt;
+      char ljust, plus, ld_zero;
+      int width, prec;
+	/* The item of the op. For DISP_CONV_CHAR this is the index that
+	 * get_format_char() expects, so the item before the argument. */
+      unsigned idx;
+	/* The offset and size of the DISP_TEXT text (or the printf
+	 * format of a real conversion) in the text pool. */
+      unsigned text, len;
+	/* The default width of the conversion, or -1 if the size of
+	 * the item may change so it is worked out for each call. */
+      int def_width;
+};
+
+struct display_step_s {
+	/* The ops of the step, or zero next if the item must be
+	 * formatted by get_display_item() */
+      unsigned op, nops;
+	/* The index of the item after the items used by the step. */
+      unsigned next;
+};
+
+struct display_prog_s {
+      struct strobe_cb_info info;
+	/* All the arguments of the call. The items of the info are the
+	 * arguments after the file descriptor or the $sformat output. */
+      vpiHandle*args;
+      struct display_step_s*steps;
+      struct display_op_s*ops;
+      unsigned nops;
+      char*text;
+      unsigned text_len;
+	/* The first op of the step that is being made. */
+      unsigned step_op;
+	/* For $sformat the program is the one step of the format, and
+	 * last_idx is the index of the last item that it uses. */
+      int format;
+      unsigned last_idx;
+};
+
+static struct display_prog_s**display_progs = 0;
+static unsigned display_prog_count = 0;
+
+/*
+ * The display programs build their output in this buffer, which is
+ * kept from call to call.
+ */
+static struct display_buf_s display_buf = { 0, 0, 0 };
+
+/* These are the items that get_display_item() prints with
+ * get_numeric(), and whose size does not change. */
+static int is_fixed_size_item(vpiHandle item)
+{
+      switch (vpi_get(vpiType, item)) {
+	  case vpiNet:
+	  case vpiReg:
+	  case vpiBitVar:
+	  case vpiByteVar:
+	  case vpiShortIntVar:
+	  case vpiIntVar:
+	  case vpiLongIntVar:
+	  case vpiIntegerVar:
+	  case vpiMemoryWord:
+	  case vpiPartSelect:
+	    return 1;
+	  default:
+	    return 0;
+      }
+}
+
+/* A string constant or parameter is a format string that never
+ * changes, but a string that comes from the thread is a new value
+ * for each call. */
+static int is_constant_format(vpiHandle item)
+{
+      PLI_INT32 type = vpi_get(vpiType, item);
+      if (type != vpiConstant && type != vpiParameter) return 0;
+      if (vpi_get(vpiConstType, item) != vpiStringConst) return 0;
+#ifdef BR916_STOPGAP_FIX
+      return vpi_get(_vpiFromThr, item) == _vpiNoThr;
+#else
+      return 0;
+#endif
+}
+
+static unsigned display_prog_text(struct display_prog_s*prog,
+                                  const char*text, unsigned len)
+{
+      unsigned off = prog->text_len;
+      prog->text = realloc(prog->text, prog->text_len + len + 1);
+      memcpy(prog->text + off, text, len);
+      prog->text_len += len;
+      prog->text[prog->text_len] = '\0';
+      return off;
+}
+
+static struct display_op_s*display_prog_op(struct display_prog_s*prog,
+                                           enum display_op_type_e type)
+{
+      struct display_op_s*op;
+      prog->ops = realloc(prog->ops, (prog->nops+1)*sizeof(*op));
+      op = prog->ops + prog->nops;
+      prog->nops += 1;
+      memset(op, 0, sizeof(*op));
+      op->type = type;
+      op->def_width = -1;
+      return op;
+}
+
+static void display_prog_add_text(struct display_prog_s*prog,
+                                  const char*text, unsigned len)
+{
+      struct display_op_s*op;
+	/* Add to the text of the previous op of the step if we can. */
+      if (prog->nops > prog->step_op) {
+	    op = prog->ops + prog->nops - 1;
+	    if (op->type == DISP_TEXT && op->text + op->len == prog->text_len) {
+		  display_prog_text(prog, text, len);
+		  op->len += len;
+		  return;
+	    }
+      }
+      op = display_prog_op(prog, DISP_TEXT);
+      op->text = display_prog_text(prog, text, len);
+      op->len = len;
+}
+
+/* This follows get_format_char(), including the way it moves *idx on
+ * to the argument of the conversion. */
+static void display_prog_add_conv(struct display_prog_s*prog, int ljust,
+                                  int plus, int ld_zero, int width, int prec,
+                                  char fmt, unsigned int *idx)
+{
+      const struct strobe_cb_info*info = &prog->info;
+      struct display_op_s*op;
+      unsigned arg_idx = *idx;
+      int checked = 0;
+
+      switch (fmt) {
+	  case '%':
+	  case '\0':
+	    if (ljust == 0 && plus == 0 && ld_zero == 0 && width == -1 &&
+	        prec == -1) {
+		  display_prog_add_text(prog, "%", 1);
+		  return;
+	    }
+	    break;
+
+	  case 'b':
+	  case 'B':
+	  case 'o':
+	  case 'O':
+	  case 'h':
+	  case 'H':
+	  case 'x':
+	  case 'X':
+	  case 'c':
+	  case 'C':
+	  case 's':
+	  case 'S':
+	    *idx += 1;
+	    checked = plus == 0 && prec == -1 && *idx < info->nitems;
+	    break;
+
+	  case 'd':
+	  case 'D':
+	    *idx += 1;
+	    checked = prec == -1 && *idx < info->nitems;
+	    break;
+
+	  case 'e':
+	  case 'E':
+	  case 'f':
+	  case 'F':
+	  case 'g':
+	  case 'G':
+	    *idx += 1;
+	    checked = *idx < info->nitems;
+	    break;
+
+	  case 'm':
+	  case 'M':
+	      /* The scope does not change, so the result is text. */
+	    if (plus == 0 && prec == -1) {
+		  struct display_buf_s tbuf = { 0, 0, 0 };
+		  format_scope(&tbuf, info->scope, ljust, width);
+		  display_prog_add_text(prog, tbuf.data, tbuf.len);
+		  free(tbuf.data);
+		  return;
+	    }
+	    break;
+
+	  case 't':
+	  case 'T':
+	  case 'u':
+	  case 'U':
+	  case 'v':
+	  case 'V':
+	  case 'z':
+	  case 'Z':
+	    *idx += 1;
+	    break;
+
+	  default:
+	    break;
+      }
+
+      op = display_prog_op(prog, checked? DISP_CONV : DISP_CONV_CHAR);
+      op->fmt = fmt;
+      op->ljust = ljust;
+      op->plus = plus;
+      op->ld_zero = ld_zero;
+      op->width = width;
+      op->prec = prec;
+      if (! checked) {
+	    op->idx = arg_idx;
+	    return;
+      }
+
+      op->idx = *idx;
+      switch (fmt) {
+	  case 'd':
+	  case 'D':
+	    if (ld_zero == 1) op->def_width = 0;
+	    else if (is_fixed_size_item(info->items[op->idx]))
+		  op->def_width = vpi_get_dec_size(info->items[op->idx]);
+	    break;
+	  case 's':
+	  case 'S':
+	    if (ld_zero == 1) op->def_width = 0;
+	    else if (is_fixed_size_item(info->items[op->idx]))
+		  op->def_width = (vpi_get(vpiSize, info->items[op->idx])+7) / 8;
+	    break;
+	  case 'e':
+	  case 'E':
+	  case 'f':
+	  case 'F':
+	  case 'g':
+	  case 'G':
+	      /* Keep the printf format with the '\0' so it can be used
+	       * from the text pool. */
+	    {
+		  char *real_fmt = get_real_format(ljust, plus, ld_zero, width,
+		                                   prec, fmt);
+		  op->len = strlen(real_fmt);
+		  op->text = display_prog_text(prog, real_fmt, op->len+1);
+		  free(real_fmt);
+	    }
+	    break;
+	  default:
+	    break;
+      }
+}
+
+/* This parses the format the same way as get_format(). */
+static void display_prog_add_format(struct display_prog_s*prog,
+                                    const char*text, unsigned int *idx)
+{
+      char *fmt = strdup(text);
+      char *cp = fmt;
+
+      while (*cp) {
+	    size_t cnt = strcspn(cp, "%");
+
+	    if (cnt > 0) {
+		  display_prog_add_text(prog, cp, cnt);
+		  cp += cnt;
+	    } else {
+		  int ljust = 0, plus = 0, ld_zero = 0, width = -1, prec = -1;
+
+		  cp += 1;
+		  while ((*cp == '-') || (*cp == '+')) {
+			if (*cp == '-') ljust = 1;
+			else plus = 1;
+			cp += 1;
+		  }
+		  if (*cp == '0') {
+			ld_zero = 1;
+			cp += 1;
+		  }
+		  if (isdigit((int)*cp)) width = strtoul(cp, &cp, 10);
+		  if (*cp == '.') {
+			cp += 1;
+			prec = strtoul(cp, &cp, 10);
+		  }
+		  display_prog_add_conv(prog, ljust, plus, ld_zero, width, prec,
+		                        *cp, idx);
+		  if (*cp) cp += 1;
+	    }
+      }
+      free(fmt);
+}
+
+/*
+ * Make the display program for the current call. The skip is the
+ * number of arguments before the items. If format is true, the item
+ * before the items is a $sformat format, which must be a constant
+ * string for there to be a program.
+ */
+static struct display_prog_s*make_display_prog(const char*name,
+                                               unsigned skip, int format)
+{
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      vpiHandle arg;
+      struct display_prog_s*prog;
+      unsigned nargs = 0, idx;
+      s_vpi_value value;
+
+      prog = calloc(1, sizeof(struct display_prog_s));
+      if (argv) {
+	    for (arg = vpi_scan(argv) ;  arg ;  arg = vpi_scan(argv)) {
+		  prog->args = realloc(prog->args, (nargs+1)*sizeof(vpiHandle));
+		  prog->args[nargs] = arg;
+		  nargs += 1;
+	    }
+      }
+      if (nargs < skip || (format && ! is_constant_format(prog->args[skip-1]))) {
+	    free(prog->args);
+	    free(prog);
+	    return 0;
+      }
+
+      prog->info.name = name;
+      prog->info.filename = strdup(vpi_get_str(vpiFile, callh));
+      prog->info.lineno = (int)vpi_get(vpiLineNo, callh);
+      prog->info.default_format = get_default_format(name);
+      prog->info.scope = vpi_handle(vpiScope, callh);
+      assert(prog->info.scope);
+      prog->info.items = prog->args + skip;
+      prog->info.nitems = nargs - skip;
+
+      if (format) {
+	      /* The whole format is one step. */
+	    prog->format = 1;
+	    prog->steps = malloc(sizeof(struct display_step_s));
+	    prog->steps[0].op = 0;
+	    idx = -1;
+	    value.format = vpiStringVal;
+	    vpi_get_value(prog->args[skip-1], &value);
+	    display_prog_add_format(prog, value.value.str, &idx);
+	    prog->steps[0].nops = prog->nops;
+	    prog->steps[0].next = idx+1;
+	    prog->last_idx = idx;
+
+      } else {
+	    prog->steps = malloc(prog->info.nitems*sizeof(struct display_step_s));
+	    for (idx = 0 ;  idx < prog->info.nitems ;  idx += 1) {
+		  vpiHandle item = prog->info.items[idx];
+		  struct display_step_s*step = prog->steps + idx;
+		  step->op = prog->nops;
+		  step->next = 0;
+		  prog->step_op = prog->nops;
+
+		  if (is_constant_format(item)) {
+			unsigned end_idx = idx;
+			value.format = vpiStringVal;
+			vpi_get_value(item, &value);
+			display_prog_add_format(prog, value.value.str, &end_idx);
+			step->next = end_idx + 1;
+
+		  } else if (is_fixed_size_item(item)) {
+			struct display_op_s*op = display_prog_op(prog,
+			                                         DISP_NUMERIC);
+			op->idx = idx;
+			if (prog->info.default_format == vpiDecStrVal)
+			      op->def_width = vpi_get_dec_size(item);
+			step->next = idx + 1;
+		  }
+
+		  step->nops = prog->nops - step->op;
+	    }
+      }
+
+      display_progs = realloc(display_progs, (display_prog_count+1)*
+                                             sizeof(struct display_prog_s*));
+      display_progs[display_prog_count] = prog;
+      display_prog_count += 1;
+      return prog;
+}
+
+static void free_display_prog(struct display_prog_s*prog)
+{
+      free(prog->info.filename);
+      free(prog->args);
+      free(prog->steps);
+      free(prog->ops);
+      free(prog->text);
+      free(prog);
+}
+
+static void run_display_conv_char(const struct display_prog_s*prog,
+                                  const struct display_op_s*op, unsigned idx)
+{
+      get_format_char(&display_buf, op->ljust, op->plus, op->ld_zero,
+                      op->width, op->prec, op->fmt, &prog->info, &idx);
+}
+
+/* This is get_format_char() for a conversion that was checked when
+ * the program was made. */
+static void run_display_conv(const struct display_prog_s*prog,
+                             const struct display_op_s*op)
+{
+      vpiHandle item = prog->info.items[op->idx];
+      s_vpi_value value;
+
+      value.format = get_conv_value_format(op->fmt);
+      vpi_get_value(item, &value);
+      if (value.format == vpiSuppressVal) {
+	    char *fmtb = format_as_string(op->ljust, op->plus, op->ld_zero,
+	                                  op->width, op->prec, op->fmt);
+	    vpi_printf("WARNING: %s:%d: incompatible value for %s%s.\n",
+	               prog->info.filename, prog->info.lineno,
+	               prog->info.name, fmtb);
+	    display_buf_append(&display_buf, fmtb, strlen(fmtb));
+	    free(fmtb);
+	    return;
+      }
+
+      switch (op->fmt) {
+	  case 'c':
+	  case 'C':
+	    format_char(&display_buf, value.value.integer, op->ljust,
+	                op->ld_zero, op->width);
+	    break;
+
+	  case 'd':
+	  case 'D':
+	    format_decimal(&display_buf, value.value.str, op->ljust, op->plus,
+	                   op->ld_zero, op->width, op->def_width, item);
+	    break;
+
+	  case 's':
+	  case 'S':
+	    format_string(&display_buf, value.value.str, op->ljust,
+	                  op->ld_zero, op->width, op->def_width, item);
+	    break;
+
+	  case 'e':
+	  case 'E':
+	  case 'f':
+	  case 'F':
+	  case 'g':
+	  case 'G':
+	    format_real(&display_buf, prog->text + op->text, value.value.real,
+	                op->width, op->prec);
+	    break;
+
+	  default:
+	      /* The binary, octal and hex formats. */
+	    format_radix(&display_buf, value.value.str, op->ljust, op->ld_zero,
+	                 op->width);
+	    break;
+      }
+}
+
+/* This does the same as get_numeric(). */
+static void run_display_numeric(const struct display_prog_s*prog,
+                                const struct display_op_s*op)
+{
+      s_vpi_value val;
+      unsigned len;
+
+      val.format = prog->info.default_format;
+      vpi_get_value(prog->info.items[op->idx], &val);
+      len = strlen(val.value.str);
+      if (prog->info.default_format == vpiDecStrVal)
+	    display_buf_pad(&display_buf, val.value.str, len, op->def_width, 0);
+      else
+	    display_buf_append(&display_buf, val.value.str, len);
+}
+
+static void run_display_ops(const struct display_prog_s*prog,
+                            const struct display_step_s*step)
+{
+      unsigned idx;
+      for (idx = step->op ;  idx < step->op + step->nops ;  idx += 1) {
+	    const struct display_op_s*op = prog->ops + idx;
+	    switch (op->type) {
+		case DISP_TEXT:
+		  display_buf_append(&display_buf, prog->text + op->text, op->len);
+		  break;
+		case DISP_NUMERIC:
+		  run_display_numeric(prog, op);
+		  break;
+		case DISP_CONV:
+		  run_display_conv(prog, op);
+		  break;
+		case DISP_CONV_CHAR:
+		  run_display_conv_char(prog, op, op->idx);
+		  break;
+	    }
+      }
+}
+
+/* Run the program, leaving the result in the display buffer. Like the
+ * result of get_display(), this can have NULL characters in it. */
+static void run_display_prog(const struct display_prog_s*prog)
+{
+      unsigned idx = 0;
+
+      display_buf.len = 0;
+      if (prog->format) {
+	    run_display_ops(prog, prog->steps);
+      } else {
+	    while (idx < prog->info.nitems) {
+		  const struct display_step_s*step = prog->steps + idx;
+		  if (step->next == 0) {
+			char *result;
+			unsigned int cnt = get_display_item(&result, &prog->info,
+			                                    &idx);
+			display_buf_append(&display_buf, result, cnt);
+			free(result);
+			idx += 1;
+		  } else {
+			run_display_ops(prog, step);
+			idx = step->next;
+		  }
+	    }
+      }
+      *display_buf_reserve(&display_buf, 0) = '\0';
+}
+
 #ifdef BR916_STOPGAP_FIX
 static char br916_hint_issued = 0;
 #endif
@@ -1264,6 +1808,15 @@ static PLI_INT32 sys_common_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name, int no_au
 static PLI_INT32 sys_display_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
 	/* These tasks can have automatic variables and are not monitor. */
+      sys_common_compiletf(name, 0, 0);
+      vpi_put_userdata(vpi_handle(vpiSysTfCall, 0),
+                       make_display_prog(name, name[1] == 'f'? 1 : 0, 0));
+      return 0;
+}
+
+/* Check the $info, $warning and $error tasks. */
+static PLI_INT32 sys_severity_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
+{
       return sys_common_compiletf(name, 0, 0);
 }
 
@@ -1273,19 +1826,21 @@ static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
       vpiHandle callh, argv, scope;
       struct strobe_cb_info info;
+      struct display_prog_s*prog;
       char* result;
       unsigned int size;
       PLI_UINT32 fd_mcd;
       s_vpi_value val;
 
       callh = vpi_handle(vpiSysTfCall, 0);
-      argv = vpi_iterate(vpiArgument, callh);
+      prog = vpi_get_userdata(callh);
+      argv = prog? 0 : vpi_iterate(vpiArgument, callh);
 
 	/* Get the file/MC descriptor and verify it is valid. */
       if (name[1] == 'f') {
-	    vpiHandle fd = vpi_scan(argv);
+	    vpiHandle fd = prog? prog->args[0] : vpi_scan(argv);
 	    if (get_fd_mcd_from_arg(&fd_mcd, fd, callh, name)) {
-		  vpi_free_object(argv);
+		  if (argv) vpi_free_object(argv);
 		  return 0;
 	    }
       } else if (strncmp(name, "$sformatf", 9) == 0) {
@@ -1296,6 +1851,23 @@ static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 	    fd_mcd = 1;
       }
 
+	/* The program does the same as get_display(), but the result is
+	 * left in the display buffer, which we can add the newline to. */
+      if (prog) {
+	    run_display_prog(prog);
+	    if (fd_mcd > 0) {
+		  if ((strncmp(name,"$display",8) == 0) ||
+		      (strncmp(name,"$fdisplay",9) == 0))
+			display_buf_append(&display_buf, "\n", 1);
+		  my_mcd_rawwrite(fd_mcd, display_buf.data, display_buf.len);
+	    } else {
+		  val.format = vpiStringVal;
+		  val.value.str = display_buf.data;
+		  vpi_put_value(callh, &val, 0, vpiNoDelay);
+	    }
+	    return 0;
+      }
+
       scope = vpi_handle(vpiScope, callh);
       assert(scope);
 	/* We could use vpi_get_str(vpiName, callh) to get the task name,
@@ -1621,6 +2193,7 @@ static PLI_INT32 sys_swrite_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   }
 
   if (sys_check_args(callh, argv, name, 0, 0)) vpi_control(vpiFinish, 1);
+  vpi_put_userdata(callh, make_display_prog(name, 1, 0));
   return 0;
 }
 
@@ -1628,10 +2201,25 @@ static PLI_INT32 sys_swrite_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
   vpiHandle callh, argv, reg, scope;
   struct strobe_cb_info info;
+  struct display_prog_s *prog;
   s_vpi_value val;
   unsigned int size;
 
   callh = vpi_handle(vpiSysTfCall, 0);
+  prog = vpi_get_userdata(callh);
+  if (prog) {
+    run_display_prog(prog);
+    val.value.str = display_buf.data;
+    val.format = vpiStringVal;
+    vpi_put_value(prog->args[0], &val, 0, vpiNoDelay);
+    if (display_buf.len != strlen(display_buf.data)) {
+      vpi_printf("WARNING: %s:%d: %s returned a value with an embedded NULL "
+                 "(see %%u/%%z).\n", prog->info.filename, prog->info.lineno,
+                 name);
+    }
+    return 0;
+  }
+
   argv = vpi_iterate(vpiArgument, callh);
   reg = vpi_scan(argv);
 
@@ -1710,6 +2298,7 @@ static PLI_INT32 sys_sformat_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   }
 
   if (sys_check_args(callh, argv, name, 0, 0)) vpi_control(vpiFinish, 1);
+  vpi_put_userdata(callh, make_display_prog(name, 2, 1));
   return 0;
 }
 
@@ -1717,11 +2306,31 @@ static PLI_INT32 sys_sformat_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
   vpiHandle callh, argv, reg, scope;
   struct strobe_cb_info info;
+  struct display_prog_s *prog;
   s_vpi_value val;
   char *result, *fmt;
   unsigned int idx, size;
 
   callh = vpi_handle(vpiSysTfCall, 0);
+  prog = vpi_get_userdata(callh);
+  if (prog) {
+    run_display_prog(prog);
+    if (prog->last_idx+1 < prog->info.nitems) {
+      vpi_printf("WARNING: %s:%d: %s has %d extra argument(s).\n",
+                 prog->info.filename, prog->info.lineno, name,
+                 prog->info.nitems-prog->last_idx-1);
+    }
+    val.value.str = display_buf.data;
+    val.format = vpiStringVal;
+    vpi_put_value(prog->args[0], &val, 0, vpiNoDelay);
+    if (display_buf.len != strlen(display_buf.data)) {
+      vpi_printf("WARNING: %s:%d: %s returned a value with an embedded NULL "
+                 "(see %%u/%%z).\n", prog->info.filename, prog->info.lineno,
+                 name);
+    }
+    return 0;
+  }
+
   argv = vpi_iterate(vpiArgument, callh);
   reg = vpi_scan(argv);
   val.format = vpiStringVal;
@@ -1799,6 +2408,7 @@ static PLI_INT32 sys_sformatf_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   }
 
   if (sys_check_args(callh, argv, name, 0, 0)) vpi_control(vpiFinish, 1);
+  vpi_put_userdata(callh, make_display_prog(name, 0, 0));
   return 0;
 }
 
@@ -2137,6 +2747,8 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 static PLI_INT32 sys_end_of_simulation(p_cb_data cb_data)
 {
+      unsigned idx;
+
       (void)cb_data; /* Parameter is not used. */
       free(monitor_callbacks);
       monitor_callbacks = 0;
@@ -2148,6 +2760,15 @@ static PLI_INT32 sys_end_of_simulation(p_cb_data cb_data)
 
       free(timeformat_info.suff);
       timeformat_info.suff = 0;
+
+      for (idx = 0 ;  idx < display_prog_count ;  idx += 1)
+	    free_display_prog(display_progs[idx]);
+      free(display_progs);
+      display_progs = 0;
+      display_prog_count = 0;
+      free(display_buf.data);
+      display_buf.data = 0;
+      display_buf.size = 0;
       return 0;
 }
 
@@ -2524,7 +3145,7 @@ void sys_display_register(void)
       tf_data.type      = vpiSysTask;
       tf_data.tfname    = "$error";
       tf_data.calltf    = sys_severity_calltf;
-      tf_data.compiletf = sys_display_compiletf;
+      tf_data.compiletf = sys_severity_compiletf;
       tf_data.sizetf    = 0;
       tf_data.user_data = "$error";
       res = vpi_register_systf(&tf_data);
@@ -2533,7 +3154,7 @@ void sys_display_register(void)
       tf_data.type      = vpiSysTask;
       tf_data.tfname    = "$warning";
       tf_data.calltf    = sys_severity_calltf;
-      tf_data.compiletf = sys_display_compiletf;
+      tf_data.compiletf = sys_severity_compiletf;
       tf_data.sizetf    = 0;
       tf_data.user_data = "$warning";
       res = vpi_register_systf(&tf_data);
@@ -2542,7 +3163,7 @@ void sys_display_register(void)
       tf_data.type      = vpiSysTask;
       tf_data.tfname    = "$info";
       tf_data.calltf    = sys_severity_calltf;
-      tf_data.compiletf = sys_display_compiletf;
+      tf_data.compiletf = sys_severity_compiletf;
       tf_data.sizetf    = 0;
       tf_data.user_data = "$info";
       res = vpi_register_systf(&tf_data);
@@ -261,7 +261,7 @@ static PLI_INT32 sys_fflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 	/* If we have no argument then flush all the streams. */
       if (argv == 0) {
-	    fflush(NULL);
+	    vpip_mcd_flush_all();
 	    return 0;
       }
 
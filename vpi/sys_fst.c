@@ -64,6 +64,15 @@ static enum lxm_optimum_mode_e {
       LXM_BOTH = 3
 } lxm_optimum_mode = LXM_NONE;
 
+/*
+ * These are set by the -fst-parallel, -fst-block=<MB> and
+ * -fst-pack=<method> extended arguments. A pack type of -1 leaves the
+ * choice to the optimum mode above.
+ */
+static int fst_parallel = 0;
+static uint64_t fst_block_size = 0;
+static int fst_pack_type = -1;
+
 static const char*units_names[] = {
       "s",
       "ms",
@@ -403,10 +412,17 @@ static void open_dumpfile(vpiHandle callh)
 	    sprintf(scale_buf, "\t%u%s\n", scale, units_names[udx]);
 	    fstWriterSetTimescaleFromString(dump_file, scale_buf);
 	      /* Set the faster dump type when requested. */
-	    if ((lxm_optimum_mode == LXM_SPEED) ||
-	        (lxm_optimum_mode == LXM_BOTH)) {
-		  fstWriterSetPackType(dump_file, 1);
+	    if (fst_pack_type >= 0) {
+		  fstWriterSetPackType(dump_file, fst_pack_type);
+	    } else if ((lxm_optimum_mode == LXM_SPEED) ||
+	               (lxm_optimum_mode == LXM_BOTH)) {
+		  fstWriterSetPackType(dump_file, FST_WR_PT_FASTLZ);
 	    }
+	    if (fst_block_size)
+		  fstWriterSetBreakSize(dump_file, fst_block_size);
+	      /* Compress and write the blocks in a separate thread. */
+	    if (fst_parallel)
+		  fstWriterSetParallelMode(dump_file, 1);
 	      /* Set the most effective compression when requested. */
 	    if ((lxm_optimum_mode == LXM_SPACE) ||
 	        (lxm_optimum_mode == LXM_BOTH)) {
@@ -915,6 +931,38 @@ void sys_fst_register(void)
 		  lxm_optimum_mode = LXM_BOTH;
 	    } else if (strcmp(vlog_info.argv[idx],"-fst-speed-space") == 0) {
 		  lxm_optimum_mode = LXM_BOTH;
+
+	    } else if (strcmp(vlog_info.argv[idx],"-fst-parallel") == 0) {
+#ifdef HAVE_LIBPTHREAD
+		  fst_parallel = 1;
+#else
+		  vpi_printf("FST warning: -fst-parallel is not supported "
+		             "on this system.\n");
+#endif
+
+	    } else if (strncmp(vlog_info.argv[idx],"-fst-block=",11) == 0) {
+		  const char*arg = vlog_info.argv[idx] + 11;
+		  char*end;
+		  unsigned long mb = strtoul(arg, &end, 10);
+		  if (*arg == 0 || *end != 0 || mb == 0) {
+			vpi_printf("FST warning: ignoring invalid block size "
+			           "\"%s\".\n", arg);
+		  } else {
+			fst_block_size = (uint64_t)mb << 20;
+		  }
+
+	    } else if (strncmp(vlog_info.argv[idx],"-fst-pack=",10) == 0) {
+		  const char*arg = vlog_info.argv[idx] + 10;
+		  if (strcmp(arg, "zlib") == 0) {
+			fst_pack_type = FST_WR_PT_ZLIB;
+		  } else if (strcmp(arg, "fastlz") == 0) {
+			fst_pack_type = FST_WR_PT_FASTLZ;
+		  } else if (strcmp(arg, "lz4") == 0) {
+			fst_pack_type = FST_WR_PT_LZ4;
+		  } else {
+			vpi_printf("FST warning: ignoring unknown pack method "
+			           "\"%s\".\n", arg);
+		  }
 	    }
       }
 
@@ -859,6 +859,8 @@ static void* lxt2_thread(void*arg)
 
 	    switch (cell->type) {
 		case WT_NONE:
+		case WT_EMIT_VEC:
+		case WT_EMIT_VEC_PTR:
 		  break;
 		case WT_FLUSH:
 		  lxt2_wr_flush(dump_file);
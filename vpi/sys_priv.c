@@ -261,7 +261,9 @@ unsigned is_valid_fd_mcd(PLI_UINT32 fd_mcd)
       if (IS_MCD(fd_mcd)){
 	    if (vpi_mcd_printf(fd_mcd, "%s", "") == EOF) return 0;
       } else {
-	    if (vpi_get_file(fd_mcd) == NULL) return 0;
+	      /* This does not need the FILE*, so do not make the
+		 simulator write out any output it holds for the file. */
+	    if (vpi_mcd_name(fd_mcd) == NULL) return 0;
       }
 
       return 1;
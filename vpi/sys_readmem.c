@@ -25,6 +25,9 @@
 # include  <assert.h>
 # include  "sys_readmem_lex.h"
 # include  <sys/stat.h>
+#if !defined(__MINGW32__)
+# include  <sys/mman.h>
+#endif
 # include  "ivl_alloc.h"
 
 char **search_list = NULL;
@@ -83,6 +86,49 @@ static void get_mem_params(vpiHandle argv, vpiHandle callh, const char *name,
       }
 }
 
+/*
+ * Get the whole memory file into memory so that it can be scanned
+ * directly, without going through the lexor one token at a time. On
+ * most systems the file is mapped. Return 0 if the file is not a
+ * regular file (a pipe, for example) or cannot be mapped. The caller
+ * then reads it with the lexor as usual.
+ */
+static char* map_mem_file(FILE*file, size_t*len)
+{
+      struct stat sb;
+      char*buf;
+
+      if (fstat(fileno(file), &sb) != 0 || ! S_ISREG(sb.st_mode))
+	    return 0;
+      if (sb.st_size <= 0 || (off_t)(size_t)sb.st_size != sb.st_size)
+	    return 0;
+      *len = sb.st_size;
+
+#if defined(__MINGW32__)
+      buf = malloc(*len);
+      if (fread(buf, 1, *len, file) != *len) {
+	    free(buf);
+	    rewind(file);
+	    return 0;
+      }
+#else
+      buf = mmap(0, *len, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+      if (buf == MAP_FAILED)
+	    return 0;
+#endif
+      return buf;
+}
+
+static void unmap_mem_file(char*buf, size_t len)
+{
+#if defined(__MINGW32__)
+      (void)len; /* Parameter is not used. */
+      free(buf);
+#else
+      munmap(buf, len);
+#endif
+}
+
 static int process_params(vpiHandle mitem,
                           vpiHandle start_item, vpiHandle stop_item,
                           vpiHandle callh, const char *name,
@@ -260,9 +306,11 @@ static PLI_INT32 sys_mem_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
-      int code, wwid, addr;
+      int code, wwid, addr, bin_flag;
       FILE*file;
       char *fname = 0;
+      char *buf;
+      size_t buf_len = 0;
       s_vpi_value value;
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
       vpiHandle argv = vpi_iterate(vpiArgument, callh);
@@ -330,17 +378,22 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       value.format = vpiVectorVal;
       value.value.vector = calloc((wwid+31)/32, sizeof(s_vpi_vecval));
 
-      /* Configure the readmem lexer */
-      if (strcmp(name,"$readmemb") == 0)
-	    sys_readmem_start_file(callh, file, 1, wwid, value.value.vector);
+      /* Configure the readmem scanner. Scan the file directly if it
+	 can be mapped, otherwise use the lexer. */
+      bin_flag = strcmp(name,"$readmemb") == 0;
+      buf = map_mem_file(file, &buf_len);
+      if (buf)
+	    sys_readmem_start_buffer(callh, buf, buf_len, bin_flag, wwid,
+				     value.value.vector);
       else
-	    sys_readmem_start_file(callh, file, 0, wwid, value.value.vector);
+	    sys_readmem_start_file(callh, file, bin_flag, wwid,
+				   value.value.vector);
 
       /*======================================== Read memory file */
 
       /* Run through the input file and store the new contents in the memory */
       addr = start_addr;
-      while ((code = readmemlex()) != 0) {
+      while ((code = sys_readmem_scan()) != 0) {
 	  switch (code) {
 	  case MEM_ADDRESS:
 	      addr = value.value.vector->aval;
@@ -403,6 +456,7 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       }
 
  bailout:
+      if (buf) unmap_mem_file(buf, buf_len);
       free(value.value.vector);
       free(fname);
       fclose(file);
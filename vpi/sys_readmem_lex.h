@@ -32,6 +32,16 @@ extern void sys_readmem_start_file(vpiHandle callh, FILE*in, int bin_flag,
 				   unsigned width, struct t_vpi_vecval*val);
 extern int readmemlex(void);
 
+/*
+ * Scan a file that has been loaded into memory, instead of reading it
+ * through the lexor. The sys_readmem_scan() function returns the next
+ * token from the buffer, if there is one, or from the lexor.
+ */
+extern void sys_readmem_start_buffer(vpiHandle callh, const char*buf,
+				     size_t len, int bin_flag,
+				     unsigned width, struct t_vpi_vecval*val);
+extern int sys_readmem_scan(void);
+
 extern void destroy_readmem_lexor(void);
 
 #endif /* IVL_sys_readmem_lex_H */
@@ -98,6 +98,9 @@ static void sys_lxt_or_vcd_register(void)
 	    } else if (strcmp(vlog_info.argv[idx],"-fst-speed-space") == 0) {
 		  dumper = "fst";
 
+	    } else if (strcmp(vlog_info.argv[idx],"-fst-parallel") == 0) {
+		  dumper = "fst";
+
 	    } else if (strcmp(vlog_info.argv[idx],"-fst-none") == 0) {
 		  dumper = "none";
 
@@ -140,6 +143,9 @@ static void sys_lxt_or_vcd_register(void)
 	    } else if (strcmp(vlog_info.argv[idx],"-vcd") == 0) {
 		  dumper = "vcd";
 
+	    } else if (strcmp(vlog_info.argv[idx],"-vcd-parallel") == 0) {
+		  dumper = "vcd";
+
 	    } else if (strcmp(vlog_info.argv[idx],"-vcd-off") == 0) {
 		  dumper = "none";
 
@@ -44,6 +44,8 @@ struct vcd_info {
       struct vcd_info *next;
       struct vcd_info *dmp_next;
       int scheduled;
+      PLI_INT32 type;
+      unsigned size;
 };
 
 
@@ -55,6 +57,22 @@ static long dump_limit = 0;
 static int dump_is_full = 0;
 static int finish_status = 0;
 
+/*
+ * With the -vcd-parallel extended argument the value changes are
+ * captured as raw vectors and passed to a work thread, which formats
+ * them and writes the dump file. The work queue is bounded, so the
+ * simulation waits if the work thread falls too far behind. Anything
+ * that the simulation writes to the dump file directly must first
+ * wait for the work thread to drain the queue.
+ */
+static int vcd_parallel = 0;
+static int vcd_thread_running = 0;
+
+static void vcd_sync(void)
+{
+      if (vcd_thread_running) vcd_work_sync();
+}
+
 
 static const char*units_names[] = {
       "s",
@@ -104,15 +122,14 @@ static char *truncate_bitvec(char *s)
 static void show_this_item(struct vcd_info*info)
 {
       s_vpi_value value;
-      PLI_INT32 type = vpi_get(vpiType, info->item);
 
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
 	    fprintf(dump_file, "r%.16g %s\n", value.value.real, info->ident);
-      } else if (type == vpiNamedEvent) {
+      } else if (info->type == vpiNamedEvent) {
 	    fprintf(dump_file, "1%s\n", info->ident);
-      } else if (vpi_get(vpiSize, info->item) == 1) {
+      } else if (info->size == 1) {
 	    value.format = vpiBinStrVal;
 	    vpi_get_value(info->item, &value);
 	    fprintf(dump_file, "%s%s\n", value.value.str, info->ident);
@@ -127,14 +144,12 @@ static void show_this_item(struct vcd_info*info)
 /* Dump values for a $dumpoff. */
 static void show_this_item_x(struct vcd_info*info)
 {
-      PLI_INT32 type = vpi_get(vpiType, info->item);
-
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	      /* Some tools dump nothing here...? */
 	    fprintf(dump_file, "rNaN %s\n", info->ident);
-      } else if (type == vpiNamedEvent) {
+      } else if (info->type == vpiNamedEvent) {
 	    /* Do nothing for named events. */
-      } else if (vpi_get(vpiSize, info->item) == 1) {
+      } else if (info->size == 1) {
 	    fprintf(dump_file, "x%s\n", info->ident);
       } else {
 	    fprintf(dump_file, "bx %s\n", info->ident);
@@ -142,6 +157,109 @@ static void show_this_item_x(struct vcd_info*info)
 }
 
 
+/*
+ * Send the current value of the item to the work thread. This is the
+ * parallel version of show_this_item.
+ */
+static void emit_this_item(struct vcd_info*info)
+{
+      s_vpi_value value;
+
+      if (info->type == vpiRealVar) {
+	    value.format = vpiRealVal;
+	    vpi_get_value(info->item, &value);
+	    vcd_work_emit_real(info, value.value.real);
+      } else if (info->type == vpiNamedEvent) {
+	    s_vpi_vecval one = { 1, 0 };
+	    vcd_work_emit_vec(info, 1, &one);
+      } else {
+	    value.format = vpiVectorVal;
+	    vpi_get_value(info->item, &value);
+	    vcd_work_emit_vec(info, (info->size+31)/32, value.value.vector);
+      }
+}
+
+static void show_time(PLI_UINT64 now)
+{
+      if (now != vcd_cur_time) {
+	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
+	    vcd_cur_time = now;
+      }
+}
+
+/*
+ * The work thread formats a vector value the way vpiBinStrVal does.
+ */
+static void show_this_vec(struct vcd_info*info, const s_vpi_vecval*val)
+{
+      static char*buf = 0;
+      static unsigned buf_size = 0;
+      unsigned idx;
+
+      if (info->type == vpiNamedEvent) {
+	    fprintf(dump_file, "1%s\n", info->ident);
+	    return;
+      }
+
+      if (info->size+1 > buf_size) {
+	    buf_size = info->size + 1;
+	    buf = realloc(buf, buf_size);
+      }
+
+      for (idx = 0 ;  idx < info->size ;  idx += 1) {
+	    unsigned bit = info->size - idx - 1;
+	    PLI_UINT32 mask = 1U << (bit % 32);
+	    int aval = (val[bit/32].aval & mask) != 0;
+	    int bval = (val[bit/32].bval & mask) != 0;
+	    buf[idx] = "01zx"[aval | bval<<1];
+      }
+      buf[info->size] = 0;
+
+      if (info->size == 1)
+	    fprintf(dump_file, "%s%s\n", buf, info->ident);
+      else
+	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(buf), info->ident);
+}
+
+static void* vcd_thread(void*arg)
+{
+      int run_flag = 1;
+
+      (void)arg; /* Parameter is not used. */
+
+      while (run_flag) {
+	    struct vcd_work_item_s*cell = vcd_work_thread_peek();
+
+	    switch (cell->type) {
+		case WT_EMIT_DOUBLE:
+		  show_time(cell->time);
+		  fprintf(dump_file, "r%.16g %s\n", cell->op_.val_double,
+			  cell->sym_.vcd->ident);
+		  break;
+		case WT_EMIT_VEC:
+		  show_time(cell->time);
+		  show_this_vec(cell->sym_.vcd, &cell->op_.val_vec);
+		  break;
+		case WT_EMIT_VEC_PTR:
+		  show_time(cell->time);
+		  show_this_vec(cell->sym_.vcd, cell->op_.val_vecp);
+		  break;
+		case WT_FLUSH:
+		  fflush(dump_file);
+		  break;
+		case WT_TERMINATE:
+		  run_flag = 0;
+		  break;
+		default:
+		  break;
+	    }
+
+	    vcd_work_thread_pop();
+      }
+
+      return 0;
+}
+
 /*
  * managed qsorted list of scope names/variables for duplicates bsearching
  */
@@ -182,11 +300,19 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       struct vcd_info* info = vcd_dmp_list;
       PLI_UINT64 now = timerec_to_time64(cause->time);
 
-      if (now != vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
-	    vcd_cur_time = now;
+      if (vcd_thread_running) {
+	    vcd_work_set_time(now);
+	    do {
+		  emit_this_item(info);
+		  info->scheduled = 0;
+	    } while ((info = info->dmp_next) != 0);
+
+	    vcd_dmp_list = 0;
+	    return 0;
       }
 
+      show_time(now);
+
       do {
            show_this_item(info);
            info->scheduled = 0;
@@ -209,6 +335,7 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
 
       if ((dump_limit > 0) && (ftell(dump_file) > dump_limit)) {
             dump_is_full = 1;
+            vcd_sync();
             vpi_printf("WARNING: Dump file limit (%ld bytes) "
                                "exceeded.\n", dump_limit);
             fprintf(dump_file, "$comment Dump file limit (%ld bytes) "
@@ -249,6 +376,11 @@ static PLI_INT32 dumpvars_cb(p_cb_data cause)
 	    fprintf(dump_file, "$end\n");
       }
 
+      if (vcd_parallel) {
+	    vcd_work_start(vcd_thread, 0);
+	    vcd_thread_running = 1;
+      }
+
       return 0;
 }
 
@@ -260,6 +392,11 @@ static PLI_INT32 finish_cb(p_cb_data cause)
 
       finish_status = 1;
 
+      if (vcd_thread_running) {
+	    vcd_work_terminate();
+	    vcd_thread_running = 0;
+      }
+
       dumpvars_time = timerec_to_time64(cause->time);
 
       if (!dump_is_off && !dump_is_full && dumpvars_time != vcd_cur_time) {
@@ -331,6 +468,7 @@ static PLI_INT32 sys_dumpoff_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
 
+      vcd_sync();
       if (now64 > vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
@@ -361,6 +499,7 @@ static PLI_INT32 sys_dumpon_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
 
+      vcd_sync();
       if (now64 > vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
@@ -388,6 +527,7 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
 
+      vcd_sync();
       if (now64 > vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
@@ -485,6 +625,9 @@ static PLI_INT32 sys_dumpfile_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 static PLI_INT32 sys_dumpflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       (void)name; /* Parameter is not used. */
+	/* Wait for the work thread to write out the queued changes, so
+	   that the file is complete when $dumpflush returns. */
+      vcd_sync();
       if (dump_file) fflush(dump_file);
 
       return 0;
@@ -645,6 +788,8 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->item  = item;
 		  info->ident = ident;
 		  info->scheduled = 0;
+		  info->type  = vpi_get(vpiType, item);
+		  info->size  = vpi_get(vpiSize, item);
 
 		  cb.time      = &info->time;
 		  cb.user_data = (char*)info;
@@ -871,9 +1016,19 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 void sys_vcd_register(void)
 {
+      int idx;
+      struct t_vpi_vlog_info vlog_info;
       s_vpi_systf_data tf_data;
       vpiHandle res;
 
+	/* Scan the extended arguments, looking for vcd options. */
+      vpi_get_vlog_info(&vlog_info);
+
+      for (idx = 0 ;  idx < vlog_info.argc ;  idx += 1) {
+	    if (strcmp(vlog_info.argv[idx],"-vcd-parallel") == 0)
+		  vcd_parallel = 1;
+      }
+
       /* All the compiletf routines are located in vcd_priv.c. */
 
       tf_data.type      = vpiSysTask;
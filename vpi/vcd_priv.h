@@ -71,6 +71,8 @@ typedef enum vcd_work_item_type_e {
       WT_NONE,
       WT_EMIT_BITS,
       WT_EMIT_DOUBLE,
+      WT_EMIT_VEC,
+      WT_EMIT_VEC_PTR,
       WT_DUMPON,
       WT_DUMPOFF,
       WT_FLUSH,
@@ -78,17 +80,21 @@ typedef enum vcd_work_item_type_e {
 } vcd_work_item_type_t;
 
 struct lxt2_wr_symbol;
+struct vcd_info;
 
 struct vcd_work_item_s {
       vcd_work_item_type_t type;
       uint64_t time;
       union {
 	    struct lxt2_wr_symbol*lxt2;
+	    struct vcd_info*vcd;
       } sym_;
 
       union {
 	    double val_double;
 	    char*val_char;
+	    s_vpi_vecval val_vec;
+	    s_vpi_vecval*val_vecp;
       } op_;
 };
 
@@ -126,6 +132,15 @@ EXTERN void vcd_work_dumpoff(void);
 EXTERN void vcd_work_emit_double(struct lxt2_wr_symbol*sym, double val);
 EXTERN void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char*bits);
 
+/*
+ * These send raw values to the work thread of the VCD dumper, which
+ * formats them. A vector value is passed as the array of words that
+ * vpi_get_value returns for vpiVectorVal, and is copied.
+ */
+EXTERN void vcd_work_emit_real(struct vcd_info*info, double val);
+EXTERN void vcd_work_emit_vec(struct vcd_info*info, unsigned words,
+			      const s_vpi_vecval*val);
+
 /* The compiletf routines are common for the VCD, LXT and LXT2 dumpers. */
 EXTERN PLI_INT32 sys_dumpvars_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name);
 
@@ -128,6 +128,8 @@ extern "C" void vcd_work_thread_pop(void)
       struct vcd_work_item_s*cell = work_queue + use_next;
       if (cell->type == WT_EMIT_BITS) {
 	    free(cell->op_.val_char);
+      } else if (cell->type == WT_EMIT_VEC_PTR) {
+	    free(cell->op_.val_vecp);
       }
 
       use_next += 1;
@@ -276,6 +278,35 @@ extern "C" void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char* val)
       unlock_item();
 }
 
+extern "C" void vcd_work_emit_real(struct vcd_info*info, double val)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->type = WT_EMIT_DOUBLE;
+      cell->sym_.vcd = info;
+      cell->op_.val_double = val;
+      unlock_item();
+}
+
+/*
+ * Values up to 32 bits fit in the work item. Wider values are copied
+ * to the heap, and freed when the item is popped.
+ */
+extern "C" void vcd_work_emit_vec(struct vcd_info*info, unsigned words,
+				  const s_vpi_vecval*val)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->sym_.vcd = info;
+      if (words == 1) {
+	    cell->type = WT_EMIT_VEC;
+	    cell->op_.val_vec = val[0];
+      } else {
+	    cell->type = WT_EMIT_VEC_PTR;
+	    cell->op_.val_vecp = (s_vpi_vecval*)malloc(words*sizeof(s_vpi_vecval));
+	    memcpy(cell->op_.val_vecp, val, words*sizeof(s_vpi_vecval));
+      }
+      unlock_item();
+}
+
 extern "C" void vcd_work_terminate(void)
 {
       struct vcd_work_item_s*cell = grab_item();
@@ -124,6 +124,12 @@ void        vpip_format_strength(char*, s_vpi_value*, unsigned) { }
 void        vpip_make_systf_system_defined(vpiHandle) { }
 void        vpip_mcd_rawwrite(PLI_UINT32, const char*, size_t) { }
 void        vpip_set_return_value(int) { }
+vpipBatch   vpip_batch_create(vpiHandle*, unsigned) { return 0; }
+unsigned    vpip_batch_size(vpipBatch) { return 0; }
+void        vpip_batch_get(vpipBatch, s_vpi_vecval*, PLI_UINT32*) { }
+void        vpip_batch_put(vpipBatch, const s_vpi_vecval*, const PLI_UINT32*) { }
+void        vpip_batch_free(vpipBatch) { }
+void        vpip_mcd_flush_all(void) { }
 void        vpi_vcontrol(PLI_INT32, va_list) { }
 
 
@@ -225,6 +231,12 @@ vpip_routines_s vpi_routines = {
     .make_systf_system_defined  = vpip_make_systf_system_defined,
     .mcd_rawwrite               = vpip_mcd_rawwrite,
     .set_return_value           = vpip_set_return_value,
+    .batch_create               = vpip_batch_create,
+    .batch_size                 = vpip_batch_size,
+    .batch_get                  = vpip_batch_get,
+    .batch_put                  = vpip_batch_put,
+    .batch_free                 = vpip_batch_free,
+    .mcd_flush_all              = vpip_mcd_flush_all,
 };
 
 typedef PLI_UINT32 (*vpip_set_callback_t)(vpip_routines_s*, PLI_UINT32);
@@ -644,10 +644,14 @@ extern void vpip_set_return_value(int value);
 extern s_vpi_vecval vpip_calc_clog2(vpiHandle arg);
 extern void vpip_make_systf_system_defined(vpiHandle ref);
 
-  /* Perform fwrite to mcd files. This is used to write raw data,
-     which may include nulls. */
+  /* Perform fwrite to mcd or fd files. This is used to write raw
+     data, which may include nulls. */
 extern void vpip_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t count);
 
+  /* Flush all the mcd and fd files, including any output that the
+     simulator has not yet handed to the C library. */
+extern void vpip_mcd_flush_all(void);
+
   /* Return driver information for a net bit. The information is returned
      in the 'counts' array as follows:
        counts[0] - number of drivers driving '0' onto the net
@@ -659,6 +663,37 @@ extern void vpip_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t count);
 extern void vpip_count_drivers(vpiHandle ref, unsigned idx,
                                unsigned counts[4]);
 
+  /* Read and write the values of many vector signals in one call,
+     without going through vpi_get_value/vpi_put_value for each of
+     them. The vpip_batch_create function takes a list of handles to
+     vector nets or variables (not bit selects or array words) and
+     returns a batch, or nil if any of the handles cannot be used.
+
+     The values are passed in a packed array of s_vpi_vecval. Each
+     signal in the list takes (width+31)/32 elements, least
+     significant first, right after the elements of the signal before
+     it. The vpip_batch_size function returns the total number of
+     elements in the array.
+
+     The vpip_batch_get function reads all the values into the array.
+     If the changed argument is not nil, it points to (count+31)/32
+     words, and the bit idx%32 of word idx/32 is set if the value of
+     signal idx changed since the last vpip_batch_get of the batch, or
+     cleared if it did not. The first vpip_batch_get sets all the bits.
+
+     The vpip_batch_put function writes the values in the array to the
+     signals, like vpi_put_value with vpiNoDelay. If the mask argument
+     is not nil, it has the same layout as the changed bits, and only
+     the signals with their bit set are written. */
+typedef struct __vpipBatch *vpipBatch;
+extern vpipBatch vpip_batch_create(vpiHandle*list, unsigned count);
+extern unsigned vpip_batch_size(vpipBatch batch);
+extern void vpip_batch_get(vpipBatch batch, s_vpi_vecval*buf,
+                           PLI_UINT32*changed);
+extern void vpip_batch_put(vpipBatch batch, const s_vpi_vecval*buf,
+                           const PLI_UINT32*mask);
+extern void vpip_batch_free(vpipBatch batch);
+
 /*
  * Stopgap fix for br916. We need to reject any attempt to pass a thread
  * variable to $strobe or $monitor. To do this, we use some private VPI
@@ -688,7 +723,7 @@ extern void vpip_count_drivers(vpiHandle ref, unsigned idx,
  */
 
 // Increment the version number any time vpip_routines_s is changed.
-static const PLI_UINT32 vpip_routines_version = 1;
+static const PLI_UINT32 vpip_routines_version = 3;
 
 typedef struct {
     vpiHandle   (*register_cb)(p_cb_data);
@@ -729,6 +764,12 @@ typedef struct {
     void        (*make_systf_system_defined)(vpiHandle);
     void        (*mcd_rawwrite)(PLI_UINT32, const char*, size_t);
     void        (*set_return_value)(int);
+    vpipBatch   (*batch_create)(vpiHandle*, unsigned);
+    unsigned    (*batch_size)(vpipBatch);
+    void        (*batch_get)(vpipBatch, s_vpi_vecval*, PLI_UINT32*);
+    void        (*batch_put)(vpipBatch, const s_vpi_vecval*, const PLI_UINT32*);
+    void        (*batch_free)(vpipBatch);
+    void        (*mcd_flush_all)(void);
 } vpip_routines_s;
 
 extern DLLEXPORT PLI_UINT32 vpip_set_callback(vpip_routines_s*routines, PLI_UINT32 version);
@@ -261,9 +261,7 @@ vpiHandle __vpiArray::get_iter_index(struct __vpiArrayIterator*, int idx)
 
       assert(vals4 || vals);
 
-      if (vals_words == 0) make_vals_words();
-
-      return &(vals_words[idx].as_word);
+      return &(get_vals_word(idx)->as_word);
 }
 
 int __vpiArray::vpi_get(int code)
@@ -329,10 +327,7 @@ vpiHandle __vpiArray::vpi_index(int index)
 	    return nets[index];
       }
 
-      if (vals_words == 0)
-	    make_vals_words();
-
-      return &(vals_words[index].as_word);
+      return &(get_vals_word(index)->as_word);
 }
 
 int __vpiArrayWord::as_word_t::vpi_get(int code)
@@ -920,7 +915,9 @@ void compile_var2_array(char*label, char*name, int last, int first,
       arr->vals_width = labs(msb-lsb) + 1;
 
       assert(! arr->nets);
-      if (lsb == 0 && msb == 7 && signed_flag) {
+      if (sparse_array_words && arr->get_size() >= sparse_array_words) {
+	    arr->vals = new vvp_darray_sparse_vec2(arr->get_size(), arr->vals_width);
+      } else if (lsb == 0 && msb == 7 && signed_flag) {
 	    arr->vals = new vvp_darray_atom<int8_t>(arr->get_size());
       } else if (lsb == 0 && msb == 7 && !signed_flag) {
 	    arr->vals = new vvp_darray_atom<uint8_t>(arr->get_size());
@@ -1546,6 +1543,7 @@ void compile_array_alias(char*label, char*name, char*src)
       obj->vals  = mem->vals;
       obj->vals_width = mem->vals_width;
       obj->vals_words = mem->vals_words;
+      obj->vals_word_pages = mem->vals_word_pages;
 
       obj->ports_ = 0;
       obj->vpi_callbacks = 0;
@@ -1650,7 +1648,7 @@ void compile_array_cleanup(void)
 void memory_delete(vpiHandle item)
 {
       struct __vpiArray*arr = (struct __vpiArray*) item;
-      if (arr->vals_words) delete [] (arr->vals_words-1);
+      arr->delete_vals_words();
 
 //      if (arr->vals4) {}
 // Delete the individual words?
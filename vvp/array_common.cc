@@ -37,20 +37,45 @@ vpiHandle __vpiArrayBase::vpi_array_base_iterate(int code)
     return 0;
 }
 
-void __vpiArrayBase::make_vals_words()
+struct __vpiArrayWord* __vpiArrayBase::get_vals_word(unsigned idx)
 {
-    assert(vals_words == 0);
-    vals_words = new struct __vpiArrayWord[get_size() + 1];
-
-    // Make word[-1] point to the parent.
-    vals_words->parent = this;
-    // Now point to word-0
-    vals_words += 1;
+    const unsigned PAGE_WORDS = __vpiArrayWordPage::PAGE_WORDS;
+    unsigned pdx = idx / PAGE_WORDS;
+
+    // Make (or grow, if this is a dynamic array that has grown) the
+    // table of pages.
+    if (pdx >= vals_word_pages) {
+	  unsigned npages = get_size() / PAGE_WORDS + 1;
+	  if (npages <= pdx)
+		npages = pdx + 1;
+	  struct __vpiArrayWordPage**tmp = new struct __vpiArrayWordPage*[npages];
+	  for (unsigned cnt = 0 ; cnt < npages ; cnt += 1)
+		tmp[cnt] = cnt < vals_word_pages? vals_words[cnt] : 0;
+	  delete[]vals_words;
+	  vals_words = tmp;
+	  vals_word_pages = npages;
+    }
 
-    struct __vpiArrayWord*words = vals_words;
-    for (unsigned idx = 0 ; idx < get_size() ; idx += 1) {
-            words[idx].word0 = words;
+    struct __vpiArrayWordPage*page = vals_words[pdx];
+    if (page == 0) {
+	  page = new struct __vpiArrayWordPage;
+	  page->parent = this;
+	  page->base = pdx * PAGE_WORDS;
+	  for (unsigned cnt = 0 ; cnt < PAGE_WORDS ; cnt += 1)
+		page->words[cnt].page = page;
+	  vals_words[pdx] = page;
     }
+
+    return &page->words[idx % PAGE_WORDS];
+}
+
+void __vpiArrayBase::delete_vals_words()
+{
+    for (unsigned idx = 0 ; idx < vals_word_pages ; idx += 1)
+	  delete vals_words[idx];
+    delete[]vals_words;
+    vals_words = 0;
+    vals_word_pages = 0;
 }
 
 vpiHandle __vpiArrayIterator::vpi_index(int)
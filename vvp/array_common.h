@@ -54,13 +54,15 @@ struct __vpiArrayIndex : public __vpiHandle {
  * the vpi methods and to point to the parent.
  *
  * How the point to the parent works is tricky. The vpiArrayWord
- * objects for an array are themselves allocated as an array. All the
- * ArrayWord objects in the array have a word0 that points to the base
- * of the array. Thus, the position into the array (and the index into
- * the memory) is calculated by subtracting word0 from the ArrayWord
- * pointer.
- *
- * To then get to the parent, use word0[-1].parent.
+ * objects for an array are allocated in pages (a vpiArrayWordPage)
+ * the first time a word of the page is needed. All the ArrayWord
+ * objects in a page point to the page, and the page holds the parent
+ * and the index of its first word. Thus, the position into the
+ * memory is calculated by subtracting the address of the first word
+ * of the page from the ArrayWord pointer, and adding the base of the
+ * page. Making the words a page at a time means that huge memories
+ * do not get a handle for every word as soon as VPI code looks at
+ * any of them.
  *
  * The vpiArrayWord is also used as a handle for the index (vpiIndex)
  * for the word. To make that work, return the pointer to the as_index
@@ -68,6 +70,8 @@ struct __vpiArrayIndex : public __vpiHandle {
  * of vpi functions is bound to the same structure. All the details
  * for the word also apply when treating this as an index.
  */
+struct __vpiArrayWordPage;
+
 struct __vpiArrayWord {
       struct as_word_t : public __vpiHandle {
 	    int get_type_code(void) const { return vpiMemoryWord; }
@@ -83,15 +87,25 @@ struct __vpiArrayWord {
 	    void vpi_get_value(p_vpi_value val);
       } as_index;
 
-      union {
-	    struct __vpiArrayBase*parent;
-	    struct __vpiArrayWord*word0;
-      };
+      struct __vpiArrayWordPage*page;
+
+      inline unsigned get_index() const;
+      inline struct __vpiArrayBase*get_parent() const;
+};
 
-      inline unsigned get_index() const { return this - word0; }
-      inline struct __vpiArrayBase*get_parent() const { return (word0 - 1)->parent; }
+struct __vpiArrayWordPage {
+      enum { PAGE_WORDS = 256 };
+      struct __vpiArrayBase*parent;
+      unsigned base;
+      struct __vpiArrayWord words[PAGE_WORDS];
 };
 
+inline unsigned __vpiArrayWord::get_index() const
+{ return page->base + (this - page->words); }
+
+inline struct __vpiArrayBase* __vpiArrayWord::get_parent() const
+{ return page->parent; }
+
 struct __vpiArrayWord*array_var_word_from_handle(vpiHandle ref);
 struct __vpiArrayWord*array_var_index_from_handle(vpiHandle ref);
 
@@ -96,6 +96,29 @@ vvp_code_t codespace_null(void)
       return first_chunk + 0;
 }
 
+void codespace_fuse(void)
+{
+      for (vvp_code_t chunk = first_chunk ; chunk ; ) {
+	    unsigned limit = (chunk == current_chunk)
+		  ? current_within_chunk
+		  : code_chunk_size-1;
+
+	      /* The last instruction of a chunk is never fused with
+		 the CHUNK_LINK that follows it. */
+	    for (unsigned idx = 0 ; idx+1 < limit ; idx += 1) {
+		  vvp_code_fun fused = vthread_fused_opcode(chunk[idx].opcode,
+							     chunk[idx+1].opcode);
+		  if (fused == 0)
+			continue;
+
+		  chunk[idx].opcode = fused;
+		  count_opcodes_fused += 1;
+	    }
+
+	    chunk = (chunk == current_chunk) ? 0 : chunk[code_chunk_size-1].cptr;
+      }
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void codespace_delete(void)
 {
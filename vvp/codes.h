@@ -33,8 +33,10 @@ typedef bool (*vvp_code_fun)(vthread_t thr, vvp_code_t code);
  */
 extern bool of_ABS_WR(vthread_t thr, vvp_code_t code);
 extern bool of_ADD(vthread_t thr, vvp_code_t code);
+extern bool of_ADD2(vthread_t thr, vvp_code_t code);
 extern bool of_ADD_WR(vthread_t thr, vvp_code_t code);
 extern bool of_ADDI(vthread_t thr, vvp_code_t code);
+extern bool of_ADDI2(vthread_t thr, vvp_code_t code);
 extern bool of_ALLOC(vthread_t thr, vvp_code_t code);
 extern bool of_AND(vthread_t thr, vvp_code_t code);
 extern bool of_ANDR(vthread_t thr, vvp_code_t code);
@@ -69,8 +71,12 @@ extern bool of_CAST2(vthread_t thr, vvp_code_t code);
 extern bool of_CAST_VEC2_DAR(vthread_t thr, vvp_code_t code);
 extern bool of_CAST_VEC4_DAR(vthread_t thr, vvp_code_t code);
 extern bool of_CAST_VEC4_STR(vthread_t thr, vvp_code_t code);
+extern bool of_CMP2S(vthread_t thr, vvp_code_t code);
+extern bool of_CMP2U(vthread_t thr, vvp_code_t code);
 extern bool of_CMPE(vthread_t thr, vvp_code_t code);
 extern bool of_CMPIE(vthread_t thr, vvp_code_t code);
+extern bool of_CMPI2S(vthread_t thr, vvp_code_t code);
+extern bool of_CMPI2U(vthread_t thr, vvp_code_t code);
 extern bool of_CMPINE(vthread_t thr, vvp_code_t code);
 extern bool of_CMPNE(vthread_t thr, vvp_code_t code);
 extern bool of_CMPS(vthread_t thr, vvp_code_t code);
@@ -105,6 +111,8 @@ extern bool of_DELETE_TAIL(vthread_t thr, vvp_code_t code);
 extern bool of_DISABLE(vthread_t thr, vvp_code_t code);
 extern bool of_DISABLE_FORK(vthread_t thr, vvp_code_t code);
 extern bool of_DIV(vthread_t thr, vvp_code_t code);
+extern bool of_DIV2S(vthread_t thr, vvp_code_t code);
+extern bool of_DIV2U(vthread_t thr, vvp_code_t code);
 extern bool of_DIV_S(vthread_t thr, vvp_code_t code);
 extern bool of_DIV_WR(vthread_t thr, vvp_code_t code);
 extern bool of_DUP_REAL(vthread_t thr, vvp_code_t code);
@@ -160,11 +168,15 @@ extern bool of_LOAD_VEC4A(vthread_t thr, vvp_code_t code);
 extern bool of_MAX_WR(vthread_t thr, vvp_code_t code);
 extern bool of_MIN_WR(vthread_t thr, vvp_code_t code);
 extern bool of_MOD(vthread_t thr, vvp_code_t code);
+extern bool of_MOD2S(vthread_t thr, vvp_code_t code);
+extern bool of_MOD2U(vthread_t thr, vvp_code_t code);
 extern bool of_MOD_S(vthread_t thr, vvp_code_t code);
 extern bool of_MOD_WR(vthread_t thr, vvp_code_t code);
 extern bool of_MOV_WU(vthread_t thr, vvp_code_t code);
 extern bool of_MUL(vthread_t thr, vvp_code_t code);
+extern bool of_MUL2(vthread_t thr, vvp_code_t code);
 extern bool of_MULI(vthread_t thr, vvp_code_t code);
+extern bool of_MULI2(vthread_t thr, vvp_code_t code);
 extern bool of_MUL_WR(vthread_t thr, vvp_code_t code);
 extern bool of_NAND(vthread_t thr, vvp_code_t code);
 extern bool of_NANDR(vthread_t thr, vvp_code_t code);
@@ -254,7 +266,9 @@ extern bool of_STORE_STRA(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_VEC4(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_VEC4A(vthread_t thr, vvp_code_t code);
 extern bool of_SUB(vthread_t thr, vvp_code_t code);
+extern bool of_SUB2(vthread_t thr, vvp_code_t code);
 extern bool of_SUBI(vthread_t thr, vvp_code_t code);
+extern bool of_SUBI2(vthread_t thr, vvp_code_t code);
 extern bool of_SUB_WR(vthread_t thr, vvp_code_t code);
 extern bool of_SUBSTR(vthread_t thr, vvp_code_t code);
 extern bool of_SUBSTR_VEC4(vthread_t thr, vvp_code_t code);
@@ -278,6 +292,14 @@ extern bool of_REAP_UFUNC(vthread_t thr, vvp_code_t code);
 
 extern bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code);
 
+/*
+ * Return the superinstruction that executes the opcode "first"
+ * immediately followed by the opcode "second", or nil if there is no
+ * such fused opcode. The fused opcodes live in vthread.cc with the
+ * opcodes that they combine.
+ */
+extern vvp_code_fun vthread_fused_opcode(vvp_code_fun first, vvp_code_fun second);
+
 /*
  * This is the format of a machine code instruction.
  */
@@ -320,4 +342,13 @@ extern vvp_code_t codespace_allocate(void);
 extern vvp_code_t codespace_next(void);
 extern vvp_code_t codespace_null(void);
 
+/*
+ * Scan the entire code space and replace the opcode of each
+ * instruction that is followed by an instruction it can be fused
+ * with by the fused opcode. This is done once, after all the code
+ * has been compiled and linked. The instruction operands are not
+ * changed, so jumps to either instruction of a fused pair still work.
+ */
+extern void codespace_fuse(void);
+
 #endif /* IVL_codes_H */
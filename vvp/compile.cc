@@ -23,6 +23,7 @@
 # include  "arith.h"
 # include  "compile.h"
 # include  "logic.h"
+# include  "cone.h"
 # include  "resolv.h"
 # include  "udp.h"
 # include  "symbols.h"
@@ -87,8 +88,10 @@ struct opcode_table_s {
 static const struct opcode_table_s opcode_table[] = {
       { "%abs/wr", of_ABS_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%add",    of_ADD,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%add/2",  of_ADD2,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%add/wr", of_ADD_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%addi",   of_ADDI,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%addi/2", of_ADDI2,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%alloc",  of_ALLOC,  1,  {OA_VPI_PTR,  OA_NONE,     OA_NONE} },
       { "%and",    of_AND,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%and/r",  of_ANDR,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
@@ -121,6 +124,8 @@ static const struct opcode_table_s opcode_table[] = {
       { "%cast/vec4/dar", of_CAST_VEC4_DAR, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
       { "%cast/vec4/str", of_CAST_VEC4_STR, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
       { "%cast2",   of_CAST2,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/2s",  of_CMP2S,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/2u",  of_CMP2U,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%cmp/e",   of_CMPE,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%cmp/ne",  of_CMPNE,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%cmp/s",   of_CMPS,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
@@ -133,6 +138,8 @@ static const struct opcode_table_s opcode_table[] = {
       { "%cmp/wu",  of_CMPWU,  2,  {OA_BIT1,     OA_BIT2,     OA_NONE} },
       { "%cmp/x",   of_CMPX,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%cmp/z",   of_CMPZ,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmpi/2s", of_CMPI2S, 3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%cmpi/2u", of_CMPI2U, 3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%cmpi/e",  of_CMPIE,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%cmpi/ne", of_CMPINE, 3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%cmpi/s",  of_CMPIS,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
@@ -157,6 +164,8 @@ static const struct opcode_table_s opcode_table[] = {
       { "%disable",  of_DISABLE, 1, {OA_VPI_PTR,OA_NONE,     OA_NONE} },
       { "%disable/fork",of_DISABLE_FORK,0,{OA_NONE,OA_NONE,  OA_NONE} },
       { "%div",      of_DIV,     0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%div/2s",   of_DIV2S,   0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%div/2u",   of_DIV2U,   0, {OA_NONE,   OA_NONE,     OA_NONE} },
       { "%div/s",    of_DIV_S,   0, {OA_NONE,   OA_NONE,     OA_NONE} },
       { "%div/wr",   of_DIV_WR,  0, {OA_NONE,   OA_NONE,     OA_NONE} },
       { "%dup/real", of_DUP_REAL,0, {OA_NONE,   OA_NONE,     OA_NONE} },
@@ -211,12 +220,16 @@ static const struct opcode_table_s opcode_table[] = {
       { "%max/wr", of_MAX_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%min/wr", of_MIN_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%mod",    of_MOD,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mod/2s", of_MOD2S,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mod/2u", of_MOD2U,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%mod/s",  of_MOD_S,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%mod/wr", of_MOD_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%mov/wu", of_MOV_WU, 2,  {OA_BIT1,     OA_BIT2,     OA_NONE} },
       { "%mul",    of_MUL,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mul/2",  of_MUL2,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%mul/wr", of_MUL_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%muli",   of_MULI,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%muli/2", of_MULI2,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%nand",   of_NAND,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%nand/r", of_NANDR,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%new/cobj",  of_NEW_COBJ,  1, {OA_VPI_PTR,OA_NONE,  OA_NONE} },
@@ -304,8 +317,10 @@ static const struct opcode_table_s opcode_table[] = {
       { "%store/vec4",    of_STORE_VEC4,    3, {OA_FUNC_PTR,OA_BIT1, OA_BIT2} },
       { "%store/vec4a",   of_STORE_VEC4A,   3, {OA_ARR_PTR, OA_BIT1, OA_BIT2} },
       { "%sub",    of_SUB,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%sub/2",  of_SUB2,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%sub/wr", of_SUB_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
       { "%subi",   of_SUBI,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%subi/2", of_SUBI2,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%substr",     of_SUBSTR,     2,{OA_BIT1,    OA_BIT2, OA_NONE} },
       { "%substr/vec4",of_SUBSTR_VEC4,2,{OA_BIT1,    OA_BIT2, OA_NONE} },
       { "%test_nul",     of_TEST_NUL,     1,{OA_FUNC_PTR,OA_NONE,    OA_NONE} },
@@ -766,6 +781,7 @@ void compile_cleanup(void)
       int lnerrs = -1;
       int nerrs = 0;
       int last;
+      double start = stat_phase_flag ? stat_time_now() : 0.0;
 
       if (verbose_flag) {
 	    fprintf(stderr, " ... Linking\n");
@@ -781,6 +797,7 @@ void compile_cleanup(void)
 	    while (res) {
 		  resolv_list_s *cur = res;
 		  res = res->next;
+		  count_resolv_items += 1;
 		  if (cur->resolve(last))
 			delete cur;
 		  else {
@@ -797,6 +814,11 @@ void compile_cleanup(void)
 
       compile_errors += nerrs;
 
+      if (stat_phase_flag) {
+	    stat_phase_end(STAT_PHASE_RESOLVE, start);
+	    start = stat_time_now();
+      }
+
       if (verbose_flag) {
 	    fprintf(stderr, " ... Removing symbol tables\n");
 	    fflush(stderr);
@@ -821,6 +843,31 @@ void compile_cleanup(void)
       compile_island_cleanup();
       compile_array_cleanup();
 
+	/* All the code is in place and all the code pointers are
+	   resolved, so look for adjacent instructions to fuse. */
+      codespace_fuse();
+
+	/* The netlist is complete, so trees of gates can be collapsed
+	   into single functors if requested. This must be done before
+	   the fan-out is frozen, since it replaces functors. */
+      if (collapse_cones_flag) {
+	    if (verbose_flag) {
+		  fprintf(stderr, " ... Collapsing gate cones\n");
+		  fflush(stderr);
+	    }
+	    vvp_cone_collapse();
+      }
+
+	/* The netlist is complete, so the fan-out of the nets can be
+	   packed into arrays if requested. */
+      if (freeze_fanout_flag) {
+	    if (verbose_flag) {
+		  fprintf(stderr, " ... Freezing net fan-out\n");
+		  fflush(stderr);
+	    }
+	    vvp_net_freeze_fanout();
+      }
+
       if (verbose_flag) {
 	    fprintf(stderr, " ... Compiletf functions\n");
 	    fflush(stderr);
@@ -838,6 +885,9 @@ void compile_cleanup(void)
       }
 
       vpi_mode_flag = VPI_MODE_NONE;
+
+      if (stat_phase_flag)
+	    stat_phase_end(STAT_PHASE_CLEANUP, start);
 }
 
 void compile_vpi_symbol(const char*label, vpiHandle obj)
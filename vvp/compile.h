@@ -50,6 +50,29 @@ extern void compile_cleanup(void);
 
 extern bool verbose_flag;
 
+/*
+ * If set, compile_cleanup() freezes the net fan-out lists into arrays.
+ */
+extern bool freeze_fanout_flag;
+
+/*
+ * If set, compile_cleanup() collapses combinational cones of gates
+ * into single functors.
+ */
+extern bool collapse_cones_flag;
+
+/*
+ * Static 2-state arrays with at least this many words are made with
+ * sparse storage that is allocated as it is written. Zero means never.
+ */
+extern unsigned long sparse_array_words;
+
+/*
+ * If set, compile_design() uses (or writes) a precompiled image of the
+ * input file.
+ */
+extern bool image_flag;
+
 /*
  * If this file opened, then write debug information to this
  * file. This is used for debugging the VVP runtime itself.
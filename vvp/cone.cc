@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2020 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "cone.h"
+# include  "statistics.h"
+# include  <new>
+# include  <vector>
+# include  <algorithm>
+# include  <functional>
+# include  <cassert>
+#ifdef CHECK_WITH_VALGRIND
+# include  "vvp_cleanup.h"
+#endif
+
+unsigned long count_cones = 0;
+unsigned long count_cone_nodes = 0;
+
+#ifdef CHECK_WITH_VALGRIND
+static std::vector<vvp_cone_core*> cone_list;
+#endif
+
+/*
+ * The nodes are functors, but they are not taken from the functor heap
+ * one at a time like other functors. They are created in place in one
+ * array, so that the core can index them.
+ */
+vvp_cone_core::vvp_cone_core(vvp_net_t*root, unsigned nnodes)
+: root_(root), nnodes_(nnodes), scheduled_(false)
+{
+      nodes_ = static_cast<vvp_fun_cone_node*>
+	    (::operator new(nnodes_ * sizeof(vvp_fun_cone_node)));
+
+      unsigned nwords = (nnodes_ + 63) / 64;
+      dirty_ = new uint64_t[nwords];
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+	    dirty_[idx] = 0;
+      first_dirty_ = nwords;
+#ifdef CHECK_WITH_VALGRIND
+      cone_list.push_back(this);
+#endif
+}
+
+vvp_cone_core::~vvp_cone_core()
+{
+      for (unsigned idx = 0 ;  idx < nnodes_ ;  idx += 1)
+	    nodes_[idx].~vvp_fun_cone_node();
+      ::operator delete(nodes_);
+      delete[] dirty_;
+}
+
+vvp_fun_cone_node* vvp_cone_core::make_node(unsigned idx,
+					    vvp_cone_member_s*fun,
+					    unsigned parent,
+					    unsigned parent_port)
+{
+      assert(idx < nnodes_);
+      return ::new (nodes_ + idx) vvp_fun_cone_node(this, fun, parent,
+						     parent_port);
+}
+
+static inline unsigned cone_lowest_bit(uint64_t word)
+{
+      assert(word != 0);
+#if defined(__GNUC__)
+      return __builtin_ctzll(word);
+#else
+      unsigned res = 0;
+      while ((word & 1) == 0) {
+	    word >>= 1;
+	    res += 1;
+      }
+      return res;
+#endif
+}
+
+void vvp_cone_core::mark_dirty_(unsigned idx)
+{
+      dirty_[idx/64] |= (uint64_t)1 << (idx%64);
+      if (idx/64 < first_dirty_)
+	    first_dirty_ = idx/64;
+
+      if (! scheduled_) {
+	    scheduled_ = true;
+	    schedule_functor(this);
+      }
+}
+
+void vvp_cone_core::recv_vec4(const vvp_fun_cone_node*node, unsigned port,
+			      const vvp_vector4_t&bit)
+{
+      if (node->fun_->cone_recv_vec4(port, bit))
+	    mark_dirty_(node - nodes_);
+}
+
+void vvp_cone_core::recv_vec4_pv(const vvp_fun_cone_node*node, unsigned port,
+				 const vvp_vector4_t&bit,
+				 unsigned base, unsigned wid, unsigned vwid)
+{
+      if (node->fun_->cone_recv_vec4_pv(port, bit, base, wid, vwid))
+	    mark_dirty_(node - nodes_);
+}
+
+/*
+ * Evaluate the dirty nodes, lowest index first. A node always comes
+ * before the node it drives, so by the time a node is evaluated, all
+ * its inputs within the cone are up to date. Only the root sends its
+ * output to the rest of the netlist.
+ */
+void vvp_cone_core::run_run()
+{
+      scheduled_ = false;
+
+      unsigned nwords = (nnodes_ + 63) / 64;
+      unsigned wdx = first_dirty_;
+      first_dirty_ = nwords;
+
+      vvp_vector4_t out;
+      for ( ; wdx < nwords ;  wdx += 1) {
+	    while (dirty_[wdx]) {
+		  unsigned idx = wdx*64 + cone_lowest_bit(dirty_[wdx]);
+		  dirty_[wdx] &= dirty_[wdx] - 1;
+
+		  vvp_fun_cone_node&cur = nodes_[idx];
+		  cur.fun_->cone_eval(out);
+
+		  if (idx+1 == nnodes_) {
+			root_->send_vec4(out, 0);
+			return;
+		  }
+
+		    // The parent always has a higher index, so the scan
+		    // will get to it.
+		  unsigned par = cur.parent_;
+		  if (nodes_[par].fun_->cone_recv_vec4(cur.parent_port_, out))
+			dirty_[par/64] |= (uint64_t)1 << (par%64);
+	    }
+      }
+}
+
+vvp_fun_cone_node::vvp_fun_cone_node(vvp_cone_core*core,
+				     vvp_cone_member_s*fun,
+				     unsigned parent, unsigned parent_port)
+: core_(core), fun_(fun), parent_(parent), parent_port_(parent_port)
+{
+}
+
+vvp_fun_cone_node::~vvp_fun_cone_node()
+{
+}
+
+void vvp_fun_cone_node::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+				  vvp_context_t)
+{
+      core_->recv_vec4(this, port.port(), bit);
+}
+
+void vvp_fun_cone_node::recv_vec4_pv(vvp_net_ptr_t port,
+				     const vvp_vector4_t&bit,
+				     unsigned base, unsigned wid, unsigned vwid,
+				     vvp_context_t)
+{
+      core_->recv_vec4_pv(this, port.port(), bit, base, wid, vwid);
+}
+
+/*
+ * The collapse pass works on all the nets whose functor can be a cone
+ * member. Each such net that drives only an input of another such net
+ * is a child of that net. The nets that are not children are the roots
+ * of the cones. (Nets in a loop of children never reach a root, and
+ * are left alone.) A net with a filter is a signal that shares the net
+ * of its driver, so it may be the root of a cone, but never a child.
+ */
+namespace {
+      struct cone_scan_s {
+	    std::vector<vvp_net_t*> nets;
+      };
+
+      struct cone_cand_s {
+	    vvp_net_t*net;
+	    vvp_cone_member_s*fun;
+	    unsigned parent;
+	    unsigned parent_port;
+	    unsigned first_child;
+	    unsigned nchildren;
+      };
+}
+
+static void cone_scan_net(vvp_net_t*net, void*cd)
+{
+      cone_scan_s*scan = static_cast<cone_scan_s*>(cd);
+      if (dynamic_cast<vvp_cone_member_s*>(net->fun) == 0)
+	    return;
+      scan->nets.push_back(net);
+}
+
+void vvp_cone_collapse(void)
+{
+      cone_scan_s scan;
+      vvp_net_scan(&cone_scan_net, &scan);
+      std::sort(scan.nets.begin(), scan.nets.end(), std::less<vvp_net_t*>());
+
+      const unsigned NONE = (unsigned)-1;
+      unsigned ncand = scan.nets.size();
+      std::vector<cone_cand_s> cand (ncand);
+
+      for (unsigned idx = 0 ;  idx < ncand ;  idx += 1) {
+	    cand[idx].net = scan.nets[idx];
+	    cand[idx].fun = dynamic_cast<vvp_cone_member_s*>(scan.nets[idx]->fun);
+	    cand[idx].parent = NONE;
+	    cand[idx].parent_port = 0;
+	    cand[idx].first_child = 0;
+	    cand[idx].nchildren = 0;
+
+	    if (scan.nets[idx]->fil)
+		  continue;
+
+	    vvp_net_ptr_t recv = scan.nets[idx]->single_receiver();
+	    if (recv.nil() || recv.ptr() == scan.nets[idx])
+		  continue;
+
+	    std::vector<vvp_net_t*>::iterator cur
+		  = std::lower_bound(scan.nets.begin(), scan.nets.end(),
+				     recv.ptr(), std::less<vvp_net_t*>());
+	    if (cur == scan.nets.end() || *cur != recv.ptr())
+		  continue;
+
+	    cand[idx].parent = cur - scan.nets.begin();
+	    cand[idx].parent_port = recv.port();
+      }
+
+	// Make a list of the children of every candidate.
+      for (unsigned idx = 0 ;  idx < ncand ;  idx += 1) {
+	    if (cand[idx].parent != NONE)
+		  cand[cand[idx].parent].nchildren += 1;
+      }
+      unsigned fill = 0;
+      for (unsigned idx = 0 ;  idx < ncand ;  idx += 1) {
+	    cand[idx].first_child = fill;
+	    fill += cand[idx].nchildren;
+	    cand[idx].nchildren = 0;
+      }
+      std::vector<unsigned> children (fill);
+      for (unsigned idx = 0 ;  idx < ncand ;  idx += 1) {
+	    if (cand[idx].parent == NONE)
+		  continue;
+	    cone_cand_s&par = cand[cand[idx].parent];
+	    children[par.first_child + par.nchildren] = idx;
+	    par.nchildren += 1;
+      }
+
+	// Walk each tree from its root, and list the nodes in
+	// post-order. The position of each candidate in the list of
+	// its cone is kept in pos.
+      std::vector<unsigned> pos (ncand, NONE);
+      std::vector<unsigned> order;
+      std::vector<std::pair<unsigned,unsigned> > stack;
+      for (unsigned root = 0 ;  root < ncand ;  root += 1) {
+	    if (cand[root].parent != NONE || cand[root].nchildren == 0)
+		  continue;
+
+	    order.clear();
+	    stack.push_back(std::make_pair(root, 0U));
+	    while (! stack.empty()) {
+		  unsigned cur = stack.back().first;
+		  unsigned&next = stack.back().second;
+		  if (next < cand[cur].nchildren) {
+			unsigned child = children[cand[cur].first_child + next];
+			next += 1;
+			stack.push_back(std::make_pair(child, 0U));
+			continue;
+		  }
+		  pos[cur] = order.size();
+		  order.push_back(cur);
+		  stack.pop_back();
+	    }
+
+	    assert(order.back() == root);
+	    vvp_cone_core*core = new vvp_cone_core(cand[root].net, order.size());
+	    for (unsigned idx = 0 ;  idx < order.size() ;  idx += 1) {
+		  const cone_cand_s&cur = cand[order[idx]];
+		  unsigned parent = NONE;
+		  if (cur.parent != NONE) {
+			parent = pos[cur.parent];
+			  // The core passes the output of a child to its
+			  // parent, so the link between their nets is not
+			  // used any more. A child never has a filter, so
+			  // there is no VPI object that looks at its net.
+			cur.net->unlink(vvp_net_ptr_t(cand[cur.parent].net,
+						      cur.parent_port));
+		  }
+		  cur.net->fun = core->make_node(idx, cur.fun, parent,
+						 cur.parent_port);
+	    }
+
+	    count_cones += 1;
+	    count_cone_nodes += order.size();
+      }
+}
+
+#ifdef CHECK_WITH_VALGRIND
+void cone_delete(void)
+{
+      for (unsigned idx = 0 ;  idx < cone_list.size() ;  idx += 1)
+	    delete cone_list[idx];
+      cone_list.clear();
+}
+#endif
@@ -0,0 +1,132 @@
+#ifndef IVL_cone_H
+#define IVL_cone_H
+/*
+ * Copyright (c) 2020 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "vvp_net.h"
+# include  "schedule.h"
+# include  <stdint.h>
+
+/*
+ * A combinational cone is a tree of delay-free functors where each
+ * node except the root drives exactly one input of another node in the
+ * tree and nothing else. Normally each node of such a tree is its own
+ * scheduled event, and a change at a leaf input ripples up the tree
+ * one event per level. The vvp_cone_collapse() pass finds these trees
+ * after the netlist is linked and hands all the nodes of a tree to a
+ * single vvp_cone_core, which evaluates the whole tree in one event
+ * and only propagates the output of the root.
+ *
+ * Functors that can take part in a cone implement this interface. The
+ * cone_recv_* methods store an input value the way the recv_* methods
+ * do, but return true (instead of scheduling the functor) if the
+ * stored value changed. The cone_eval method calculates the output of
+ * the node from the stored values.
+ */
+class vvp_cone_member_s {
+
+    public:
+      virtual bool cone_recv_vec4(unsigned port, const vvp_vector4_t&bit) =0;
+      virtual bool cone_recv_vec4_pv(unsigned port, const vvp_vector4_t&bit,
+				     unsigned base, unsigned wid,
+				     unsigned vwid) =0;
+      virtual void cone_eval(vvp_vector4_t&out) =0;
+
+    protected:
+      ~vvp_cone_member_s() { }
+};
+
+class vvp_cone_core;
+
+/*
+ * The functor of every net in a cone is replaced with a
+ * vvp_fun_cone_node that passes the inputs to the core. It also keeps
+ * the member functor it replaced, and where the output of that member
+ * goes in the cone.
+ */
+class vvp_fun_cone_node : public vvp_net_fun_t {
+
+    public:
+      vvp_fun_cone_node(vvp_cone_core*core, vvp_cone_member_s*fun,
+			unsigned parent, unsigned parent_port);
+      ~vvp_fun_cone_node();
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t);
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid,
+                        vvp_context_t);
+
+    private:
+      friend class vvp_cone_core;
+      vvp_cone_core*core_;
+      vvp_cone_member_s*fun_;
+	// Index of the node that this node drives, and the port.
+      unsigned parent_;
+      unsigned parent_port_;
+};
+
+/*
+ * The vvp_cone_core object holds the nodes of a cone in a single
+ * array, kept in post-order so that each node comes before the node
+ * that it drives. It is the event that evaluates the cone. The leaf
+ * inputs stay linked as they were, so they still arrive at the input
+ * ports of the member nets, and the net of the root still drives the
+ * fan-out of the cone. The links between the member nets are dropped,
+ * since the core passes those values itself.
+ */
+class vvp_cone_core : public vvp_gen_event_s {
+
+    public:
+      vvp_cone_core(vvp_net_t*root, unsigned nnodes);
+      ~vvp_cone_core();
+
+	// Create the node with the given index, and return it so that
+	// it can be made the functor of the member net.
+      vvp_fun_cone_node* make_node(unsigned idx, vvp_cone_member_s*fun,
+				   unsigned parent, unsigned parent_port);
+
+      void recv_vec4(const vvp_fun_cone_node*node, unsigned port,
+		     const vvp_vector4_t&bit);
+      void recv_vec4_pv(const vvp_fun_cone_node*node, unsigned port,
+			const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid);
+
+    private:
+      void run_run();
+      void mark_dirty_(unsigned idx);
+
+    private:
+      vvp_net_t*root_;
+      vvp_fun_cone_node*nodes_;
+      unsigned nnodes_;
+	// A bit for each node that has changed inputs, and the index
+	// of the lowest word with a bit set.
+      uint64_t*dirty_;
+      unsigned first_dirty_;
+      bool scheduled_;
+};
+
+/*
+ * Collapse all the combinational cones of the netlist. This is called
+ * once at the end of compile, before the fan-out is frozen.
+ */
+extern void vvp_cone_collapse(void);
+
+#endif /* IVL_cone_H */
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2020 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "parse_misc.h"
+# include  "compile.h"
+# include  "parse.h"
+# include  "version_base.h"
+# include  "statistics.h"
+# include  <map>
+# include  <vector>
+# include  <string>
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <cassert>
+#ifdef HAVE_SYS_MMAN_H
+# include  <sys/mman.h>
+# include  <sys/stat.h>
+# include  <fcntl.h>
+# include  <unistd.h>
+#endif
+# include  "ivl_alloc.h"
+
+/*
+ * A precompiled image holds the token stream that the lexor produced
+ * for a .vvp file, so that later runs with the same input can skip
+ * the lexor. The image is written next to the source file (with a
+ * ".img" suffix) and starts with a header that records the size and
+ * a hash of the source file, and a key for the vvp that wrote it.
+ * An image that does not match is ignored and rewritten.
+ *
+ * The header is followed by a table of the token numbers used in the
+ * file, then the token stream, then a string table. The stream is
+ * kept compact, since reading it must be faster than lexing the
+ * source:
+ *
+ *   - Each token is a single byte, its index in the token table + 1.
+ *   - A 0 byte is followed by the number of lines to advance.
+ *   - Tokens that carry a value are followed by the value. For text
+ *     values that is an offset into the string table, which holds
+ *     each distinct string once.
+ *
+ * The line counts and values are unsigned LEB128 numbers (7 bits per
+ * byte, low bits first, the high bit set on all but the last byte).
+ */
+
+static const char image_magic[8] = { 'V','V','P','I','M','G','2','\n' };
+
+struct image_header_s {
+      char magic[8];
+      uint64_t byte_order;
+      uint64_t tool_key;
+      uint64_t source_size;
+      uint64_t source_hash;
+      uint64_t token_count;
+      uint64_t code_count;
+      uint64_t stream_size;
+      uint64_t string_size;
+};
+
+  // The largest number of distinct tokens that a stream can code.
+static const unsigned IMAGE_MAX_CODES = 255;
+
+static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_PRIME  = 0x100000001b3ULL;
+
+static uint64_t hash_bytes(uint64_t hash, const void*data, size_t len)
+{
+      const unsigned char*cp = static_cast<const unsigned char*>(data);
+      for (size_t idx = 0 ; idx < len ; idx += 1) {
+	    hash ^= cp[idx];
+	    hash *= FNV_PRIME;
+      }
+      return hash;
+}
+
+/*
+ * The token numbers come from the parser, so an image is only good
+ * for the vvp version (and grammar) that wrote it.
+ */
+static uint64_t image_tool_key(void)
+{
+      const char*ver = VERSION;
+      int last_token = T_VECTOR;
+      uint64_t key = hash_bytes(FNV_OFFSET, ver, strlen(ver));
+      key = hash_bytes(key, &last_token, sizeof last_token);
+      return key;
+}
+
+static std::string image_path;
+static uint64_t image_source_size = 0;
+static uint64_t image_source_hash = 0;
+
+  // State for reading an image.
+static const char*image_map = 0;
+static size_t image_map_size = 0;
+static bool image_map_is_mmap = false;
+static int image_codes[IMAGE_MAX_CODES+1];
+static const unsigned char*image_cur = 0;
+static const unsigned char*image_end = 0;
+static unsigned image_replay_line = 0;
+static const char*image_strings = 0;
+static uint64_t image_strings_size = 0;
+
+  // State for recording an image.
+static bool image_recording = false;
+static uint64_t image_token_count = 0;
+static std::vector<int32_t> image_code_list;
+static std::map<int,unsigned char> image_code_map;
+static std::string image_stream;
+static unsigned image_line = 0;
+static std::string image_string_table;
+static std::map<std::string,uint64_t> image_string_map;
+
+static void image_unmap(void)
+{
+      if (image_map == 0)
+	    return;
+#ifdef HAVE_SYS_MMAN_H
+      if (image_map_is_mmap)
+	    munmap(const_cast<char*>(image_map), image_map_size);
+      else
+#endif
+	    free(const_cast<char*>(image_map));
+      image_map = 0;
+      image_map_size = 0;
+      image_cur = 0;
+      image_end = 0;
+      image_strings = 0;
+      image_strings_size = 0;
+}
+
+static bool image_map_file(const char*path)
+{
+#ifdef HAVE_SYS_MMAN_H
+      int fd = open(path, O_RDONLY);
+      if (fd < 0)
+	    return false;
+
+      struct stat sb;
+      if (fstat(fd, &sb) < 0 || sb.st_size == 0) {
+	    close(fd);
+	    return false;
+      }
+
+      void*map = mmap(0, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (map == MAP_FAILED)
+	    return false;
+
+      image_map = static_cast<const char*>(map);
+      image_map_size = sb.st_size;
+      image_map_is_mmap = true;
+      return true;
+#else
+      FILE*fd = fopen(path, "rb");
+      if (fd == 0)
+	    return false;
+
+      fseek(fd, 0, SEEK_END);
+      long size = ftell(fd);
+      fseek(fd, 0, SEEK_SET);
+      if (size <= 0) {
+	    fclose(fd);
+	    return false;
+      }
+
+      char*buf = (char*)malloc(size);
+      if (fread(buf, 1, size, fd) != (size_t)size) {
+	    free(buf);
+	    fclose(fd);
+	    return false;
+      }
+      fclose(fd);
+
+      image_map = buf;
+      image_map_size = size;
+      image_map_is_mmap = false;
+      return true;
+#endif
+}
+
+/*
+ * Check that the mapped image matches the source file, and if so set
+ * up the token cursor. Return false if the image cannot be used.
+ */
+static bool image_check(void)
+{
+      if (image_map_size < sizeof(image_header_s))
+	    return false;
+
+      image_header_s head;
+      memcpy(&head, image_map, sizeof head);
+
+      if (memcmp(head.magic, image_magic, sizeof image_magic) != 0)
+	    return false;
+      if (head.byte_order != 0x01020304)
+	    return false;
+      if (head.tool_key != image_tool_key())
+	    return false;
+      if (head.source_size != image_source_size)
+	    return false;
+      if (head.source_hash != image_source_hash)
+	    return false;
+
+      if (head.code_count > IMAGE_MAX_CODES)
+	    return false;
+      uint64_t need = sizeof head + head.code_count*sizeof(int32_t)
+		    + head.stream_size + head.string_size;
+      if (need != image_map_size)
+	    return false;
+      if (head.string_size == 0 || image_map[image_map_size-1] != 0)
+	    return false;
+
+      const char*cp = image_map + sizeof head;
+	// Code 0 is the line advance, and unused codes end the stream.
+      for (unsigned idx = 0 ; idx <= IMAGE_MAX_CODES ; idx += 1)
+	    image_codes[idx] = 0;
+      for (unsigned idx = 0 ; idx < head.code_count ; idx += 1) {
+	    int32_t token;
+	    memcpy(&token, cp, sizeof token);
+	    cp += sizeof token;
+	    image_codes[idx+1] = token;
+      }
+
+      image_cur = reinterpret_cast<const unsigned char*>(cp);
+      image_end = image_cur + head.stream_size;
+      image_strings = reinterpret_cast<const char*>(image_end);
+      image_strings_size = head.string_size;
+      image_replay_line = 0;
+      return true;
+}
+
+/*
+ * This is called with the opened source file before it is parsed. It
+ * hashes the source, then either arranges for the tokens to come from
+ * a valid image, or for the tokens from the lexor to be recorded.
+ */
+void image_open(const char*path, FILE*src)
+{
+      image_path = path;
+      image_path += ".img";
+
+      char buf[65536];
+      size_t cnt;
+      image_source_size = 0;
+      image_source_hash = FNV_OFFSET;
+      while ((cnt = fread(buf, 1, sizeof buf, src)) > 0) {
+	    image_source_size += cnt;
+	    image_source_hash = hash_bytes(image_source_hash, buf, cnt);
+      }
+      rewind(src);
+
+      if (image_map_file(image_path.c_str())) {
+	    if (image_check()) {
+		  if (verbose_flag)
+			fprintf(stderr, " ... Loading image %s\n",
+				image_path.c_str());
+		  return;
+	    }
+	    if (verbose_flag)
+		  fprintf(stderr, " ... Ignoring stale image %s\n",
+			  image_path.c_str());
+	    image_unmap();
+      }
+
+      image_recording = true;
+      image_token_count = 0;
+      image_code_list.clear();
+      image_code_map.clear();
+      image_stream.clear();
+      image_line = 0;
+      image_string_table.clear();
+      image_string_map.clear();
+}
+
+static void image_write(void)
+{
+      std::string tmp_path = image_path + ".tmp";
+      FILE*fd = fopen(tmp_path.c_str(), "wb");
+      if (fd == 0) {
+	    fprintf(stderr, "Warning: Unable to write image %s\n",
+		    image_path.c_str());
+	    return;
+      }
+
+	// Make sure the string table is not empty and ends with a nul.
+      image_string_table.push_back(0);
+
+      image_header_s head;
+      memset(&head, 0, sizeof head);
+      memcpy(head.magic, image_magic, sizeof image_magic);
+      head.byte_order = 0x01020304;
+      head.tool_key = image_tool_key();
+      head.source_size = image_source_size;
+      head.source_hash = image_source_hash;
+      head.token_count = image_token_count;
+      head.code_count = image_code_list.size();
+      head.stream_size = image_stream.size();
+      head.string_size = image_string_table.size();
+
+      bool ok = fwrite(&head, sizeof head, 1, fd) == 1;
+      if (ok && ! image_code_list.empty())
+	    ok = fwrite(&image_code_list[0], sizeof(int32_t),
+			image_code_list.size(), fd) == image_code_list.size();
+      if (ok)
+	    ok = fwrite(image_stream.data(), 1,
+			image_stream.size(), fd) == image_stream.size();
+      if (ok)
+	    ok = fwrite(image_string_table.data(), 1,
+			image_string_table.size(), fd) == image_string_table.size();
+      if (fclose(fd) != 0)
+	    ok = false;
+
+      remove(image_path.c_str());
+      if (! ok || rename(tmp_path.c_str(), image_path.c_str()) != 0) {
+	    fprintf(stderr, "Warning: Unable to write image %s\n",
+		    image_path.c_str());
+	    remove(tmp_path.c_str());
+	    return;
+      }
+
+      if (verbose_flag)
+	    fprintf(stderr, " ... Wrote image %s (%lu tokens)\n",
+		    image_path.c_str(), (unsigned long)image_token_count);
+}
+
+/*
+ * Called after the parse. If the tokens were recorded, and the parse
+ * was clean, then save them for the next time.
+ */
+void image_close(bool parse_ok)
+{
+      if (image_recording && parse_ok)
+	    image_write();
+
+      image_recording = false;
+      image_code_list.clear();
+      image_code_map.clear();
+      image_stream.clear();
+      image_string_table.clear();
+      image_string_map.clear();
+      image_unmap();
+}
+
+static void image_put_uint(uint64_t val)
+{
+      while (val >= 0x80) {
+	    image_stream.push_back((char)(val | 0x80));
+	    val >>= 7;
+      }
+      image_stream.push_back((char)val);
+}
+
+static uint64_t image_get_uint(void)
+{
+      uint64_t val = 0;
+      unsigned shift = 0;
+      while (image_cur < image_end) {
+	    unsigned char byte = *image_cur++;
+	    val |= (uint64_t)(byte & 0x7f) << shift;
+	    if ((byte & 0x80) == 0)
+		  break;
+	    shift += 7;
+      }
+      return val;
+}
+
+static uint64_t image_add_string(const char*text)
+{
+      std::map<std::string,uint64_t>::iterator cur
+	    = image_string_map.find(text);
+      if (cur != image_string_map.end())
+	    return cur->second;
+
+      uint64_t off = image_string_table.size();
+      image_string_table.append(text, strlen(text)+1);
+      image_string_map[text] = off;
+      return off;
+}
+
+static void image_record(int token)
+{
+      std::map<int,unsigned char>::iterator code = image_code_map.find(token);
+      if (code == image_code_map.end()) {
+	      // Give up on the image if the file uses more tokens than
+	      // the stream can code. No real design comes close.
+	    if (image_code_list.size() == IMAGE_MAX_CODES) {
+		  image_recording = false;
+		  return;
+	    }
+	    image_code_list.push_back(token);
+	    code = image_code_map.insert(std::make_pair(token,
+			  (unsigned char)image_code_list.size())).first;
+      }
+
+      if (yyline != image_line) {
+	    image_stream.push_back(0);
+	    image_put_uint(yyline - image_line);
+	    image_line = yyline;
+      }
+
+      image_stream.push_back((char)code->second);
+      image_token_count += 1;
+
+      switch (token) {
+	  case T_INSTR:
+	  case T_LABEL:
+	  case T_STRING:
+	  case T_SYMBOL:
+	    image_put_uint(image_add_string(yylval.text));
+	    break;
+	  case T_NUMBER:
+	    image_put_uint(yylval.numb);
+	    break;
+	  case T_VECTOR:
+	    image_put_uint(image_add_string(yylval.vect.text));
+	    break;
+	  default:
+	    break;
+      }
+}
+
+static const char* image_get_string(void)
+{
+      uint64_t off = image_get_uint();
+      assert(off < image_strings_size);
+      return image_strings + off;
+}
+
+/*
+ * Recreate the yylval for a token from the image. The text values are
+ * allocated the same way the lexor allocates them, since the parser
+ * takes ownership.
+ */
+static int image_replay(void)
+{
+      if (image_cur == image_end)
+	    return 0;
+
+      unsigned char code = *image_cur++;
+      if (code == 0) {
+	    image_replay_line += image_get_uint();
+	    yyline = image_replay_line;
+	    if (image_cur == image_end)
+		  return 0;
+	    code = *image_cur++;
+      }
+
+      int token = image_codes[code];
+      switch (token) {
+	  case T_INSTR:
+	  case T_LABEL:
+	  case T_SYMBOL:
+	    yylval.text = strdup(image_get_string());
+	    assert(yylval.text);
+	    break;
+	  case T_STRING: {
+		const char*text = image_get_string();
+		yylval.text = strcpy(new char [strlen(text)+1], text);
+		break;
+	  }
+	  case T_NUMBER:
+	    yylval.numb = image_get_uint();
+	    break;
+	  case T_VECTOR: {
+		const char*text = image_get_string();
+		size_t len = strlen(text);
+		yylval.vect.text = (char*)malloc(len + 1);
+		memcpy(yylval.vect.text, text, len + 1);
+		yylval.vect.idx = text[0] == 's' ? len - 1 : len;
+		break;
+	  }
+	  default:
+	    break;
+      }
+
+      return token;
+}
+
+static int image_next_token(void)
+{
+      if (image_cur)
+	    return image_replay();
+
+      int token = yylex();
+      if (image_recording && token != 0)
+	    image_record(token);
+      return token;
+}
+
+/*
+ * When the load phases are being timed, time the lexor (or the image)
+ * and watch for the first keyword or instruction of each statement
+ * so that the parse time can be broken down by statement kind.
+ */
+static bool stat_at_statement = true;
+
+int image_lex(void)
+{
+      if (! stat_phase_flag)
+	    return image_next_token();
+
+      double start = stat_time_now();
+      int token = image_next_token();
+      stat_phase_add(STAT_PHASE_LEX, stat_time_now() - start);
+
+      if (token == ';') {
+	    stat_at_statement = true;
+      } else if (stat_at_statement && token != T_LABEL && token != 0) {
+	    stat_statement_begin(parse_token_name(token));
+	    stat_at_statement = false;
+      }
+
+      return token;
+}
@@ -43,14 +43,14 @@ vvp_fun_boolean_::~vvp_fun_boolean_()
 void vvp_fun_boolean_::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                                  vvp_context_t)
 {
-      unsigned port = ptr.port();
-      if (input_[port] .eeq( bit ))
+      if (! cone_recv_vec4(ptr.port(), bit))
 	    return;
 
-      input_[port] = bit;
       if (net_ == 0) {
 	    net_ = ptr.ptr();
 	    schedule_functor(this);
+      } else {
+	    schedule_precomputed_stale(this);
       }
 }
 
@@ -58,20 +58,74 @@ void vvp_fun_boolean_::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 				    unsigned base, unsigned wid, unsigned vwid,
                                     vvp_context_t)
 {
-      unsigned port = ptr.port();
+      if (! cone_recv_vec4_pv(ptr.port(), bit, base, wid, vwid))
+	    return;
+
+      if (net_ == 0) {
+	    net_ = ptr.ptr();
+	    schedule_functor(this);
+      } else {
+	    schedule_precomputed_stale(this);
+      }
+}
 
+bool vvp_fun_boolean_::cone_recv_vec4(unsigned port, const vvp_vector4_t&bit)
+{
+      return input_[port].update(bit);
+}
+
+bool vvp_fun_boolean_::cone_recv_vec4_pv(unsigned port,
+					 const vvp_vector4_t&bit,
+					 unsigned base, unsigned wid,
+					 unsigned vwid)
+{
       assert(bit.size() == wid);
       assert(base + wid <= vwid);
 
 	// Set the part for the input. If nothing changes, then break.
-      bool flag = input_[port] .set_vec(base, bit);
-      if (flag == false)
-	    return;
+      return input_[port] .set_vec(base, bit);
+}
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
+void vvp_fun_boolean_::cone_eval(vvp_vector4_t&out)
+{
+      eval_(out);
+}
+
+void vvp_fun_boolean_::run_run()
+{
+      vvp_net_t*ptr = net_;
+      net_ = 0;
+
+      if (const vvp_vector4_t*pre = schedule_precomputed(this)) {
+	    ptr->send_vec4(*pre, 0);
+	    return;
       }
+
+      vvp_vector4_t result;
+      eval_(result);
+      ptr->send_vec4(result, 0);
+}
+
+/*
+ * Only vectors that fit in a word can be evaluated in a worker
+ * thread, since wider vectors draw on the (unlocked) word array pool.
+ */
+bool vvp_fun_boolean_::can_precompute(void) const
+{
+      return input_[0].size() <= 8*sizeof(unsigned long);
+}
+
+void vvp_fun_boolean_::precompute(vvp_vector4_t&result) const
+{
+      eval_(result);
+}
+
+bool vvp_fun_boolean_::inputs_match_(void) const
+{
+      unsigned wid = input_[0].size();
+      return input_[1].size() == wid
+	  && input_[2].size() == wid
+	  && input_[3].size() == wid;
 }
 
 vvp_fun_and::vvp_fun_and(unsigned wid, bool invert)
@@ -84,12 +138,18 @@ vvp_fun_and::~vvp_fun_and()
 {
 }
 
-void vvp_fun_and::run_run()
+void vvp_fun_and::eval_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      result = input_[0];
 
-      vvp_vector4_t result (input_[0]);
+      if (inputs_match_()) {
+	    result &= input_[1];
+	    result &= input_[2];
+	    result &= input_[3];
+	    if (invert_)
+		  result.invert();
+	    return;
+      }
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -106,8 +166,6 @@ void vvp_fun_and::run_run()
 		  bitbit = ~bitbit;
 	    result.set_bit(idx, bitbit);
       }
-
-      ptr->send_vec4(result, 0);
 }
 
 vvp_fun_equiv::vvp_fun_equiv()
@@ -120,18 +178,13 @@ vvp_fun_equiv::~vvp_fun_equiv()
 {
 }
 
-void vvp_fun_equiv::run_run()
+void vvp_fun_equiv::eval_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
-
       assert(input_[0].size() == 1);
       assert(input_[1].size() == 1);
 
       vvp_bit4_t bit = ~(input_[0].value(0) ^ input_[1].value(0));
-      vvp_vector4_t result (1, bit);
-
-      ptr->send_vec4(result, 0);
+      result = vvp_vector4_t(1, bit);
 }
 
 vvp_fun_impl::vvp_fun_impl()
@@ -144,18 +197,13 @@ vvp_fun_impl::~vvp_fun_impl()
 {
 }
 
-void vvp_fun_impl::run_run()
+void vvp_fun_impl::eval_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
-
       assert(input_[0].size() == 1);
       assert(input_[1].size() == 1);
 
       vvp_bit4_t bit = ~input_[0].value(0) | input_[1].value(0);
-      vvp_vector4_t result (1, bit);
-
-      ptr->send_vec4(result, 0);
+      result = vvp_vector4_t(1, bit);
 }
 
 vvp_fun_buf::vvp_fun_buf(unsigned wid)
@@ -179,11 +227,9 @@ void vvp_fun_buf::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       if (ptr.port() != 0)
 	    return;
 
-      if (input_ .eeq( bit ))
+      if (! input_.update(bit))
 	    return;
 
-      input_ = bit;
-
       if (net_ == 0) {
 	    net_ = ptr.ptr();
 	    schedule_functor(this);
@@ -379,13 +425,11 @@ void vvp_fun_muxz::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 {
       switch (ptr.port()) {
 	  case 0:
-	    if (a_ .eeq(bit) && has_run_) return;
-	    a_ = bit;
+	    if (! a_.update(bit) && has_run_) return;
 	    if (select_ == SEL_PORT1) return; // The other port is selected.
 	    break;
 	  case 1:
-	    if (b_ .eeq(bit) && has_run_) return;
-	    b_ = bit;
+	    if (! b_.update(bit) && has_run_) return;
 	    if (select_ == SEL_PORT0) return; // The other port is selected.
 	    break;
 	  case 2:
@@ -506,10 +550,8 @@ void vvp_fun_not::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       if (ptr.port() != 0)
 	    return;
 
-      if (input_ .eeq( bit ))
+      if (! input_.update(bit))
 	    return;
-
-      input_ = bit;
       if (net_ == 0) {
 	    net_ = ptr.ptr();
 	    schedule_functor(this);
@@ -556,12 +598,18 @@ vvp_fun_or::~vvp_fun_or()
 {
 }
 
-void vvp_fun_or::run_run()
+void vvp_fun_or::eval_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      result = input_[0];
 
-      vvp_vector4_t result (input_[0]);
+      if (inputs_match_()) {
+	    result |= input_[1];
+	    result |= input_[2];
+	    result |= input_[3];
+	    if (invert_)
+		  result.invert();
+	    return;
+      }
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -578,8 +626,6 @@ void vvp_fun_or::run_run()
 		  bitbit = ~bitbit;
 	    result.set_bit(idx, bitbit);
       }
-
-      ptr->send_vec4(result, 0);
 }
 
 vvp_fun_xor::vvp_fun_xor(unsigned wid, bool invert)
@@ -592,12 +638,18 @@ vvp_fun_xor::~vvp_fun_xor()
 {
 }
 
-void vvp_fun_xor::run_run()
+void vvp_fun_xor::eval_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      result = input_[0];
 
-      vvp_vector4_t result (input_[0]);
+      if (inputs_match_()) {
+	    result ^= input_[1];
+	    result ^= input_[2];
+	    result ^= input_[3];
+	    if (invert_)
+		  result.invert();
+	    return;
+      }
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -614,8 +666,6 @@ void vvp_fun_xor::run_run()
 		  bitbit = ~bitbit;
 	    result.set_bit(idx, bitbit);
       }
-
-      ptr->send_vec4(result, 0);
 }
 
 /*
@@ -21,12 +21,17 @@
 
 # include  "vvp_net.h"
 # include  "schedule.h"
+# include  "cone.h"
 # include  <cstddef>
 
 /*
- * vvp_fun_boolean_ is just a common hook for holding operands.
+ * vvp_fun_boolean_ is the common hook for holding operands. The
+ * derived classes only compute the output with eval_(), so that the
+ * output can be precomputed by the parallel scheduler (see
+ * schedule_set_parallel) and only propagated by run_run().
  */
-class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
+class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s,
+			 public vvp_cone_member_s {
 
     public:
       explicit vvp_fun_boolean_(unsigned wid);
@@ -38,6 +43,23 @@ class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool cone_recv_vec4(unsigned port, const vvp_vector4_t&bit);
+      bool cone_recv_vec4_pv(unsigned port, const vvp_vector4_t&bit,
+			     unsigned base, unsigned wid, unsigned vwid);
+      void cone_eval(vvp_vector4_t&out);
+
+    protected:
+	// Calculate the output value from the current inputs.
+      virtual void eval_(vvp_vector4_t&result) const =0;
+	// True if all the inputs are as wide as the first input, so
+	// that the gate can be evaluated a word at a time.
+      bool inputs_match_(void) const;
+
+    private:
+      void run_run();
+      bool can_precompute(void) const;
+      void precompute(vvp_vector4_t&result) const;
+
     protected:
       vvp_vector4_t input_[4];
       vvp_net_t*net_;
@@ -50,7 +72,7 @@ class vvp_fun_and  : public vvp_fun_boolean_ {
       ~vvp_fun_and();
 
     private:
-      void run_run();
+      void eval_(vvp_vector4_t&result) const;
       bool invert_;
 };
 
@@ -61,7 +83,7 @@ class vvp_fun_equiv : public vvp_fun_boolean_ {
       ~vvp_fun_equiv();
 
     private:
-      void run_run();
+      void eval_(vvp_vector4_t&result) const;
 };
 
 class vvp_fun_impl : public vvp_fun_boolean_ {
@@ -71,7 +93,7 @@ class vvp_fun_impl : public vvp_fun_boolean_ {
       ~vvp_fun_impl();
 
     private:
-      void run_run();
+      void eval_(vvp_vector4_t&result) const;
 };
 
 /*
@@ -217,7 +239,7 @@ class vvp_fun_or  : public vvp_fun_boolean_ {
       ~vvp_fun_or();
 
     private:
-      void run_run();
+      void eval_(vvp_vector4_t&result) const;
       bool invert_;
 };
 
@@ -228,7 +250,7 @@ class vvp_fun_xor  : public vvp_fun_boolean_ {
       ~vvp_fun_xor();
 
     private:
-      void run_run();
+      void eval_(vvp_vector4_t&result) const;
       bool invert_;
 };
 
@@ -25,6 +25,7 @@
 # include  "schedule.h"
 # include  "vpi_priv.h"
 # include  "statistics.h"
+# include  "profile.h"
 # include  "vvp_cleanup.h"
 # include  "vvp_object.h"
 # include  <cstdio>
@@ -57,6 +58,10 @@ extern "C" const char*optarg;
 #endif
 
 bool verbose_flag = false;
+bool freeze_fanout_flag = false;
+bool collapse_cones_flag = false;
+unsigned long sparse_array_words = 1UL << 22;
+bool image_flag = false;
 bool version_flag = false;
 static int vvp_return_value = 0;
 
@@ -202,6 +207,9 @@ static void final_cleanup()
 {
       vvp_object::cleanup();
 
+	/* Write out the files that the background writer still holds. */
+      vpip_mcd_finish();
+
 	/*
 	 * We only need to cleanup the memory if we are checking with valgrind.
 	 */
@@ -226,6 +234,7 @@ static void final_cleanup()
       signal_pool_delete();
       vvp_net_pool_delete();
       ufunc_pool_delete();
+      cone_delete();
 #endif
 	/*
 	 * Unload the VPI modules. This is essential for MinGW, to ensure
@@ -258,6 +267,9 @@ int main(int argc, char*argv[])
       struct rusage cycles[3];
       const char *logfile_name = 0x0;
       FILE *logfile = 0x0;
+      unsigned long parallel_threads = 0;
+      const char*stat_report_path = 0;
+      const char*profile_path = 0;
       extern void vpi_set_vlog_info(int, char**);
       extern bool stop_is_finish;
       extern int  stop_is_finish_exit_code;
@@ -278,26 +290,57 @@ int main(int argc, char*argv[])
         /* For non-interactive runs we do not want to run the interactive
          * debugger, so make $stop just execute a $finish. */
       stop_is_finish = false;
-      while ((opt = getopt(argc, argv, "+hil:M:m:nNsvV")) != EOF) switch (opt) {
+      while ((opt = getopt(argc, argv, "+a:bcFhij:k:l:M:m:nNOp:sT:vV")) != EOF) switch (opt) {
          case 'h':
            fprintf(stderr,
                    "Usage: vvp [options] input-file [+plusargs...]\n"
                    "Options:\n"
+                   " -a words       Sparse 2-state arrays from this many words.\n"
+                   " -b             Write $fopen files from a background thread.\n"
+                   " -c             Use a precompiled image of the input.\n"
+                   " -F             Freeze net fan-out into arrays.\n"
                    " -h             Print this help message.\n"
                    " -i             Interactive mode (unbuffered stdio).\n"
+                   " -j threads     Evaluate gates with this many threads.\n"
+                   " -k words       Karatsuba multiply from this many words.\n"
                    " -l file        Logfile, '-' for <stderr>\n"
                    " -M path        VPI module directory\n"
 		   " -M -           Clear VPI module path\n"
                    " -m module      Load vpi module.\n"
 		   " -n             Non-interactive ($stop = $finish).\n"
                    " -N             Same as -n, but exit code is 1 instead of 0\n"
+                   " -O             Collapse trees of gates into single functors.\n"
+                   " -p file        Write a sampling profile of the simulation.\n"
 		   " -s             $stop right away.\n"
+                   " -T file        Write a JSON report of load phase times.\n"
                    " -v             Verbose progress messages.\n"
                    " -V             Print the version information.\n" );
            exit(0);
+	  case 'a':
+	    sparse_array_words = strtoul(optarg, 0, 0);
+	    break;
+	  case 'b':
+	    vpip_mcd_set_async(true);
+	    break;
+	  case 'c':
+	    image_flag = true;
+	    break;
+	  case 'F':
+	    freeze_fanout_flag = true;
+	    break;
+	  case 'O':
+	    collapse_cones_flag = true;
+	    break;
 	  case 'i':
 	    setvbuf(stdout, 0, _IONBF, 0);
 	    break;
+	  case 'j':
+	    parallel_threads = strtoul(optarg, 0, 0);
+	    schedule_set_parallel(parallel_threads);
+	    break;
+	  case 'k':
+	    karatsuba_words = strtoul(optarg, 0, 0);
+	    break;
 	  case 'l':
 	    logfile_name = optarg;
 	    break;
@@ -318,9 +361,16 @@ int main(int argc, char*argv[])
             stop_is_finish = true;
             stop_is_finish_exit_code = 1;
             break;
+	  case 'p':
+	    profile_path = optarg;
+	    break;
 	  case 's':
 	    schedule_stop(0);
 	    break;
+	  case 'T':
+	    stat_report_path = optarg;
+	    stat_phase_flag = true;
+	    break;
 	  case 'v':
 	    verbose_flag = true;
 	    break;
@@ -403,8 +453,11 @@ int main(int argc, char*argv[])
 
       compile_init();
 
+      double start = stat_phase_flag ? stat_time_now() : 0.0;
       for (unsigned idx = 0 ;  idx < module_cnt ;  idx += 1)
 	    vpip_load_module(module_tab[idx]);
+      if (stat_phase_flag)
+	    stat_phase_end(STAT_PHASE_VPI_MODULES, start);
 
       int ret_cd = compile_design(design_path);
       destroy_lexor();
@@ -434,6 +487,9 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, " ... %8lu functors (net_fun pool=%zu bytes)\n",
 			   count_functors, vvp_net_fun_t::heap_total());
 	    vpi_mcd_printf(1, "           %8lu logic\n",  count_functors_logic);
+	    if (collapse_cones_flag)
+		  vpi_mcd_printf(1, "           %8lu cones (%lu functors)\n",
+				 count_cones, count_cone_nodes);
 	    vpi_mcd_printf(1, "           %8lu bufif\n",  count_functors_bufif);
 	    vpi_mcd_printf(1, "           %8lu resolv\n",count_functors_resolv);
 	    vpi_mcd_printf(1, "           %8lu signals\n", count_functors_sig);
@@ -441,9 +497,18 @@ int main(int argc, char*argv[])
 			   count_filters, vvp_net_fil_t::heap_total());
 	    vpi_mcd_printf(1, " ... %8lu opcodes (%zu bytes)\n",
 	                   count_opcodes, size_opcodes);
+	    vpi_mcd_printf(1, "           %8lu fused (%.1f%%)\n",
+			   count_opcodes_fused, count_opcodes
+			   ? 100.0*count_opcodes_fused/count_opcodes : 0.0);
 	    vpi_mcd_printf(1, " ... %8lu nets\n",     count_vpi_nets);
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%zu bytes)\n",
 			   count_vvp_nets, size_vvp_nets);
+	    if (freeze_fanout_flag)
+		  vpi_mcd_printf(1, "           %8lu frozen fan-out (%.1f avg)\n",
+				 vvp_net_t::count_fanout_nets,
+				 vvp_net_t::count_fanout_nets
+				 ? (double)vvp_net_t::count_fanout_targets
+				   / vvp_net_t::count_fanout_nets : 0.0);
 	    vpi_mcd_printf(1, " ... %8lu arrays (%lu words)\n",
 			   count_net_arrays, count_net_array_words);
 	    vpi_mcd_printf(1, " ... %8lu memories\n",
@@ -462,8 +527,17 @@ int main(int argc, char*argv[])
       }
 
 
+      if (profile_path)
+	    profile_start();
+
       schedule_simulate();
 
+      if (profile_path)
+	    profile_finish(profile_path);
+
+      if (stat_report_path)
+	    stat_phase_report(stat_report_path, design_path);
+
       if (verbose_flag) {
 	    my_getrusage(cycles+2);
 	    print_rusage(cycles+2, cycles+1);
@@ -487,6 +561,16 @@ int main(int argc, char*argv[])
 			   count_assign_arword_pool());
 	    vpi_mcd_printf(1, "    %8lu other events (pool=%lu)\n",
 			   count_gen_events, count_gen_pool());
+	    vpi_mcd_printf(1, "    %8lu wide vec4 arrays (%lu from heap)\n",
+			   vvp_vector4_t::count_array_allocs,
+			   vvp_vector4_t::count_array_heap);
+	    vpi_mcd_printf(1, "    %8lu filtered vec4 sends (%lu copied)\n",
+			   vvp_net_t::count_filter_sends,
+			   vvp_net_t::count_filter_copies);
+	    if (parallel_threads > 1)
+		  vpi_mcd_printf(1, "    %8lu parallel gate evaluations "
+				 "(%lu batches)\n", count_parallel_events,
+				 count_parallel_batches);
       }
 
       final_cleanup();
@@ -22,6 +22,7 @@
 # include  "parse_misc.h"
 # include  "compile.h"
 # include  "delay.h"
+# include  "statistics.h"
 # include  <list>
 # include  <cstdio>
 # include  <cstdlib>
@@ -34,6 +35,12 @@
  */
 extern FILE*yyin;
 
+/*
+ * The tokens come through image_lex(), which either replays them from
+ * a precompiled image or passes on (and maybe records) the lexor's.
+ */
+# define yylex image_lex
+
 vector <const char*> file_names;
 
 /*
@@ -1247,7 +1254,31 @@ int compile_design(const char*path)
 	    return -1;
       }
 
+      double start = stat_phase_flag ? stat_time_now() : 0.0;
+
+      if (image_flag)
+	    image_open(path, yyin);
+
       int rc = yyparse();
+      if (image_flag)
+	    image_close(rc == 0 && compile_errors == 0);
       fclose(yyin);
+
+      if (stat_phase_flag) {
+	    stat_statement_begin(0);
+	    stat_phase_end(STAT_PHASE_PARSE, start);
+      }
       return rc;
 }
+
+/*
+ * Return the name of a token, for the statement statistics.
+ */
+const char* parse_token_name(int token)
+{
+#if YYDEBUG
+      return yytname[YYTRANSLATE(token)];
+#else
+      return "statement";
+#endif
+}
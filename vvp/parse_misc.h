@@ -20,6 +20,7 @@
  */
 
 # include  "vpi_priv.h"
+# include  <cstdio>
 
 /*
  * This method is called to compile the design file. The input is read
@@ -46,6 +47,19 @@ extern void yyerror(const char*msg);
 
 extern void destroy_lexor();
 
+/*
+ * Support for precompiled images of the lexor output. (See image.cc)
+ * The parser reads its tokens through image_lex().
+ */
+extern void image_open(const char*path, FILE*src);
+extern void image_close(bool parse_ok);
+extern int image_lex(void);
+
+/*
+ * Return the grammar name of a token.
+ */
+extern const char* parse_token_name(int token);
+
 /*
  * This is the path of the current source file.
  */
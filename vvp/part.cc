@@ -55,14 +55,9 @@ vvp_fun_part_sa::~vvp_fun_part_sa()
 void vvp_fun_part_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                 vvp_context_t)
 {
-      assert(port.port() == 0);
-
-      vvp_vector4_t tmp (bit, base_, wid_);
-      if (val_ .eeq( tmp ))
+      if (! cone_recv_vec4(port.port(), bit))
 	    return;
 
-      val_ = tmp;
-
       if (net_ == 0) {
 	    net_ = port.ptr();
 	    schedule_functor(this);
@@ -87,6 +82,31 @@ void vvp_fun_part_sa::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       recv_vec4(port, tmp, 0);
 }
 
+bool vvp_fun_part_sa::cone_recv_vec4(unsigned port, const vvp_vector4_t&bit)
+{
+      assert(port == 0);
+
+      vvp_vector4_t tmp (bit, base_, wid_);
+      return val_.update(tmp);
+}
+
+bool vvp_fun_part_sa::cone_recv_vec4_pv(unsigned port, const vvp_vector4_t&bit,
+					unsigned base, unsigned wid,
+					unsigned vwid)
+{
+      assert(bit.size() == wid);
+
+      vvp_vector4_t tmp (vwid, BIT4_Z);
+      tmp.set_vec(base_, val_);
+      tmp.set_vec(base, bit);
+      return cone_recv_vec4(port, tmp);
+}
+
+void vvp_fun_part_sa::cone_eval(vvp_vector4_t&out)
+{
+      out = val_;
+}
+
 void vvp_fun_part_sa::run_run()
 {
       vvp_net_t*ptr = net_;
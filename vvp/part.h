@@ -20,6 +20,7 @@
  */
 
 # include  "schedule.h"
+# include  "cone.h"
 # include  "config.h"
 
 /* vvp_fun_part
@@ -42,7 +43,8 @@ class vvp_fun_part  : public vvp_net_fun_t {
 /*
  * Statically allocated vvp_fun_part.
  */
-class vvp_fun_part_sa  : public vvp_fun_part, public vvp_gen_event_s {
+class vvp_fun_part_sa  : public vvp_fun_part, public vvp_gen_event_s,
+			 public vvp_cone_member_s {
 
     public:
       vvp_fun_part_sa(unsigned base, unsigned wid);
@@ -56,6 +58,11 @@ class vvp_fun_part_sa  : public vvp_fun_part, public vvp_gen_event_s {
 			unsigned, unsigned, unsigned,
                         vvp_context_t);
 
+      bool cone_recv_vec4(unsigned port, const vvp_vector4_t&bit);
+      bool cone_recv_vec4_pv(unsigned port, const vvp_vector4_t&bit,
+			     unsigned base, unsigned wid, unsigned vwid);
+      void cone_eval(vvp_vector4_t&out);
+
     private:
       void run_run();
 
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2020 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "profile.h"
+# include  "vpi_priv.h"
+# include  <map>
+# include  <string>
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+#ifdef HAVE_SETITIMER
+# include  <csignal>
+# include  <sys/time.h>
+#endif
+#if defined(__GNUC__)
+# include  <cxxabi.h>
+#endif
+
+__vpiScope*volatile profile_scope = 0;
+vpiHandle volatile profile_fileline = 0;
+const std::type_info*volatile profile_event = 0;
+
+bool profile_flag = false;
+
+/*
+ * The samples are counted in a fixed size, open addressed hash table
+ * keyed by the sampled variables. The signal handler cannot allocate
+ * memory, so if the table fills up, the extra samples are dropped.
+ */
+struct profile_entry_s {
+      __vpiScope*scope;
+      vpiHandle fileline;
+      const std::type_info*event;
+      unsigned long count;
+};
+
+static const size_t PROFILE_TABLE_SIZE = 65536;
+static profile_entry_s profile_table[PROFILE_TABLE_SIZE];
+static volatile unsigned long profile_dropped = 0;
+
+  // Sample every millisecond of CPU time.
+static const long PROFILE_INTERVAL_USEC = 1000;
+
+#ifdef HAVE_SETITIMER
+static void profile_signal(int)
+{
+      __vpiScope*scope = profile_scope;
+      vpiHandle fileline = profile_fileline;
+      const std::type_info*event = profile_event;
+
+	// A running thread accounts for everything it does.
+      if (scope)
+	    event = 0;
+      else
+	    fileline = 0;
+
+      size_t hash = reinterpret_cast<size_t>(scope) * 31
+		  + reinterpret_cast<size_t>(fileline) * 17
+		  + reinterpret_cast<size_t>(event);
+      hash ^= hash >> 16;
+
+      for (size_t probe = 0 ; probe < PROFILE_TABLE_SIZE ; probe += 1) {
+	    profile_entry_s&cur = profile_table[(hash+probe) % PROFILE_TABLE_SIZE];
+	    if (cur.count == 0) {
+		  cur.scope = scope;
+		  cur.fileline = fileline;
+		  cur.event = event;
+		  cur.count = 1;
+		  return;
+	    }
+	    if (cur.scope == scope && cur.fileline == fileline
+		&& cur.event == event) {
+		  cur.count += 1;
+		  return;
+	    }
+      }
+
+      profile_dropped += 1;
+}
+
+static void profile_set_timer(long usec)
+{
+      struct itimerval val;
+      val.it_interval.tv_sec = 0;
+      val.it_interval.tv_usec = usec;
+      val.it_value = val.it_interval;
+      setitimer(ITIMER_PROF, &val, 0);
+}
+#endif
+
+void profile_start(void)
+{
+#ifdef HAVE_SETITIMER
+      signal(SIGPROF, profile_signal);
+      profile_flag = true;
+      profile_set_timer(PROFILE_INTERVAL_USEC);
+#else
+      fprintf(stderr, "Warning: Profiling is not supported on this "
+	      "system.\n");
+#endif
+}
+
+/*
+ * Flame graph tools use ';' to separate the frames, so keep it out of
+ * the frame names.
+ */
+static void profile_add_frame(std::string&stack, const char*name)
+{
+      if (! stack.empty())
+	    stack += ';';
+      for (const char*cp = name ; *cp ; cp += 1)
+	    stack += *cp == ';' ? ':' : *cp;
+}
+
+static void profile_add_scope(std::string&stack, __vpiScope*scope)
+{
+      if (scope->scope)
+	    profile_add_scope(stack, scope->scope);
+      profile_add_frame(stack, scope->scope_name());
+}
+
+static std::string profile_type_name(const std::type_info*type)
+{
+      std::string res = type->name();
+#if defined(__GNUC__)
+      int status = 0;
+      char*name = abi::__cxa_demangle(type->name(), 0, 0, &status);
+      if (status == 0 && name)
+	    res = name;
+      free(name);
+#endif
+      return res;
+}
+
+static std::string profile_stack(const profile_entry_s&cur)
+{
+      std::string stack;
+
+      if (cur.scope) {
+	    profile_add_scope(stack, cur.scope);
+	    if (cur.fileline) {
+		  char buf[32];
+		  std::string file = vpi_get_str(vpiFile, cur.fileline);
+		  snprintf(buf, sizeof buf, ":%d",
+			   vpi_get(vpiLineNo, cur.fileline));
+		  profile_add_frame(stack, (file + buf).c_str());
+	    }
+      } else if (cur.event) {
+	    profile_add_frame(stack, "<propagation>");
+	    profile_add_frame(stack, profile_type_name(cur.event).c_str());
+      } else {
+	    profile_add_frame(stack, "<scheduler>");
+      }
+
+      return stack;
+}
+
+void profile_finish(const char*path)
+{
+      if (! profile_flag)
+	    return;
+
+#ifdef HAVE_SETITIMER
+      profile_set_timer(0);
+      signal(SIGPROF, SIG_DFL);
+#endif
+      profile_flag = false;
+
+	// Different keys may give the same stack (the same line in
+	// different threads, for example) so merge them here.
+      std::map<std::string,unsigned long> stacks;
+      for (size_t idx = 0 ; idx < PROFILE_TABLE_SIZE ; idx += 1) {
+	    const profile_entry_s&cur = profile_table[idx];
+	    if (cur.count == 0)
+		  continue;
+	    stacks[profile_stack(cur)] += cur.count;
+      }
+
+      FILE*fd = fopen(path, "w");
+      if (fd == 0) {
+	    perror(path);
+	    return;
+      }
+
+      std::map<std::string,unsigned long>::const_iterator cur;
+      for (cur = stacks.begin() ; cur != stacks.end() ; ++ cur)
+	    fprintf(fd, "%s %lu\n", cur->first.c_str(), cur->second);
+
+      fclose(fd);
+
+      if (profile_dropped > 0)
+	    fprintf(stderr, "Warning: The profiler dropped %lu samples.\n",
+		    (unsigned long)profile_dropped);
+}
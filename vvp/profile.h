@@ -0,0 +1,56 @@
+#ifndef IVL_profile_H
+#define IVL_profile_H
+/*
+ * Copyright (c) 2020 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "vpi_user.h"
+# include  <typeinfo>
+
+class __vpiScope;
+
+/*
+ * The sampling profiler takes a sample of these variables at each
+ * timer tick. The scheduler and the thread engine keep them up to
+ * date: profile_scope and profile_fileline describe the thread that
+ * is running (if any), and profile_event is the class of the event or
+ * functor that the scheduler is running. They are only ever written
+ * with single stores, so the signal handler can read them at any
+ * time.
+ *
+ * profile_fileline is set by the %file_line opcodes, which the code
+ * generator only emits with -pfileline=1. Without them it stays nil,
+ * and the samples of a thread are charged to its scope alone.
+ */
+extern __vpiScope*volatile profile_scope;
+extern vpiHandle volatile profile_fileline;
+extern const std::type_info*volatile profile_event;
+
+/*
+ * This is true while the profiler is sampling.
+ */
+extern bool profile_flag;
+
+/*
+ * Start sampling, and stop sampling and write the collected samples
+ * to the file in the folded stack format used by flame graph tools.
+ */
+extern void profile_start(void);
+extern void profile_finish(const char*path);
+
+#endif /* IVL_profile_H */
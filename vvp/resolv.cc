@@ -169,10 +169,13 @@ void resolv_tri::recv_vec8_(unsigned port, const vvp_vector8_t&bit)
       }
 
       if (! hiz_value_.is_hiz()) {
-	    for (unsigned idx = 0 ;  idx < val_[base].size() ;  idx += 1) {
-		  val_[base].set_bit(idx, resolve(val_[base].value(idx),
-						  hiz_value_));
+	    unsigned wid = val_[base].size();
+	    if (hiz_vec_.size() != wid) {
+		  hiz_vec_ = vvp_vector8_t(wid);
+		  for (unsigned idx = 0 ;  idx < wid ;  idx += 1)
+			hiz_vec_.set_bit(idx, hiz_value_);
 	    }
+	    val_[base] = resolve(val_[base], hiz_vec_);
       }
 
       net_->send_vec8(val_[base]);
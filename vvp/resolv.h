@@ -126,6 +126,8 @@ class resolv_tri : public resolv_core {
     private:
         // The puller value to be used when a bit is not driven.
       vvp_scalar_t hiz_value_;
+        // The puller value repeated across the width of the output.
+      vvp_vector8_t hiz_vec_;
         // The array of input values.
       vvp_vector8_t*val_;
 };
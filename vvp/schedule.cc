@@ -24,12 +24,20 @@
 # include  "vvp_net_sig.h"
 # include  "slab.h"
 # include  "compile.h"
+# include  "statistics.h"
+# include  "profile.h"
 # include  <new>
 # include  <typeinfo>
 # include  <csignal>
 # include  <cstdlib>
 # include  <cassert>
 # include  <iostream>
+# include  <algorithm>
+# include  <map>
+# include  <vector>
+#ifdef HAVE_LIBPTHREAD
+# include  <pthread.h>
+#endif
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 # include  "ivl_alloc.h"
@@ -40,6 +48,9 @@ unsigned long count_gen_events = 0;
 unsigned long count_thread_events = 0;
   // Count the time events (A time cell created)
 unsigned long count_time_events = 0;
+  // Count the functor events precomputed by the parallel scheduler.
+unsigned long count_parallel_batches = 0;
+unsigned long count_parallel_events = 0;
 
 
 
@@ -49,6 +60,8 @@ unsigned long count_time_events = 0;
  *
  * The event_time_s objects are one per time step. Each time step in
  * turn contains a list of event_s objects that are the actual events.
+ * The time steps themselves are kept in a timing wheel (see below)
+ * and are keyed by their absolute simulation time.
  *
  * The event_s objects are base classes for the more specific sort of
  * event.
@@ -61,6 +74,12 @@ struct event_s {
 	// Write something about the event to stderr
       virtual void single_step_display(void);
 
+	// The functor object this event runs, if any.
+      virtual vvp_gen_event_t gen_obj(void) { return 0; }
+
+	// The type that the profiler charges this event to.
+      virtual const std::type_info&profile_type(void) { return typeid(*this); }
+
 	// Fallback new/delete
       static void*operator new (size_t size) { return ::new char[size]; }
       static void operator delete(void*ptr)  { ::delete[]( (char*)ptr ); }
@@ -81,9 +100,8 @@ struct event_time_s {
 	    rwsync = 0;
 	    rosync = 0;
 	    del_thr = 0;
-	    next = NULL;
       }
-      vvp_time64_t delay;
+      vvp_time64_t time;
 
       struct event_s*start;
       struct event_s*active;
@@ -93,8 +111,6 @@ struct event_time_s {
       struct event_s*rosync;
       struct event_s*del_thr;
 
-      struct event_time_s*next;
-
       static void* operator new (size_t);
       static void operator delete(void*obj, size_t s);
 };
@@ -108,6 +124,15 @@ void vvp_gen_event_s::single_step_display(void)
       cerr << "vvp_gen_event_s: Step into event " << typeid(*this).name() << endl;
 }
 
+bool vvp_gen_event_s::can_precompute(void) const
+{
+      return false;
+}
+
+void vvp_gen_event_s::precompute(vvp_vector4_t&) const
+{
+}
+
 /*
  * Derived event types
  */
@@ -492,6 +517,9 @@ struct generic_event_s : public event_s {
       bool delete_obj_when_done;
       void run_run(void);
       void single_step_display(void);
+      vvp_gen_event_t gen_obj(void) { return obj; }
+      const std::type_info&profile_type(void)
+      { return obj ? typeid(*obj) : typeid(*this); }
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -552,11 +580,150 @@ inline void event_time_s::operator delete(void*ptr, size_t)
 unsigned long count_time_pool(void) { return event_time_heap.pool; }
 
 /*
- * This is the head of the list of pending events. This includes all
- * the events that have not been executed yet, and reaches into the
- * future.
+ * The pending time steps are kept in a timing wheel. The wheel has
+ * SCHED_WHEEL_SIZE buckets and covers the window of absolute times
+ * [schedule_time, schedule_time+SCHED_WHEEL_SIZE). Because the window
+ * is exactly as wide as the wheel, every bucket holds at most one
+ * event_time_s, so a time step is found or created in constant time
+ * by indexing with the low bits of its absolute time. A bitmap of the
+ * occupied buckets makes finding the next pending time step a short
+ * scan of machine words.
+ *
+ * Time steps that fall beyond the end of the window are kept in the
+ * sched_overflow map, ordered by time. As the simulation time
+ * advances the window slides forward, and the overflow entries that
+ * enter the window are moved into the wheel.
  */
-static struct event_time_s* sched_list = 0;
+static const unsigned SCHED_WHEEL_BITS = 12;
+static const vvp_time64_t SCHED_WHEEL_SIZE = 1 << SCHED_WHEEL_BITS;
+static const vvp_time64_t SCHED_WHEEL_MASK = SCHED_WHEEL_SIZE - 1;
+static const unsigned SCHED_WHEEL_WORDS = SCHED_WHEEL_SIZE / 64;
+
+static struct event_time_s* sched_wheel[SCHED_WHEEL_SIZE];
+static uint64_t sched_wheel_map[SCHED_WHEEL_WORDS];
+static unsigned long sched_wheel_count = 0;
+
+typedef std::map<vvp_time64_t,struct event_time_s*> sched_overflow_t;
+static sched_overflow_t sched_overflow;
+
+/*
+ * This is the current absolute simulation time. It is also the base
+ * of the timing wheel window.
+ */
+static vvp_time64_t schedule_time = 0;
+
+static inline void sched_wheel_insert(struct event_time_s*ctim)
+{
+      unsigned idx = ctim->time & SCHED_WHEEL_MASK;
+      assert(sched_wheel[idx] == 0);
+      sched_wheel[idx] = ctim;
+      sched_wheel_map[idx/64] |= (uint64_t)1 << (idx%64);
+      sched_wheel_count += 1;
+}
+
+static inline void sched_wheel_remove(struct event_time_s*ctim)
+{
+      unsigned idx = ctim->time & SCHED_WHEEL_MASK;
+      assert(sched_wheel[idx] == ctim);
+      sched_wheel[idx] = 0;
+      sched_wheel_map[idx/64] &= ~((uint64_t)1 << (idx%64));
+      sched_wheel_count -= 1;
+}
+
+static inline unsigned sched_lowest_bit(uint64_t word)
+{
+      assert(word != 0);
+#if defined(__GNUC__)
+      return __builtin_ctzll(word);
+#else
+      unsigned res = 0;
+      while ((word & 1) == 0) {
+	    word >>= 1;
+	    res += 1;
+      }
+      return res;
+#endif
+}
+
+/*
+ * Return the event_time_s for the given absolute time, or create it
+ * if there is not one already.
+ */
+static struct event_time_s* sched_find_time(vvp_time64_t time)
+{
+      assert(time >= schedule_time);
+
+      if ((time - schedule_time) < SCHED_WHEEL_SIZE) {
+	    struct event_time_s*ctim = sched_wheel[time & SCHED_WHEEL_MASK];
+	    if (ctim) {
+		  assert(ctim->time == time);
+		  return ctim;
+	    }
+	    ctim = new struct event_time_s;
+	    ctim->time = time;
+	    sched_wheel_insert(ctim);
+	    return ctim;
+      }
+
+      struct event_time_s*&ctim = sched_overflow[time];
+      if (ctim == 0) {
+	    ctim = new struct event_time_s;
+	    ctim->time = time;
+      }
+      return ctim;
+}
+
+/*
+ * Return the earliest pending event_time_s, or nil if there are no
+ * events pending at all. If the wheel is not empty then its first
+ * occupied bucket (starting from the bucket for schedule_time) is the
+ * earliest, because all the overflow times are past the window.
+ */
+static struct event_time_s* sched_first_time(void)
+{
+      if (sched_wheel_count == 0) {
+	    if (sched_overflow.empty())
+		  return 0;
+	    return sched_overflow.begin()->second;
+      }
+
+      unsigned start = schedule_time & SCHED_WHEEL_MASK;
+      unsigned word  = start / 64;
+      uint64_t bits  = sched_wheel_map[word] & (~(uint64_t)0 << (start%64));
+
+      for (unsigned cnt = 0 ; cnt <= SCHED_WHEEL_WORDS ; cnt += 1) {
+	    if (bits != 0) {
+		  unsigned idx = word*64 + sched_lowest_bit(bits);
+		  assert(sched_wheel[idx]);
+		  return sched_wheel[idx];
+	    }
+	    word = (word + 1) % SCHED_WHEEL_WORDS;
+	    bits = sched_wheel_map[word];
+      }
+
+      assert(0);
+      return 0;
+}
+
+/*
+ * Advance the simulation time (and with it the wheel window) to the
+ * given time, then pull into the wheel any overflow time steps that
+ * are now within the window. All the time steps before the new time
+ * must already have been run and released.
+ */
+static void sched_advance_time(vvp_time64_t time)
+{
+      assert(time > schedule_time);
+      schedule_time = time;
+
+      while (! sched_overflow.empty()) {
+	    sched_overflow_t::iterator cur = sched_overflow.begin();
+	    if ((cur->first - schedule_time) >= SCHED_WHEEL_SIZE)
+		  break;
+	    sched_wheel_insert(cur->second);
+	    sched_overflow.erase(cur);
+      }
+}
 
 /*
  * This is a list of initialization events. The setup puts
@@ -683,57 +850,7 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 			    event_queue_t select_queue)
 {
       cur->next = cur;
-      struct event_time_s*ctim = sched_list;
-
-      if (sched_list == 0) {
-	      /* Is the event_time list completely empty? Create the
-		 first event_time object. */
-	    ctim = new struct event_time_s;
-	    ctim->delay = delay;
-	    ctim->next  = 0;
-	    sched_list = ctim;
-
-      } else if (sched_list->delay > delay) {
-
-	      /* Am I looking for an event before the first event_time?
-		 If so, create a new event_time to go in front. */
-	    struct event_time_s*tmp = new struct event_time_s;
-	    tmp->delay = delay;
-	    tmp->next = ctim;
-	    ctim->delay -= delay;
-	    ctim = tmp;
-	    sched_list = ctim;
-
-      } else {
-	    struct event_time_s*prev = 0;
-
-	    while (ctim->next && (ctim->delay < delay)) {
-		  delay -= ctim->delay;
-		  prev = ctim;
-		  ctim = ctim->next;
-	    }
-
-	    if (ctim->delay > delay) {
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay;
-		  tmp->next  = prev->next;
-		  prev->next = tmp;
-
-		  tmp->next->delay -= delay;
-		  ctim = tmp;
-
-	    } else if (ctim->delay == delay) {
-
-	    } else {
-		  assert(ctim->next == 0);
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay - ctim->delay;
-		  tmp->next = 0;
-		  ctim->next = tmp;
-
-		  ctim = tmp;
-	    }
-      }
+      struct event_time_s*ctim = sched_find_time(schedule_time + delay);
 
 	/* By this point, ctim is the event_time structure that is to
 	   receive the event at hand. Put the event in to the
@@ -784,13 +901,12 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 
 static void schedule_event_push_(struct event_s*cur)
 {
-      if ((sched_list == 0) || (sched_list->delay > 0)) {
+      struct event_time_s*ctim = sched_wheel[schedule_time & SCHED_WHEEL_MASK];
+      if (ctim == 0) {
 	    schedule_event_(cur, 0, SEQ_ACTIVE);
 	    return;
       }
 
-      struct event_time_s*ctim = sched_list;
-
       if (ctim->active == 0) {
 	    cur->next = cur;
 	    ctim->active = cur;
@@ -1043,7 +1159,6 @@ void schedule_at_end_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay)
       schedule_event_(cur, delay, SEQ_RWSYNC);
 }
 
-static vvp_time64_t schedule_time;
 vvp_time64_t schedule_simtime(void)
 { return schedule_time; }
 
@@ -1100,12 +1215,257 @@ static void run_rosync(struct event_time_s*ctim)
       }
 }
 
+/*
+ * Parallel evaluation of functor events.
+ *
+ * Gates whose output is pending in the active queue have already
+ * latched their inputs, so their outputs can be calculated in any
+ * order, and in parallel, as long as the results are propagated in
+ * the original queue order. When enabled, the scheduler looks ahead
+ * in the active queue, collects the functors that can_precompute()
+ * and has a pool of worker threads (plus the main thread) call their
+ * precompute() methods. The workers claim chunks of the batch from a
+ * shared index, so a thread that finishes early takes over work that
+ * would otherwise wait for a slower thread. The events are then run
+ * in order by the main thread as usual, and run_run() only needs to
+ * propagate the precomputed value.
+ *
+ * The results are kept in the batch, not in the functors, so that the
+ * functors do not get bigger for a feature that is rarely used. The
+ * events run in the order they were collected, so the entry of the
+ * functor whose event is being run is always the next one in the
+ * batch. A functor that receives a new input before its event is run
+ * reports it with schedule_precomputed_stale(), which marks its entry
+ * invalid. Looking up that entry needs an index by functor, which is
+ * only built the first time it is needed for a batch.
+ *
+ * Only this look-ahead is done in parallel. Propagation, thread
+ * execution and VPI callbacks all stay on the main thread, so the
+ * Verilog event ordering is unchanged.
+ */
+static unsigned sched_par_threads = 0;
+  // Number of events to run before looking ahead again.
+static unsigned sched_par_horizon = 0;
+
+struct sched_par_item_s {
+      vvp_gen_event_t obj;
+      vvp_vector4_t result;
+      bool valid;
+};
+static std::vector<sched_par_item_s> sched_par_batch;
+  // The entry of the next batch event to run.
+static size_t sched_par_cursor = 0;
+  // The batch entries sorted by functor, or empty if not built yet.
+static std::vector<std::pair<vvp_gen_event_t,size_t> > sched_par_index;
+
+static const unsigned SCHED_PAR_WINDOW = 16384;
+static const unsigned SCHED_PAR_MIN_BATCH = 256;
+static const size_t SCHED_PAR_CHUNK = 64;
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_t*sched_par_workers = 0;
+static pthread_mutex_t sched_par_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sched_par_start_sig = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t sched_par_done_sig = PTHREAD_COND_INITIALIZER;
+static unsigned long sched_par_generation = 0;
+static size_t sched_par_next = 0;
+static unsigned sched_par_busy = 0;
+static bool sched_par_quit = false;
+
+static void sched_par_drain(void)
+{
+      size_t cnt = sched_par_batch.size();
+      for (;;) {
+	    pthread_mutex_lock(&sched_par_mutex);
+	    size_t base = sched_par_next;
+	    sched_par_next += SCHED_PAR_CHUNK;
+	    pthread_mutex_unlock(&sched_par_mutex);
+
+	    if (base >= cnt)
+		  break;
+
+	    size_t end = base + SCHED_PAR_CHUNK;
+	    if (end > cnt)
+		  end = cnt;
+	    for (size_t idx = base ; idx < end ; idx += 1) {
+		  sched_par_item_s&item = sched_par_batch[idx];
+		  item.obj->precompute(item.result);
+		  item.valid = true;
+	    }
+      }
+}
+
+static void* sched_par_worker(void*)
+{
+      unsigned long seen = 0;
+
+      pthread_mutex_lock(&sched_par_mutex);
+      for (;;) {
+	    while (!sched_par_quit && seen == sched_par_generation)
+		  pthread_cond_wait(&sched_par_start_sig, &sched_par_mutex);
+	    if (sched_par_quit)
+		  break;
+
+	    seen = sched_par_generation;
+	    pthread_mutex_unlock(&sched_par_mutex);
+
+	    sched_par_drain();
+
+	    pthread_mutex_lock(&sched_par_mutex);
+	    sched_par_busy -= 1;
+	    if (sched_par_busy == 0)
+		  pthread_cond_signal(&sched_par_done_sig);
+      }
+      pthread_mutex_unlock(&sched_par_mutex);
+      return 0;
+}
+
+static void sched_par_start(void)
+{
+      if (sched_par_threads < 2)
+	    return;
+
+      sched_par_quit = false;
+      sched_par_workers = new pthread_t[sched_par_threads-1];
+      for (unsigned idx = 0 ; idx < sched_par_threads-1 ; idx += 1) {
+	    int rc = pthread_create(sched_par_workers+idx, 0,
+				    sched_par_worker, 0);
+	    if (rc != 0) {
+		  cerr << "Warning: Unable to start thread for parallel "
+		       << "evaluation, using " << (idx+1)
+		       << " thread(s)." << endl;
+		  sched_par_threads = idx + 1;
+		  break;
+	    }
+      }
+}
+
+static void sched_par_stop(void)
+{
+      if (sched_par_workers == 0)
+	    return;
+
+      pthread_mutex_lock(&sched_par_mutex);
+      sched_par_quit = true;
+      pthread_cond_broadcast(&sched_par_start_sig);
+      pthread_mutex_unlock(&sched_par_mutex);
+
+      for (unsigned idx = 0 ; idx < sched_par_threads-1 ; idx += 1)
+	    pthread_join(sched_par_workers[idx], 0);
+
+      delete[]sched_par_workers;
+      sched_par_workers = 0;
+      sched_par_threads = 0;
+}
+
+static void sched_par_run_batch(void)
+{
+      pthread_mutex_lock(&sched_par_mutex);
+      sched_par_next = 0;
+      sched_par_busy = sched_par_threads - 1;
+      sched_par_generation += 1;
+      pthread_cond_broadcast(&sched_par_start_sig);
+      pthread_mutex_unlock(&sched_par_mutex);
+
+      sched_par_drain();
+
+      pthread_mutex_lock(&sched_par_mutex);
+      while (sched_par_busy > 0)
+	    pthread_cond_wait(&sched_par_done_sig, &sched_par_mutex);
+      pthread_mutex_unlock(&sched_par_mutex);
+}
+#else
+static void sched_par_start(void) { }
+static void sched_par_stop(void) { }
+static void sched_par_run_batch(void) { }
+#endif
+
+void schedule_set_parallel(unsigned nthreads)
+{
+#ifdef HAVE_LIBPTHREAD
+      sched_par_threads = nthreads;
+#else
+      if (nthreads > 1)
+	    cerr << "Warning: This vvp was built without thread support, "
+		 << "parallel evaluation is disabled." << endl;
+#endif
+}
+
+/*
+ * Scan the active list (the argument points to the last event) and
+ * precompute the functors found there, if there are enough of them to
+ * make it worth waking the workers. Return the number of events that
+ * were looked at.
+ */
+static unsigned sched_par_scan(struct event_s*list)
+{
+      struct event_s*head = list->next;
+      struct event_s*cur = head;
+      unsigned cnt = 0;
+
+      sched_par_batch.clear();
+      sched_par_index.clear();
+      sched_par_cursor = 0;
+      do {
+	    vvp_gen_event_t obj = cur->gen_obj();
+	    if (obj && obj->can_precompute()) {
+		  sched_par_batch.push_back(sched_par_item_s());
+		  sched_par_batch.back().obj = obj;
+		  sched_par_batch.back().valid = false;
+	    }
+	    cnt += 1;
+	    cur = cur->next;
+      } while (cur != head && cnt < SCHED_PAR_WINDOW);
+
+      if (sched_par_batch.size() >= SCHED_PAR_MIN_BATCH) {
+	    sched_par_run_batch();
+	    count_parallel_batches += 1;
+	    count_parallel_events += sched_par_batch.size();
+      } else {
+	    sched_par_batch.clear();
+      }
+
+      return cnt;
+}
+
+const vvp_vector4_t* schedule_precomputed(vvp_gen_event_t obj)
+{
+      if (sched_par_cursor >= sched_par_batch.size())
+	    return 0;
+
+      sched_par_item_s&item = sched_par_batch[sched_par_cursor];
+      if (item.obj != obj)
+	    return 0;
+
+      sched_par_cursor += 1;
+      return item.valid? &item.result : 0;
+}
+
+void schedule_precomputed_stale(vvp_gen_event_t obj)
+{
+      if (sched_par_cursor >= sched_par_batch.size())
+	    return;
+
+      if (sched_par_index.empty()) {
+	    sched_par_index.reserve(sched_par_batch.size());
+	    for (size_t idx = 0 ; idx < sched_par_batch.size() ; idx += 1)
+		  sched_par_index.push_back(std::make_pair(sched_par_batch[idx].obj, idx));
+	    std::sort(sched_par_index.begin(), sched_par_index.end());
+      }
+
+      std::vector<std::pair<vvp_gen_event_t,size_t> >::iterator cur
+	    = std::lower_bound(sched_par_index.begin(), sched_par_index.end(),
+			       std::make_pair(obj, (size_t)0));
+      if (cur != sched_par_index.end() && cur->first == obj)
+	    sched_par_batch[cur->second].valid = false;
+}
+
 void schedule_simulate(void)
 {
       bool run_finals;
       sim_started = false;
 
-      schedule_time = 0;
+      assert(schedule_time == 0);
 
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ...execute EndOfCompile callbacks\n");
@@ -1119,6 +1479,7 @@ void schedule_simulate(void)
       }
 
 	// Execute initialization events.
+      double start = stat_phase_flag ? stat_time_now() : 0.0;
       while (schedule_init_list) {
 	    struct event_s*cur = schedule_init_list->next;
 	    if (cur->next == cur) {
@@ -1126,9 +1487,12 @@ void schedule_simulate(void)
 	    } else {
 		  schedule_init_list->next = cur->next;
 	    }
+	    count_init_events += 1;
 	    cur->run_run();
 	    delete cur;
       }
+      if (stat_phase_flag)
+	    stat_phase_end(STAT_PHASE_INIT_EVENTS, start);
 
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ...execute StartOfSim callbacks\n");
@@ -1140,16 +1504,24 @@ void schedule_simulate(void)
       sim_started = true;
 
       signals_capture();
+      sched_par_start();
 
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ...run scheduler\n");
       }
 
+      if (stat_phase_flag)
+	    start = stat_time_now();
+
       // If there were no compiletf, etc. errors then we are going to
       // process events and when done run the final blocks.
       run_finals = schedule_runnable;
 
-      if (schedule_runnable) while (sched_list) {
+      if (schedule_runnable) for (;;) {
+
+	      /* ctim is the current time step. */
+	    struct event_time_s*ctim = sched_first_time();
+	    if (ctim == 0) break;
 
 	    if (schedule_stopped_flag) {
 		  schedule_stopped_flag = false;
@@ -1159,22 +1531,18 @@ void schedule_simulate(void)
 		  continue;
 	    }
 
-	      /* ctim is the current time step. */
-	    struct event_time_s* ctim = sched_list;
-
 	      /* If the time is advancing, then first run the
 		 postponed sync events. Run them all. */
-	    if (ctim->delay > 0) {
+	    if (ctim->time > schedule_time) {
 
 		  if (!schedule_runnable) break;
-		  schedule_time += ctim->delay;
+		  sched_advance_time(ctim->time);
 		    /* When the design is being traced (we are emitting
 		     * file/line information) also print any time changes. */
 		  if (show_file_line) {
 			cerr << "Advancing to simulation time: "
 			     << schedule_time << endl;
 		  }
-		  ctim->delay = 0;
 
 		  vpiNextSimTime();
 		    // Process the cbAtStartOfSimTime callbacks.
@@ -1211,7 +1579,7 @@ void schedule_simulate(void)
 				   deletes threads as needed. */
 			      if (ctim->active == 0) {
 				    run_rosync(ctim);
-				    sched_list = ctim->next;
+				    sched_wheel_remove(ctim);
 				    delete ctim;
 				    continue;
 			      }
@@ -1219,12 +1587,22 @@ void schedule_simulate(void)
 		  }
 	    }
 
+	      /* Look ahead for functors that can be evaluated in
+		 parallel. This is only done again after the events
+		 already looked at have been run. */
+	    if (sched_par_threads > 1) {
+		  if (sched_par_horizon == 0)
+			sched_par_horizon = sched_par_scan(ctim->active);
+		  sched_par_horizon -= 1;
+	    }
+
 	      /* Pull the first item off the list. If this is the last
 		 cell in the list, then clear the list. Execute that
 		 event type, and delete it. */
 	    struct event_s*cur = ctim->active->next;
 	    if (cur->next == cur) {
 		  ctim->active = 0;
+		  sched_par_horizon = 0;
 	    } else {
 		  ctim->active->next = cur->next;
 	    }
@@ -1235,11 +1613,22 @@ void schedule_simulate(void)
 		  schedule_single_step_flag = false;
 	    }
 
-	    cur->run_run();
+	    if (profile_flag) {
+		  profile_event = &cur->profile_type();
+		  cur->run_run();
+		  profile_event = 0;
+	    } else {
+		  cur->run_run();
+	    }
 
 	    delete (cur);
       }
 
+      sched_par_stop();
+
+      if (stat_phase_flag)
+	    stat_phase_end(STAT_PHASE_SIMULATE, start);
+
 	// Execute final events.
       schedule_runnable = run_finals;
       while (schedule_runnable && schedule_final_list) {
@@ -158,8 +158,37 @@ struct vvp_gen_event_s
       virtual ~vvp_gen_event_s() =0;
       virtual void run_run() =0;
       virtual void single_step_display(void);
+
+	// Objects that can calculate their next output without touching
+	// any shared state return true from can_precompute(). When the
+	// parallel scheduler is enabled, precompute() may then be called
+	// from a worker thread while the event waits in the active queue.
+	// The scheduler keeps the result, and run_run() gets it back
+	// with schedule_precomputed().
+      virtual bool can_precompute(void) const;
+      virtual void precompute(vvp_vector4_t&result) const;
 };
 
+/*
+ * Return the value precomputed for obj, whose event is being run, or
+ * nil if there is none. Objects that can be precomputed call this
+ * from their run_run() method.
+ */
+extern const vvp_vector4_t* schedule_precomputed(vvp_gen_event_t obj);
+
+/*
+ * Objects that can be precomputed call this when their inputs change
+ * while their event is pending, so that any value precomputed for the
+ * event is dropped.
+ */
+extern void schedule_precomputed_stale(vvp_gen_event_t obj);
+
+/*
+ * Set the number of threads (including the main thread) that are used
+ * to precompute functor events. A value less than 2 disables this.
+ */
+extern void schedule_set_parallel(unsigned nthreads);
+
 /*
  * This runs the simulator. It runs until all the functors run out or
  * the simulation is otherwise finished.
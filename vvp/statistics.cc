@@ -17,12 +17,25 @@
  *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+# include  "config.h"
 # include  "statistics.h"
+# include  <cstdio>
+# include  <ctime>
+# include  <map>
+# include  <string>
+#if defined(HAVE_SYS_RESOURCE_H)
+# include  <sys/time.h>
+# include  <sys/resource.h>
+#endif
+#if defined(LINUX)
+# include  <unistd.h>
+#endif
 
 /*
  * This is a count of the instruction opcodes that were created.
  */
 unsigned long count_opcodes = 0;
+unsigned long count_opcodes_fused = 0;
 
 unsigned long count_functors = 0;
 unsigned long count_functors_logic = 0;
@@ -37,3 +50,173 @@ unsigned long count_vpi_scopes = 0;
 
 size_t size_opcodes = 0;
 
+
+unsigned long count_resolv_items = 0;
+unsigned long count_init_events = 0;
+
+bool stat_phase_flag = false;
+
+struct stat_phase_s {
+      const char*name;
+      double seconds;
+      bool sampled;
+      long peak_kb;
+      long rss_kb;
+};
+
+static stat_phase_s stat_phases[STAT_PHASE_COUNT] = {
+      { "vpi_modules", 0.0, false, 0, 0 },
+      { "lex",         0.0, false, 0, 0 },
+      { "parse",       0.0, false, 0, 0 },
+      { "resolve",     0.0, false, 0, 0 },
+      { "cleanup",     0.0, false, 0, 0 },
+      { "init_events", 0.0, false, 0, 0 },
+      { "simulate",    0.0, false, 0, 0 }
+};
+
+struct stat_statement_s {
+      unsigned long count;
+      double seconds;
+};
+
+static std::map<std::string,stat_statement_s> stat_statements;
+static std::string stat_cur_kind;
+static double stat_cur_start = 0.0;
+
+double stat_time_now(void)
+{
+#if defined(HAVE_SYS_RESOURCE_H)
+      struct timeval tv;
+      gettimeofday(&tv, 0);
+      return tv.tv_sec + tv.tv_usec/1E6;
+#else
+      return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/*
+ * Get the peak and current resident set size in KBytes. The current
+ * size is only available on Linux, otherwise it is left as 0.
+ */
+static void stat_memory(long&peak_kb, long&rss_kb)
+{
+      peak_kb = 0;
+      rss_kb = 0;
+#if defined(HAVE_SYS_RESOURCE_H)
+      struct rusage usage;
+      if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#  if defined(__APPLE__)
+	    peak_kb = usage.ru_maxrss / 1024;
+#  else
+	    peak_kb = usage.ru_maxrss;
+#  endif
+      }
+#endif
+#if defined(LINUX)
+      if (FILE*statm = fopen("/proc/self/statm", "r")) {
+	    unsigned long siz, rss;
+	    if (2 == fscanf(statm, "%lu %lu", &siz, &rss))
+		  rss_kb = rss * (sysconf(_SC_PAGESIZE) / 1024);
+	    fclose(statm);
+      }
+#endif
+}
+
+void stat_phase_add(stat_phase_t phase, double seconds)
+{
+      stat_phases[phase].seconds += seconds;
+}
+
+void stat_phase_end(stat_phase_t phase, double start)
+{
+      stat_phase_s&cur = stat_phases[phase];
+      cur.seconds += stat_time_now() - start;
+      stat_memory(cur.peak_kb, cur.rss_kb);
+      cur.sampled = true;
+}
+
+void stat_statement_begin(const char*kind)
+{
+      double now = stat_time_now();
+      if (! stat_cur_kind.empty()) {
+	    stat_statement_s&cur = stat_statements[stat_cur_kind];
+	    cur.count += 1;
+	    cur.seconds += now - stat_cur_start;
+      }
+
+      stat_cur_kind = kind ? kind : "";
+      stat_cur_start = now;
+}
+
+static void stat_json_string(FILE*fd, const char*text)
+{
+      fputc('"', fd);
+      for (const char*cp = text ; *cp ; cp += 1) {
+	    switch (*cp) {
+		case '"':
+		  fputs("\\\"", fd);
+		  break;
+		case '\\':
+		  fputs("\\\\", fd);
+		  break;
+		default:
+		  if ((unsigned char)*cp < 0x20)
+			fprintf(fd, "\\u%04x", (unsigned char)*cp);
+		  else
+			fputc(*cp, fd);
+		  break;
+	    }
+      }
+      fputc('"', fd);
+}
+
+void stat_phase_report(const char*path, const char*design)
+{
+      FILE*fd = fopen(path, "w");
+      if (fd == 0) {
+	    perror(path);
+	    return;
+      }
+
+	// The lexor is called from the parser, so take its time out
+	// of the parse time.
+      double parse = stat_phases[STAT_PHASE_PARSE].seconds
+		   - stat_phases[STAT_PHASE_LEX].seconds;
+
+      fprintf(fd, "{\n  \"design\": ");
+      stat_json_string(fd, design);
+      fprintf(fd, ",\n  \"phases\": [");
+      for (unsigned idx = 0 ; idx < STAT_PHASE_COUNT ; idx += 1) {
+	    const stat_phase_s&cur = stat_phases[idx];
+	    double seconds = idx == STAT_PHASE_PARSE ? parse : cur.seconds;
+	    fprintf(fd, "%s\n    { \"name\": \"%s\", \"seconds\": %.6f",
+		    idx ? "," : "", cur.name, seconds);
+	    if (cur.sampled)
+		  fprintf(fd, ", \"peak_rss_kb\": %ld, \"rss_kb\": %ld",
+			  cur.peak_kb, cur.rss_kb);
+	    fprintf(fd, " }");
+      }
+      fprintf(fd, "\n  ],\n  \"statements\": [");
+
+      bool first = true;
+      std::map<std::string,stat_statement_s>::const_iterator cur;
+      for (cur = stat_statements.begin() ; cur != stat_statements.end() ; ++ cur) {
+	    fprintf(fd, "%s\n    { \"kind\": ", first ? "" : ",");
+	    stat_json_string(fd, cur->first.c_str());
+	    fprintf(fd, ", \"count\": %lu, \"seconds\": %.6f }",
+		    cur->second.count, cur->second.seconds);
+	    first = false;
+      }
+
+      fprintf(fd, "\n  ],\n  \"counts\": {\n");
+      fprintf(fd, "    \"functors\": %lu,\n", count_functors);
+      fprintf(fd, "    \"filters\": %lu,\n", count_filters);
+      fprintf(fd, "    \"opcodes\": %lu,\n", count_opcodes);
+      fprintf(fd, "    \"vvp_nets\": %lu,\n", count_vvp_nets);
+      fprintf(fd, "    \"vpi_nets\": %lu,\n", count_vpi_nets);
+      fprintf(fd, "    \"vpi_scopes\": %lu,\n", count_vpi_scopes);
+      fprintf(fd, "    \"resolve_items\": %lu,\n", count_resolv_items);
+      fprintf(fd, "    \"init_events\": %lu\n", count_init_events);
+      fprintf(fd, "  }\n}\n");
+      fclose(fd);
+}
@@ -27,11 +27,14 @@
 #endif
 
 extern unsigned long count_opcodes;
+extern unsigned long count_opcodes_fused;
 extern unsigned long count_functors;
 extern unsigned long count_functors_logic;
 extern unsigned long count_functors_bufif;
 extern unsigned long count_functors_resolv;
 extern unsigned long count_functors_sig;
+extern unsigned long count_cones;
+extern unsigned long count_cone_nodes;
 extern unsigned long count_filters;
 extern unsigned long count_vvp_nets;
 extern unsigned long count_vpi_nets;
@@ -46,6 +49,8 @@ extern unsigned long count_real_array_words;
 
 
 extern unsigned long count_time_events;
+extern unsigned long count_parallel_batches;
+extern unsigned long count_parallel_events;
 extern unsigned long count_time_pool(void);
 
 extern unsigned long count_assign_events;
@@ -62,4 +67,43 @@ extern size_t size_opcodes;
 extern size_t size_vvp_nets;
 extern size_t size_vvp_net_funs;
 
+extern unsigned long count_resolv_items;
+extern unsigned long count_init_events;
+
+/*
+ * Load phase timing for the -T report. The phases are timed only if
+ * stat_phase_flag is set. stat_phase_end() adds the time since start
+ * (a stat_time_now() value) to the phase and samples the memory use.
+ * stat_phase_add() only adds time, for phases (like the lexor) that
+ * are entered many times.
+ */
+enum stat_phase_t {
+      STAT_PHASE_VPI_MODULES = 0,
+      STAT_PHASE_LEX,
+      STAT_PHASE_PARSE,
+      STAT_PHASE_RESOLVE,
+      STAT_PHASE_CLEANUP,
+      STAT_PHASE_INIT_EVENTS,
+      STAT_PHASE_SIMULATE,
+      STAT_PHASE_COUNT
+};
+
+extern bool stat_phase_flag;
+
+extern double stat_time_now(void);
+extern void stat_phase_add(stat_phase_t phase, double seconds);
+extern void stat_phase_end(stat_phase_t phase, double start);
+
+/*
+ * The parse time is also broken down by the kind of statement. Each
+ * call closes the interval of the previous statement kind and starts
+ * a new one. Call with a nil kind at the end of the input.
+ */
+extern void stat_statement_begin(const char*kind);
+
+/*
+ * Write the collected timing and counts as JSON to the file.
+ */
+extern void stat_phase_report(const char*path, const char*design);
+
 #endif /* IVL_statistics_H */
@@ -82,6 +82,87 @@ ostream& operator <<(ostream&o, const struct udp_levels_table&table)
       return o;
 }
 
+/*
+ * Small UDPs have their rows compiled into lookup tables that are
+ * indexed by the input values, as digits of a base 3 number (0, 1
+ * and x are 0, 1 and 2). Larger UDPs scan the rows as usual. This is
+ * the limit on the number of entries in a table.
+ */
+static const unsigned long UDP_TABLE_LIMIT = 131072;
+
+  // The sum of 3**bit for the bits set in each possible byte value of
+  // the low two bytes of a mask. Lookup tables never have more than
+  // 16 positions.
+static unsigned long udp_digit_weight[2][256];
+
+static void udp_table_init()
+{
+      static bool done = false;
+      if (done)
+	    return;
+
+      for (unsigned byte = 0 ;  byte < 2 ;  byte += 1) {
+	    for (unsigned val = 0 ;  val < 256 ;  val += 1) {
+		  unsigned long weight = byte? 6561 : 1;
+		  unsigned long sum = 0;
+		  for (unsigned bit = 0 ;  bit < 8 ;  bit += 1) {
+			if (val & (1 << bit))
+			      sum += weight;
+			weight *= 3;
+		  }
+		  udp_digit_weight[byte][val] = sum;
+	    }
+      }
+      done = true;
+}
+
+static inline unsigned long udp_mask_weight(unsigned long mask)
+{
+      return udp_digit_weight[0][mask & 0xff]
+	   + udp_digit_weight[1][(mask >> 8) & 0xff];
+}
+
+static inline unsigned long udp_table_index(const udp_levels_table&cur)
+{
+      return udp_mask_weight(cur.mask1) + 2*udp_mask_weight(cur.maskx);
+}
+
+  // Make the levels table for the table index.
+static udp_levels_table udp_table_levels(unsigned long index, unsigned npos)
+{
+      udp_levels_table cur;
+      cur.mask0 = 0;
+      cur.mask1 = 0;
+      cur.maskx = 0;
+      for (unsigned pos = 0 ;  pos < npos ;  pos += 1) {
+	    switch (index % 3) {
+		case 0:
+		  cur.mask0 |= 1UL << pos;
+		  break;
+		case 1:
+		  cur.mask1 |= 1UL << pos;
+		  break;
+		default:
+		  cur.maskx |= 1UL << pos;
+		  break;
+	    }
+	    index /= 3;
+      }
+      return cur;
+}
+
+  // Return 3**npos, or 0 if that is more than the limit.
+static unsigned long udp_table_size(unsigned npos, unsigned long per_entry)
+{
+      unsigned long size = per_entry;
+      for (unsigned idx = 0 ;  idx < npos ;  idx += 1) {
+	    size *= 3;
+	    if (size > UDP_TABLE_LIMIT)
+		  return 0;
+      }
+      return size;
+}
+
 vvp_udp_s::vvp_udp_s(char*label, char*name__, unsigned ports,
                      vvp_bit4_t init, bool type)
 : name_(name__), ports_(ports), init_(init), seq_(type)
@@ -125,12 +206,14 @@ vvp_udp_comb_s::vvp_udp_comb_s(char*label, char*name__, unsigned ports)
       levels1_ = 0;
       nlevels0_ = 0;
       nlevels1_ = 0;
+      table_ = 0;
 }
 
 vvp_udp_comb_s::~vvp_udp_comb_s()
 {
       delete[] levels0_;
       delete[] levels1_;
+      delete[] table_;
 }
 
 /*
@@ -188,6 +271,9 @@ vvp_bit4_t vvp_udp_comb_s::calculate_output(const udp_levels_table&cur,
 					    const udp_levels_table&,
 					    vvp_bit4_t)
 {
+      if (table_)
+	    return (vvp_bit4_t) table_[udp_table_index(cur)];
+
       return test_levels(cur);
 }
 
@@ -290,6 +376,15 @@ void vvp_udp_comb_s::compile_table(char**tab)
 
       assert(nrows0 == nlevels0_);
       assert(nrows1 == nlevels1_);
+
+      unsigned long size = udp_table_size(port_count(), 1);
+      if (size == 0)
+	    return;
+
+      udp_table_init();
+      table_ = new unsigned char[size];
+      for (unsigned long idx = 0 ;  idx < size ;  idx += 1)
+	    table_[idx] = test_levels(udp_table_levels(idx, port_count()));
 }
 
 vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name__,
@@ -313,6 +408,8 @@ vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name__,
       nedges0_ = 0;
       nedges1_ = 0;
       nedgesL_ = 0;
+
+      table_ = 0;
 }
 
 vvp_udp_seq_s::~vvp_udp_seq_s()
@@ -324,6 +421,7 @@ vvp_udp_seq_s::~vvp_udp_seq_s()
       delete[] edges0_;
       delete[] edges1_;
       delete[] edgesL_;
+      delete[] table_;
 }
 
 void edge_based_on_char(struct udp_edges_table&cur, char chr, unsigned pos)
@@ -670,6 +768,54 @@ void vvp_udp_seq_s::compile_table(char**tab)
       assert(idx_edg1 == nedges1_);
       assert(idx_edgL == nedgesL_);
 
+      compile_lookup_table_();
+}
+
+void vvp_udp_seq_s::compile_lookup_table_()
+{
+      unsigned ports = port_count();
+      unsigned long stride = 1 + 2*ports;
+      unsigned long size = udp_table_size(ports+1, stride);
+      if (size == 0)
+	    return;
+
+      udp_table_init();
+      table_ = new unsigned char[size];
+
+      for (unsigned long idx = 0 ;  idx < size/stride ;  idx += 1) {
+	    udp_levels_table cur = udp_table_levels(idx, ports+1);
+	    unsigned char*entry = table_ + idx*stride;
+
+	    entry[0] = test_levels_(cur);
+
+	    for (unsigned pos = 0 ;  pos < ports ;  pos += 1) {
+		  unsigned long mask = 1UL << pos;
+		  udp_levels_table prev = cur;
+		  prev.mask0 &= ~mask;
+		  prev.mask1 &= ~mask;
+		  prev.maskx &= ~mask;
+
+		    // The two other values of the input, in the order
+		    // 0, 1, x.
+		  unsigned slot = 1 + 2*pos;
+		  if (! (cur.mask0 & mask)) {
+			udp_levels_table tmp = prev;
+			tmp.mask0 |= mask;
+			entry[slot++] = test_edges_(cur, tmp);
+		  }
+		  if (! (cur.mask1 & mask)) {
+			udp_levels_table tmp = prev;
+			tmp.mask1 |= mask;
+			entry[slot++] = test_edges_(cur, tmp);
+		  }
+		  if (! (cur.maskx & mask)) {
+			udp_levels_table tmp = prev;
+			tmp.maskx |= mask;
+			entry[slot++] = test_edges_(cur, tmp);
+		  }
+		  assert(slot == 3 + 2*pos);
+	    }
+      }
 }
 
 bool operator == (const udp_levels_table&a, const udp_levels_table&b)
@@ -705,6 +851,34 @@ vvp_bit4_t vvp_udp_seq_s::calculate_output(const udp_levels_table&cur,
 	    break;
       }
 
+      if (table_) {
+	    const unsigned char*entry = table_
+		  + udp_table_index(cur_tmp) * (1 + 2*port_count());
+	    if (entry[0] != BIT4_Z)
+		  return (vvp_bit4_t) entry[0];
+
+	    unsigned long edge_mask = (cur.mask0 ^ prev.mask0)
+		  | (cur.mask1 ^ prev.mask1)
+		  | (cur.maskx ^ prev.maskx);
+	    unsigned pos = 0;
+	    while ((edge_mask & 1) == 0) {
+		  edge_mask >>= 1;
+		  pos += 1;
+	    }
+	      /* We expect that there is exactly one edge in here. */
+	    assert(edge_mask == 1);
+
+	      // Select the entry for the previous value of the input
+	      // out of the two that are not the current value.
+	    unsigned long mask = 1UL << pos;
+	    unsigned slot = 1 + 2*pos;
+	    if (prev.maskx & mask)
+		  slot += 1;
+	    else if ((prev.mask1 & mask) && (cur.maskx & mask))
+		  slot += 1;
+	    return (vvp_bit4_t) entry[slot];
+      }
+
       vvp_bit4_t lev = test_levels_(cur_tmp);
       if (lev == BIT4_Z) {
 	    lev = test_edges_(cur_tmp, prev);
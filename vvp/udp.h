@@ -131,6 +131,10 @@ class vvp_udp_comb_s : public vvp_udp_s {
       struct udp_levels_table*levels0_;
       struct udp_levels_table*levels1_;
       unsigned nlevels0_, nlevels1_;
+
+	// If the device is small enough, the output for every
+	// combination of inputs is compiled into this table.
+      unsigned char*table_;
 };
 
 /*
@@ -202,12 +206,20 @@ class vvp_udp_seq_s : public vvp_udp_s {
       vvp_bit4_t test_edges_(const udp_levels_table&cur,
 			     const udp_levels_table&prev);
 
+      void compile_lookup_table_();
+
 	// Edge sensitive rows of the device
       struct udp_edges_table*edges0_;
       struct udp_edges_table*edges1_;
       struct udp_edges_table*edgesL_;
       unsigned nedges0_, nedges1_, nedgesL_;
 
+	// If the device is small enough, the rows are compiled into
+	// this table. Each combination of inputs and current output
+	// has an entry for the levels result (Z if no level row
+	// matches) followed by two entries for each input, which are
+	// the results for an edge from either of the other two values.
+      unsigned char*table_;
 };
 
 /*
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2020 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * This file implements the vpip_batch_* extension, which reads and
+ * writes the values of a list of vector signals in one call. The
+ * handles are checked and the layout of the value array is worked out
+ * once, when the batch is created. After that, a read gets the packed
+ * a/b words of each signal straight from its vvp_signal_value, and a
+ * write sends the value straight to the signal node, so there is no
+ * per-signal result buffer or virtual vpi_get_value/vpi_put_value.
+ */
+
+# include  "vpi_priv.h"
+# include  "vvp_net_sig.h"
+# include  "vvp_island.h"
+# include  "schedule.h"
+# include  "vthread.h"
+# include  <vector>
+# include  <cstdio>
+# include  <cassert>
+
+using namespace std;
+
+struct __vpipBatch {
+      struct item_s {
+	    __vpiSignal*sig;
+	    vvp_signal_value*val;
+	    unsigned wid;
+	      // Offset of the first s_vpi_vecval of the signal.
+	    unsigned vec_off;
+	      // Offset of the words of the signal in the last array.
+	    unsigned word_off;
+	      // Send the value to the node, instead of to its input.
+	    bool send_node;
+      };
+
+      std::vector<item_s> items;
+      unsigned vec_cnt;
+	// The a/b words of each signal at the last vpip_batch_get,
+	// for detecting changes. The a words of each signal are
+	// followed by the b words.
+      std::vector<unsigned long> last;
+      bool last_valid;
+	// Scratch words for getting the value of a signal.
+      std::vector<unsigned long> words;
+};
+
+static const unsigned WORD_BITS = 8*sizeof(unsigned long);
+
+extern "C" vpipBatch vpip_batch_create(vpiHandle*list, unsigned count)
+{
+      vpipBatch batch = new __vpipBatch;
+      batch->items.resize(count);
+      batch->vec_cnt = 0;
+      batch->last_valid = false;
+
+      unsigned word_cnt = 0;
+      unsigned max_words = 1;
+      for (unsigned idx = 0 ;  idx < count ;  idx += 1) {
+	    __vpiSignal*sig = dynamic_cast<__vpiSignal*>(list[idx]);
+	    vvp_signal_value*val = sig
+		  ? dynamic_cast<vvp_signal_value*>(sig->node->fil)
+		  : 0;
+	    if (val == 0) {
+		  fprintf(stderr, "VPI error: vpip_batch_create: item %u "
+			  "is not a vector net or variable.\n", idx);
+		  delete batch;
+		  return 0;
+	    }
+
+	    __vpipBatch::item_s&cur = batch->items[idx];
+	    cur.sig = sig;
+	    cur.val = val;
+	    cur.wid = val->value_size();
+	    cur.vec_off = batch->vec_cnt;
+	    cur.word_off = word_cnt;
+	    cur.send_node = sig->get_type_code() == vpiNet
+		  && ! dynamic_cast<vvp_island_port*>(sig->node->fun);
+
+	    unsigned nwords = (cur.wid + WORD_BITS - 1) / WORD_BITS;
+	    batch->vec_cnt += (cur.wid + 31) / 32;
+	    word_cnt += 2*nwords;
+	    if (2*nwords > max_words)
+		  max_words = 2*nwords;
+      }
+
+      batch->last.resize(word_cnt);
+      batch->words.resize(max_words);
+      return batch;
+}
+
+extern "C" unsigned vpip_batch_size(vpipBatch batch)
+{
+      assert(batch);
+      return batch->vec_cnt;
+}
+
+extern "C" void vpip_batch_get(vpipBatch batch, s_vpi_vecval*buf,
+			       PLI_UINT32*changed)
+{
+      assert(batch);
+
+      unsigned count = batch->items.size();
+      if (changed) {
+	    for (unsigned idx = 0 ;  idx < (count+31)/32 ;  idx += 1)
+		  changed[idx] = 0;
+      }
+
+      for (unsigned idx = 0 ;  idx < count ;  idx += 1) {
+	    const __vpipBatch::item_s&cur = batch->items[idx];
+	    unsigned nwords = (cur.wid + WORD_BITS - 1) / WORD_BITS;
+	    unsigned long*abits = &batch->words[0];
+	    unsigned long*bbits = abits + nwords;
+	    cur.val->vec4_words(0, cur.wid, abits, bbits);
+
+	    unsigned long*last = nwords? &batch->last[cur.word_off] : 0;
+	    bool diff = ! batch->last_valid;
+	    for (unsigned wdx = 0 ;  wdx < 2*nwords ;  wdx += 1) {
+		  if (last[wdx] != abits[wdx]) {
+			last[wdx] = abits[wdx];
+			diff = true;
+		  }
+	    }
+	    if (changed && diff)
+		  changed[idx/32] |= 1U << (idx%32);
+
+	    s_vpi_vecval*op = buf + cur.vec_off;
+	    for (unsigned wdx = 0 ;  wdx < (cur.wid+31)/32 ;  wdx += 1) {
+		  unsigned pos = wdx * 32;
+		  unsigned long aval = abits[pos/WORD_BITS] >> (pos%WORD_BITS);
+		  unsigned long bval = bbits[pos/WORD_BITS] >> (pos%WORD_BITS);
+		  op[wdx].aval = aval & 0xffffffffUL;
+		  op[wdx].bval = bval & 0xffffffffUL;
+	    }
+      }
+
+      batch->last_valid = true;
+}
+
+extern "C" void vpip_batch_put(vpipBatch batch, const s_vpi_vecval*buf,
+			       const PLI_UINT32*mask)
+{
+      assert(batch);
+
+      if (schedule_at_rosync()) {
+	    fprintf(stderr, "VPI error: attempted to put batch values "
+		    "during a read-only synch callback.\n");
+	    return;
+      }
+
+      for (unsigned idx = 0 ;  idx < batch->items.size() ;  idx += 1) {
+	    if (mask && ! (mask[idx/32] & (1U << (idx%32))))
+		  continue;
+
+	    const __vpipBatch::item_s&cur = batch->items[idx];
+	    s_vpi_value value;
+	    value.format = vpiVectorVal;
+	    value.value.vector = const_cast<s_vpi_vecval*>(buf + cur.vec_off);
+	    vvp_vector4_t val = vec4_from_vpi_value(&value, cur.wid);
+
+	      // This matches the vpiNoDelay case of vpi_put_value for
+	      // a signal.
+	    if (cur.send_node) {
+		  cur.sig->node->send_vec4(val, vthread_get_wt_context());
+	    } else {
+		  vvp_net_ptr_t dest (cur.sig->node, 0);
+		  vvp_send_vec4(dest, val, vthread_get_wt_context());
+	    }
+      }
+}
+
+extern "C" void vpip_batch_free(vpipBatch batch)
+{
+      delete batch;
+}
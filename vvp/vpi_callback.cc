@@ -820,12 +820,9 @@ void vvp_signal_value::get_signal_value(struct t_vpi_value*vp)
 	  case vpiVectorVal:
 	  case vpiStringVal:
 	  case vpiRealVal: {
-	    unsigned wid = value_size();
-	    vvp_vector4_t vec4(wid);
-	    for (unsigned idx = 0; idx < wid; idx += 1) {
-		  vec4.set_bit(idx, value(idx));
-	    }
-	    vpip_vec4_get_value(vec4, wid, false, vp);
+	    vvp_vector4_t vec4;
+	    vec4_value(vec4);
+	    vpip_vec4_get_value(vec4, vec4.size(), false, vp);
 	    break;
 	  }
 
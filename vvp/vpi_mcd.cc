@@ -27,6 +27,10 @@
 # include  <cstdio>
 # include  <cstdlib>
 # include  <cstring>
+# include  <sys/stat.h>
+#ifdef HAVE_LIBPTHREAD
+# include  <pthread.h>
+#endif
 # include  "ivl_alloc.h"
 
 extern FILE* vpi_trace;
@@ -45,9 +49,35 @@ extern FILE* vpi_trace;
 #define FD_IDX(fd)	((fd)&~(1U<<31))
 #define FD_INCR		32
 
+/*
+ * The regular files that $fopen opens get a large stdio buffer. Other
+ * files (terminals, pipes, devices) keep their normal buffering. With
+ * the -b flag, regular files opened only for writing get a background
+ * writer instead: the output is collected in MCD_BUF_SIZE chunks, and
+ * full chunks are written to the file by a separate thread. Anything
+ * that uses the FILE* directly (vpi_get_file, flush, close) first
+ * waits for the writer to finish with the file, and writes out the
+ * partial chunk, so it sees the file in the same state as without -b.
+ * Standard output and the log file are always written directly.
+ */
+static const size_t MCD_BUF_SIZE = 256*1024;
+
+struct mcd_async_s {
+	  // The chunk being filled by the simulation, or nil if nothing
+	  // has been written since the last chunk was handed off.
+      char*data;
+      size_t len;
+	  // Number of chunks waiting for (or being written by) the
+	  // writer thread. This is protected by mcd_async_mutex.
+      unsigned pending;
+};
+
 typedef struct mcd_entry {
 	FILE *fp;
 	char *filename;
+	struct mcd_async_s *async;
+	  // The stdio buffer of fp, or nil if it has the default one.
+	char *vbuf;
 } mcd_entry_s;
 static mcd_entry_s mcd_table[31];
 static mcd_entry_s *fd_table = NULL;
@@ -55,6 +85,271 @@ static unsigned fd_table_len = 0;
 
 static FILE* logfile;
 
+static bool mcd_async_flag = false;
+
+#ifdef HAVE_LIBPTHREAD
+struct mcd_chunk_s {
+      FILE*fp;
+      struct mcd_async_s*async;
+      char*data;
+      size_t len;
+      struct mcd_chunk_s*next;
+};
+
+  // The writer keeps at most this many chunks in flight, so a slow
+  // disk makes the simulation wait instead of using up memory. Only
+  // this many files get a background writer, since each file that is
+  // being written holds a chunk of its own as well.
+static const unsigned MCD_MAX_CHUNKS = 16;
+static unsigned mcd_async_files = 0;
+
+static pthread_t mcd_async_thread;
+static bool mcd_async_running = false;
+static bool mcd_async_quit = false;
+static pthread_mutex_t mcd_async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mcd_async_work_sig = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t mcd_async_done_sig = PTHREAD_COND_INITIALIZER;
+static struct mcd_chunk_s*mcd_async_head = 0;
+static struct mcd_chunk_s*mcd_async_tail = 0;
+static unsigned mcd_async_count = 0;
+  // Chunk buffers that the writer is done with, for reuse.
+static char*mcd_async_free[MCD_MAX_CHUNKS];
+static unsigned mcd_async_nfree = 0;
+
+static void* mcd_async_writer(void*)
+{
+      pthread_mutex_lock(&mcd_async_mutex);
+      for (;;) {
+	    while (mcd_async_head == 0 && !mcd_async_quit)
+		  pthread_cond_wait(&mcd_async_work_sig, &mcd_async_mutex);
+	    struct mcd_chunk_s*cur = mcd_async_head;
+	    if (cur == 0)
+		  break;
+
+	    pthread_mutex_unlock(&mcd_async_mutex);
+	    fwrite(cur->data, 1, cur->len, cur->fp);
+	    pthread_mutex_lock(&mcd_async_mutex);
+
+	    mcd_async_head = cur->next;
+	    if (mcd_async_head == 0)
+		  mcd_async_tail = 0;
+	    mcd_async_count -= 1;
+	    cur->async->pending -= 1;
+	    if (mcd_async_nfree < MCD_MAX_CHUNKS)
+		  mcd_async_free[mcd_async_nfree++] = cur->data;
+	    else
+		  free(cur->data);
+	    delete cur;
+	    pthread_cond_broadcast(&mcd_async_done_sig);
+      }
+      pthread_mutex_unlock(&mcd_async_mutex);
+      return 0;
+}
+
+/*
+ * Take a chunk from the free list, or allocate a new one.
+ */
+static char* mcd_async_get_chunk(void)
+{
+      pthread_mutex_lock(&mcd_async_mutex);
+      char*data = mcd_async_nfree? mcd_async_free[--mcd_async_nfree] : 0;
+      pthread_mutex_unlock(&mcd_async_mutex);
+      return data? data : (char*)malloc(MCD_BUF_SIZE);
+}
+
+static void mcd_async_put_chunk(char*data)
+{
+      pthread_mutex_lock(&mcd_async_mutex);
+      if (mcd_async_nfree < MCD_MAX_CHUNKS) {
+	    mcd_async_free[mcd_async_nfree++] = data;
+	    data = 0;
+      }
+      pthread_mutex_unlock(&mcd_async_mutex);
+      free(data);
+}
+
+/*
+ * Give the full chunk of the entry to the writer thread. The next
+ * write takes a new chunk.
+ */
+static void mcd_async_submit(mcd_entry_s*ent)
+{
+      struct mcd_chunk_s*cur = new struct mcd_chunk_s;
+      cur->fp = ent->fp;
+      cur->async = ent->async;
+      cur->data = ent->async->data;
+      cur->len = ent->async->len;
+      cur->next = 0;
+
+      pthread_mutex_lock(&mcd_async_mutex);
+      while (mcd_async_count >= MCD_MAX_CHUNKS)
+	    pthread_cond_wait(&mcd_async_done_sig, &mcd_async_mutex);
+      if (mcd_async_tail)
+	    mcd_async_tail->next = cur;
+      else
+	    mcd_async_head = cur;
+      mcd_async_tail = cur;
+      mcd_async_count += 1;
+      ent->async->pending += 1;
+      pthread_cond_signal(&mcd_async_work_sig);
+      pthread_mutex_unlock(&mcd_async_mutex);
+
+      ent->async->data = 0;
+      ent->async->len = 0;
+}
+
+/*
+ * Wait for the writer thread to finish with the file of the entry,
+ * and write out the partial chunk. After this, the FILE* can be used
+ * directly. The chunk goes back to the free list, so a file that is
+ * not being written does not hold one.
+ */
+static void mcd_async_sync(mcd_entry_s*ent)
+{
+      if (ent->async == 0)
+	    return;
+
+      pthread_mutex_lock(&mcd_async_mutex);
+      while (ent->async->pending > 0)
+	    pthread_cond_wait(&mcd_async_done_sig, &mcd_async_mutex);
+      pthread_mutex_unlock(&mcd_async_mutex);
+
+      if (ent->async->data == 0)
+	    return;
+
+      fwrite(ent->async->data, 1, ent->async->len, ent->fp);
+      mcd_async_put_chunk(ent->async->data);
+      ent->async->data = 0;
+      ent->async->len = 0;
+}
+
+static void mcd_async_open(mcd_entry_s*ent, const char*mode)
+{
+      ent->async = 0;
+      if (!mcd_async_flag || mcd_async_files >= MCD_MAX_CHUNKS)
+	    return;
+	/* Only files that are just written can be written behind the
+	   back of the simulation. */
+      if (mode[0] == 'r' || strchr(mode, '+'))
+	    return;
+
+      if (!mcd_async_running) {
+	    mcd_async_quit = false;
+	    if (pthread_create(&mcd_async_thread, 0, mcd_async_writer, 0)) {
+		  fprintf(stderr, "Warning: Unable to start the file "
+			  "writer thread, writing files directly.\n");
+		  mcd_async_flag = false;
+		  return;
+	    }
+	    mcd_async_running = true;
+	    atexit(vpip_mcd_finish);
+      }
+
+      ent->async = new struct mcd_async_s;
+      ent->async->data = 0;
+      ent->async->len = 0;
+      ent->async->pending = 0;
+      mcd_async_files += 1;
+}
+
+static void mcd_async_close(mcd_entry_s*ent)
+{
+      if (ent->async == 0)
+	    return;
+
+      mcd_async_sync(ent);
+      delete ent->async;
+      ent->async = 0;
+      mcd_async_files -= 1;
+}
+
+static void mcd_async_write(mcd_entry_s*ent, const char*buf, size_t cnt)
+{
+      struct mcd_async_s*async = ent->async;
+      while (cnt > 0) {
+	    if (async->data == 0)
+		  async->data = mcd_async_get_chunk();
+	    size_t use = MCD_BUF_SIZE - async->len;
+	    if (use > cnt)
+		  use = cnt;
+	    memcpy(async->data + async->len, buf, use);
+	    async->len += use;
+	    buf += use;
+	    cnt -= use;
+	    if (async->len == MCD_BUF_SIZE)
+		  mcd_async_submit(ent);
+      }
+}
+#else
+static void mcd_async_sync(mcd_entry_s*) { }
+static void mcd_async_open(mcd_entry_s*ent, const char*) { ent->async = 0; }
+static void mcd_async_close(mcd_entry_s*) { }
+static void mcd_async_write(mcd_entry_s*, const char*, size_t) { }
+#endif
+
+void vpip_mcd_set_async(bool flag)
+{
+#ifdef HAVE_LIBPTHREAD
+      mcd_async_flag = flag;
+#else
+      if (flag)
+	    fprintf(stderr, "Warning: This vvp was built without thread "
+		    "support, files are written directly.\n");
+#endif
+}
+
+/*
+ * Set up a newly opened file: if it is a regular file, give it a
+ * background writer if that is enabled, or else a large buffer.
+ */
+static void mcd_setup_file(mcd_entry_s*ent, const char*mode)
+{
+      ent->async = 0;
+      ent->vbuf = 0;
+
+      struct stat sb;
+      if (fstat(fileno(ent->fp), &sb) != 0 || !S_ISREG(sb.st_mode))
+	    return;
+
+      mcd_async_open(ent, mode);
+      if (ent->async)
+	    return;
+
+      ent->vbuf = (char*)malloc(MCD_BUF_SIZE);
+      if (setvbuf(ent->fp, ent->vbuf, _IOFBF, MCD_BUF_SIZE) != 0) {
+	    free(ent->vbuf);
+	    ent->vbuf = 0;
+      }
+}
+
+/*
+ * The stdio buffer of a file can only be released after the file is
+ * closed.
+ */
+static void mcd_release_file(mcd_entry_s*ent)
+{
+      free(ent->vbuf);
+      ent->vbuf = 0;
+      free(ent->filename);
+      ent->fp = NULL;
+      ent->filename = NULL;
+}
+
+static void mcd_write(mcd_entry_s*ent, const char*buf, size_t cnt)
+{
+      if (ent->async) {
+	    mcd_async_write(ent, buf, cnt);
+	    return;
+      }
+
+      while (cnt > 0) {
+	    size_t rc = fwrite(buf, 1, cnt, ent->fp);
+	    if (rc == 0) break;
+	    cnt -= rc;
+	    buf += rc;
+      }
+}
+
 /* Initialize mcd portion of vpi.  Must be called before
  * any vpi_mcd routines can be used.
  */
@@ -65,6 +360,8 @@ void vpip_mcd_init(FILE *log)
       for (unsigned idx = 0; idx < fd_table_len; idx += 1) {
 	    fd_table[idx].fp = NULL;
 	    fd_table[idx].filename = NULL;
+	    fd_table[idx].async = NULL;
+	    fd_table[idx].vbuf = NULL;
       }
 
       mcd_table[0].fp = stdout;
@@ -80,6 +377,49 @@ void vpip_mcd_init(FILE *log)
       logfile = log;
 }
 
+/*
+ * Write out everything that the writer thread holds, and flush all
+ * the files. This is $fflush without an argument.
+ */
+extern "C" void vpip_mcd_flush_all(void)
+{
+      for (unsigned idx = 1; idx < 31; idx += 1)
+	    mcd_async_sync(&mcd_table[idx]);
+      for (unsigned idx = 0; idx < fd_table_len; idx += 1)
+	    mcd_async_sync(&fd_table[idx]);
+      fflush(NULL);
+}
+
+/*
+ * Write out everything that the writer thread holds, and stop the
+ * thread. From here on the files are written directly. This is done
+ * when the simulation is over, and also at exit in case the program
+ * is ended some other way.
+ */
+void vpip_mcd_finish(void)
+{
+#ifdef HAVE_LIBPTHREAD
+      mcd_async_flag = false;
+      if (!mcd_async_running)
+	    return;
+
+      for (unsigned idx = 1; idx < 31; idx += 1)
+	    mcd_async_close(&mcd_table[idx]);
+      for (unsigned idx = 0; idx < fd_table_len; idx += 1)
+	    mcd_async_close(&fd_table[idx]);
+
+      pthread_mutex_lock(&mcd_async_mutex);
+      mcd_async_quit = true;
+      pthread_cond_signal(&mcd_async_work_sig);
+      pthread_mutex_unlock(&mcd_async_mutex);
+      pthread_join(mcd_async_thread, 0);
+      mcd_async_running = false;
+
+      while (mcd_async_nfree > 0)
+	    free(mcd_async_free[--mcd_async_nfree]);
+#endif
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void vpi_mcd_delete(void)
 {
@@ -117,10 +457,9 @@ extern "C" PLI_UINT32 vpi_mcd_close(PLI_UINT32 mcd)
 	    for(int i = 1; i < 31; i++) {
 		  if ((mcd>>i) & 1) {
 			if (mcd_table[i].fp) {
+			      mcd_async_close(&mcd_table[i]);
 			      if (fclose(mcd_table[i].fp)) rc |= 1<<i;
-			      free(mcd_table[i].filename);
-			      mcd_table[i].fp = NULL;
-			      mcd_table[i].filename = NULL;
+			      mcd_release_file(&mcd_table[i]);
 			} else {
 			      rc |= 1<<i;
 			}
@@ -129,10 +468,9 @@ extern "C" PLI_UINT32 vpi_mcd_close(PLI_UINT32 mcd)
       } else {
 	    unsigned idx = FD_IDX(mcd);
 	    if (idx > 2 && idx < fd_table_len && fd_table[idx].fp) {
+		  mcd_async_close(&fd_table[idx]);
 		  if (fclose(fd_table[idx].fp)) rc = mcd;
-		  free(fd_table[idx].filename);
-		  fd_table[idx].fp = NULL;
-		  fd_table[idx].filename = NULL;
+		  mcd_release_file(&fd_table[idx]);
 	    } else rc = mcd;
       }
       return rc;
@@ -175,6 +513,7 @@ got_entry:
 	if(mcd_table[i].fp == NULL)
 		return 0;
 	mcd_table[i].filename = strdup(name);
+	mcd_setup_file(&mcd_table[i], "w");
 
 	if (vpi_trace) {
 	      fprintf(vpi_trace, "vpi_mcd_open(%s) --> 0x%08x\n",
@@ -214,13 +553,14 @@ vpi_mcd_vprintf(PLI_UINT32 mcd, const char*fmt, va_list ap)
       }
       va_end(saved_ap);
 
+      size_t len = strlen(buf_ptr);
       for(int i = 0; i < 31; i++) {
 	    if((mcd>>i) & 1) {
 		  if(mcd_table[i].fp) {
 			  // echo to logfile
 			if (i == 0 && logfile)
 			      fputs(buf_ptr, logfile);
-			fputs(buf_ptr, mcd_table[i].fp);
+			mcd_write(&mcd_table[i], buf_ptr, len);
 		  } else {
 			rc = EOF;
 		  }
@@ -242,7 +582,12 @@ extern "C" PLI_INT32 vpi_mcd_printf(PLI_UINT32 mcd, const char *fmt, ...)
 
 extern "C" void vpip_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t cnt)
 {
-      if (!IS_MCD(mcd)) return;
+      if (!IS_MCD(mcd)) {
+	    unsigned idx = FD_IDX(mcd);
+	    if (idx < fd_table_len && fd_table[idx].fp)
+		  mcd_write(&fd_table[idx], buf, cnt);
+	    return;
+      }
 
       for(int idx = 0; idx < 31; idx += 1) {
 	    if (((mcd>>idx) & 1) == 0)
@@ -251,7 +596,7 @@ extern "C" void vpip_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t cnt)
 	    if (mcd_table[idx].fp == 0)
 		  continue;
 
-	    fwrite(buf, 1, cnt, mcd_table[idx].fp);
+	    mcd_write(&mcd_table[idx], buf, cnt);
 	    if (idx == 0 && logfile)
 		  fwrite(buf, 1, cnt, logfile);
 
@@ -266,12 +611,16 @@ extern "C" PLI_INT32 vpi_mcd_flush(PLI_UINT32 mcd)
 		for(int i = 0; i < 31; i++) {
 			if((mcd>>i) & 1) {
 				if (i == 0 && logfile) fflush(logfile);
+				mcd_async_sync(&mcd_table[i]);
 				if (fflush(mcd_table[i].fp)) rc |= 1<<i;
 			}
 		}
 	} else {
 		unsigned idx = FD_IDX(mcd);
-		if (idx < fd_table_len) rc = fflush(fd_table[idx].fp);
+		if (idx < fd_table_len) {
+			mcd_async_sync(&fd_table[idx]);
+			rc = fflush(fd_table[idx].fp);
+		}
 	}
 	return rc;
 }
@@ -305,6 +654,8 @@ extern "C" PLI_INT32 vpi_fopen(const char*name, const char*mode)
       for (unsigned idx = i; idx < fd_table_len; idx += 1) {
 	    fd_table[idx].fp = NULL;
 	    fd_table[idx].filename = NULL;
+	    fd_table[idx].async = NULL;
+	    fd_table[idx].vbuf = NULL;
       }
 
 got_entry:
@@ -318,6 +669,7 @@ got_entry:
 #endif
       if (fd_table[i].fp == NULL) return 0;
       fd_table[i].filename = strdup(name);
+      mcd_setup_file(&fd_table[i], mode);
       return ((1U<<31)|i);
 }
 
@@ -329,5 +681,7 @@ extern "C" FILE *vpi_get_file(PLI_INT32 fd)
 	// Only know about fd_table_len indices
       if (FD_IDX(fd) >= fd_table_len) return NULL;
 
+	// The caller uses the FILE* directly, so it must be up to date.
+      mcd_async_sync(&fd_table[FD_IDX(fd)]);
       return fd_table[FD_IDX(fd)].fp;
 }
@@ -24,6 +24,8 @@
 # include  "vvp_cleanup.h"
 #endif
 # include  <vector>
+# include  <map>
+# include  <string>
 # include  <cstdio>
 # include  <cstdarg>
 # include  <cstring>
@@ -1281,11 +1283,98 @@ vpiHandle vpi_handle_by_index(vpiHandle ref, PLI_INT32 idx)
       return ref->vpi_index(idx);
 }
 
+/*
+ * Looking up names one scope at a time by brute force is slow for
+ * big designs, so vpi_handle_by_name() uses an index of the names in
+ * each scope. The index of a scope maps the names of the items of
+ * the scope (other than ports) to the first item with that name,
+ * which is the item that the brute force search finds. It also maps
+ * the names of the child scopes to those scopes. The index for the
+ * root (the nil scope) has the root scopes. The index is made when a
+ * name is first looked up in a scope, and made again if items have
+ * been added to the scope since.
+ */
+namespace {
+      struct scope_name_index_s {
+	    scope_name_index_s() : nitems(0) { }
+	    unsigned nitems;
+	    map<string,vpiHandle> items;
+	    multimap<string,vpiHandle> scopes;
+      };
+}
+
+static map<__vpiScope*,scope_name_index_s> scope_name_index;
+
+static bool is_internal_scope(int type)
+{
+      switch (type) {
+	  case vpiModule:
+	  case vpiGenScope:
+	  case vpiFunction:
+	  case vpiTask:
+	  case vpiNamedBegin:
+	  case vpiNamedFork:
+	    return true;
+	  default:
+	    return false;
+      }
+}
+
+static scope_name_index_s& get_scope_name_index(__vpiScope*scope)
+{
+      __vpiHandle**table;
+      unsigned ntable;
+      if (scope) {
+	    table = scope->intern.empty()? 0 : &scope->intern[0];
+	    ntable = scope->intern.size();
+      } else {
+	    vpip_make_root_iterator(table, ntable);
+      }
+
+      scope_name_index_s&index = scope_name_index[scope];
+      if (index.nitems == ntable)
+	    return index;
+
+      index.items.clear();
+      index.scopes.clear();
+      for (unsigned idx = 0 ;  idx < ntable ;  idx += 1) {
+	    vpiHandle item = table[idx];
+	    int type = item->get_type_code();
+	    if (scope && type == vpiPort)
+		  continue;
+
+	    char*nm = vpi_get_str(vpiName, item);
+	    if (nm == 0)
+		  continue;
+
+	    string key (nm);
+	    if (scope == 0 || is_internal_scope(type))
+		  index.scopes.insert(make_pair(key, item));
+	    if (scope)
+		  index.items.insert(make_pair(key, item));
+      }
+      index.nitems = ntable;
+
+      return index;
+}
+
 static vpiHandle find_name(const char *name, vpiHandle handle)
 {
       vpiHandle rtn = 0;
       __vpiScope*ref = dynamic_cast<__vpiScope*>(handle);
 
+	/* The name of a memory word has the index in it, and the words
+	   are not in the index, so look for those the long way. Do the
+	   same if the name is the name of the scope itself, since the
+	   search below returns the scope in that case, unless the
+	   first item of the scope has the name. */
+      if (ref && strchr(name, '[') == 0
+	  && strcmp(name, vpi_get_str(vpiName, handle)) != 0) {
+	    scope_name_index_s&index = get_scope_name_index(ref);
+	    map<string,vpiHandle>::const_iterator cur = index.items.find(name);
+	    return cur == index.items.end()? 0 : cur->second;
+      }
+
       /* check module names */
       if (!strcmp(name, vpi_get_str(vpiName, handle)))
 	    rtn = handle;
@@ -1347,10 +1436,9 @@ static char * find_rest(char *name)
 
 static vpiHandle find_scope(const char *name, vpiHandle handle, int depth)
 {
-
-      vpiHandle iter = handle==0
-	    ? vpi_iterate(vpiModule, NULL)
-	    : vpi_iterate(vpiInternalScope, handle);
+      __vpiScope*ref = dynamic_cast<__vpiScope*>(handle);
+      if (handle && ref == 0)
+	    return 0;
 
       vector<char> name_buf (strlen(name)+1);
       strcpy(&name_buf[0], name);
@@ -1361,23 +1449,19 @@ static vpiHandle find_scope(const char *name, vpiHandle handle, int depth)
 	    *nm_rest++ = 0;
       }
 
+      scope_name_index_s&index = get_scope_name_index(ref);
+      typedef multimap<string,vpiHandle>::const_iterator scope_iter_t;
+      pair<scope_iter_t,scope_iter_t> range = index.scopes.equal_range(nm_first);
+
       vpiHandle rtn = 0;
-      vpiHandle hand;
-      while (iter && (hand = vpi_scan(iter))) {
-	    char *nm = vpi_get_str(vpiName, hand);
-
-	    if (strcmp(nm_first,nm)==0) {
-		  if (nm_rest)
-			rtn=find_scope(nm_rest, hand, depth+1);
-		  else
-			rtn = hand;
-	    }
+      for (scope_iter_t cur = range.first ;  cur != range.second ;  ++ cur) {
+	    if (nm_rest)
+		  rtn = find_scope(nm_rest, cur->second, depth+1);
+	    else
+		  rtn = cur->second;
 
 	    /* found it yet ? */
-	    if (rtn) {
-		  vpi_free_object(iter);
-		  break;
-	    }
+	    if (rtn) break;
       }
 
       return rtn;
@@ -1746,5 +1830,11 @@ vpip_routines_s vpi_routines = {
     .make_systf_system_defined  = vpip_make_systf_system_defined,
     .mcd_rawwrite               = vpip_mcd_rawwrite,
     .set_return_value           = vpip_set_return_value,
+    .batch_create               = vpip_batch_create,
+    .batch_size                 = vpip_batch_size,
+    .batch_get                  = vpip_batch_get,
+    .batch_put                  = vpip_batch_put,
+    .batch_free                 = vpip_batch_free,
+    .mcd_flush_all              = vpip_mcd_flush_all,
 };
 #endif
@@ -52,6 +52,13 @@ typedef struct __vpiArray* vvp_array_t;
 extern vpip_routines_s vpi_routines;
 #endif
 
+/*
+ * Control the background writer for the files that $fopen opens (the
+ * -b flag), and stop it when the simulation is over.
+ */
+extern void vpip_mcd_set_async(bool flag);
+extern void vpip_mcd_finish(void);
+
 /*
  * Routines/definitions used to build the file/line number tracing object.
  */
@@ -617,7 +624,7 @@ class __vpiStringVar : public __vpiBaseVar {
 extern vpiHandle vpip_make_string_var(const char*name, vvp_net_t*net);
 
 struct __vpiArrayBase {
-      __vpiArrayBase() : vals_words(NULL) {}
+      __vpiArrayBase() : vals_words(NULL), vals_word_pages(0) {}
       virtual ~__vpiArrayBase() {}
 
       virtual unsigned get_size(void) const = 0;
@@ -637,9 +644,14 @@ struct __vpiArrayBase {
     // code in the following function
       vpiHandle vpi_array_base_iterate(int code);
 
-      virtual void make_vals_words();
+	// Get the word handle for the canonical index idx. The handles
+	// are made a page at a time, the first time a word in the page
+	// is asked for.
+      struct __vpiArrayWord*get_vals_word(unsigned idx);
+      void delete_vals_words();
 
-      struct __vpiArrayWord*vals_words;
+      struct __vpiArrayWordPage**vals_words;
+      unsigned vals_word_pages;
 };
 
 /*
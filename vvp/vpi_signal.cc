@@ -39,6 +39,7 @@
 # include  <climits>
 # include  <cstring>
 # include  <cassert>
+# include  <vector>
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
 #endif
@@ -151,19 +152,119 @@ static vpiHandle fill_in_var4(struct __vpiSignal*obj,
  * They work with full or partial signals.
  */
 
-static void format_vpiBinStrVal(vvp_signal_value*sig, int base, unsigned wid,
-                                s_vpi_value*vp)
+/*
+ * The formatting routines below work on the packed a/b words of the
+ * signal value, instead of getting the bits one at a time. The value
+ * bits are encoded in the words like so:
+ *
+ *     a  b
+ *     0  0  -- BIT4_0
+ *     1  0  -- BIT4_1
+ *     0  1  -- BIT4_Z
+ *     1  1  -- BIT4_X
+ *
+ * which is also the encoding of the s_vpi_vecval aval/bval bits.
+ */
+static const unsigned WORD_BITS = 8*sizeof(unsigned long);
+
+/*
+ * Get the a/b words of the part [base, base+wid) of the signal. The
+ * result is a scratch array that holds the a words, then the b
+ * words. Bits of the part that are outside the signal are X.
+ */
+static unsigned long* get_signal_words(vvp_signal_value*sig, long base,
+                                       unsigned wid)
 {
-      char *rbuf = (char *) need_result_buf(wid+1, RBUF_VAL);
+      static std::vector<unsigned long> words;
+      unsigned cnt = (wid + WORD_BITS - 1) / WORD_BITS;
+      if (words.size() < 2*cnt+1)
+	    words.resize(2*cnt+1);
+
+      unsigned long*abits = &words[0];
+      unsigned long*bbits = abits + cnt;
       long end = base + (signed)wid;
-      long offset = end - 1;
       long ssize = (signed)sig->value_size();
 
-      for (long idx = base ;  idx < end ;  idx += 1) {
-	    if (idx < 0 || idx >= ssize) {
-                  rbuf[offset-idx] = 'x';
-	    } else {
-                  rbuf[offset-idx] = vvp_bit4_to_ascii(sig->value(idx));
+      if (base >= 0 && end <= ssize) {
+	    sig->vec4_words(base, wid, abits, bbits);
+	    return abits;
+      }
+
+      for (unsigned idx = 0 ;  idx < cnt ;  idx += 1) {
+	    abits[idx] = ~0UL;
+	    bbits[idx] = ~0UL;
+      }
+      if (wid % WORD_BITS) {
+	    abits[cnt-1] &= (1UL << (wid % WORD_BITS)) - 1;
+	    bbits[cnt-1] &= (1UL << (wid % WORD_BITS)) - 1;
+      }
+      if (end > ssize) end = ssize;
+      for (long idx = (base < 0) ? 0 : base ;  idx < end ;  idx += 1) {
+	    unsigned long mask = 1UL << ((idx-base) % WORD_BITS);
+	    unsigned wdx = (idx-base) / WORD_BITS;
+	    switch (sig->value(idx)) {
+		case BIT4_0:
+		  abits[wdx] &= ~mask;
+		  bbits[wdx] &= ~mask;
+		  break;
+		case BIT4_1:
+		  bbits[wdx] &= ~mask;
+		  break;
+		case BIT4_Z:
+		  abits[wdx] &= ~mask;
+		  break;
+		case BIT4_X:
+		  break;
+	    }
+      }
+      return abits;
+}
+
+/*
+ * Get cnt (less than WORD_BITS) bits starting at bit pos of the
+ * array. The bits must all be within the array.
+ */
+static inline unsigned long get_word_bits(const unsigned long*words,
+                                          unsigned pos, unsigned cnt)
+{
+      unsigned off = pos % WORD_BITS;
+      unsigned long val = words[pos/WORD_BITS] >> off;
+      if (off + cnt > WORD_BITS)
+	    val |= words[pos/WORD_BITS + 1] << (WORD_BITS - off);
+      return val & ((1UL << cnt) - 1);
+}
+
+/*
+ * The hex_digits and oct_digits tables are indexed by 2 bits for
+ * each value bit, with 0, 1, X and Z coded as 0, 1, 2 and 3. This
+ * gets that index for up to 4 value bits.
+ */
+static inline unsigned digit_index(unsigned long abits, unsigned long bbits)
+{
+      static const unsigned char spread[16] = {
+	    0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+	    0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55
+      };
+      return spread[abits ^ bbits] | (spread[bbits] << 1);
+}
+
+static void format_vpiBinStrVal(vvp_signal_value*sig, int base, unsigned wid,
+                                s_vpi_value*vp)
+{
+      char *rbuf = (char *) need_result_buf(wid+1, RBUF_VAL);
+      const unsigned long*abits = get_signal_words(sig, base, wid);
+      const unsigned long*bbits = abits + (wid + WORD_BITS - 1) / WORD_BITS;
+
+      char*cp = rbuf + wid;
+      for (unsigned wdx = 0 ;  wdx*WORD_BITS < wid ;  wdx += 1) {
+	    unsigned long aval = abits[wdx];
+	    unsigned long bval = bbits[wdx];
+	    unsigned trans = wid - wdx*WORD_BITS;
+	    if (trans > WORD_BITS) trans = WORD_BITS;
+	    for (unsigned idx = 0 ;  idx < trans ;  idx += 1) {
+		  *--cp = "01zx"[(aval&1) | ((bval&1) << 1)];
+		  aval >>= 1;
+		  bval >>= 1;
 	    }
       }
       rbuf[wid] = 0;
@@ -176,41 +277,24 @@ static void format_vpiOctStrVal(vvp_signal_value*sig, int base, unsigned wid,
 {
       unsigned dwid = (wid + 2) / 3;
       char *rbuf = (char *) need_result_buf(dwid+1, RBUF_VAL);
-      long end = base + (signed)wid;
-      long ssize = (signed)sig->value_size();
+      const unsigned long*abits = get_signal_words(sig, base, wid);
+      const unsigned long*bbits = abits + (wid + WORD_BITS - 1) / WORD_BITS;
       unsigned val = 0;
 
       rbuf[dwid] = 0;
-      for (long idx = base ;  idx < end ;  idx += 1) {
-	    unsigned bit = 0;
-	    if (idx < 0 || idx >= ssize) {
-                  bit = 2; // BIT4_X
-	    } else {
-                  switch (sig->value(idx)) {
-		      case BIT4_0:
-			bit = 0;
-			break;
-		      case BIT4_1:
-			bit = 1;
-			break;
-		      case BIT4_X:
-			bit = 2;
-			break;
-		      case BIT4_Z:
-			bit = 3;
-			break;
-                  }
-	    }
-	    val |= bit << 2*((idx-base) % 3);
-
-	    if ((idx-base) % 3 == 2) {
-		dwid -= 1;
-		rbuf[dwid] = oct_digits[val];
-		val = 0;
-	    }
+      for (unsigned idx = 0 ;  idx+3 <= wid ;  idx += 3) {
+	    val = digit_index(get_word_bits(abits, idx, 3),
+	                      get_word_bits(bbits, idx, 3));
+	    dwid -= 1;
+	    rbuf[dwid] = oct_digits[val];
       }
 
 	/* Fill in X or Z if they are the only thing in the value. */
+      if (wid % 3) {
+	    unsigned idx = wid - wid%3;
+	    val = digit_index(get_word_bits(abits, idx, wid%3),
+	                      get_word_bits(bbits, idx, wid%3));
+      }
       switch (wid % 3) {
 	  case 1:
 	    if (val == 2) val = 42;
@@ -232,41 +316,27 @@ static void format_vpiHexStrVal(vvp_signal_value*sig, int base, unsigned wid,
 {
       unsigned dwid = (wid + 3) / 4;
       char *rbuf = (char *) need_result_buf(dwid+1, RBUF_VAL);
-      long end = base + (signed)wid;
-      long ssize = (signed)sig->value_size();
+      const unsigned long*abits = get_signal_words(sig, base, wid);
+      const unsigned long*bbits = abits + (wid + WORD_BITS - 1) / WORD_BITS;
       unsigned val = 0;
 
       rbuf[dwid] = 0;
-      for (long idx = base ;  idx < end ;  idx += 1) {
-	    unsigned bit = 0;
-	    if (idx < 0 || idx >= ssize) {
-                  bit = 2; // BIT4_X
-	    } else {
-                  switch (sig->value(idx)) {
-		      case BIT4_0:
-			bit = 0;
-			break;
-		      case BIT4_1:
-			bit = 1;
-			break;
-		      case BIT4_X:
-			bit = 2;
-			break;
-		      case BIT4_Z:
-			bit = 3;
-			break;
-                  }
-	    }
-	    val |= bit << 2*((idx-base) % 4);
-
-	    if ((idx-base) % 4 == 3) {
-		dwid -= 1;
-		rbuf[dwid] = hex_digits[val];
-		val = 0;
-	    }
+      for (unsigned idx = 0 ;  idx+4 <= wid ;  idx += 4) {
+	      // WORD_BITS is a multiple of 4, so a digit never
+	      // crosses a word boundary.
+	    unsigned long aval = abits[idx/WORD_BITS] >> (idx%WORD_BITS);
+	    unsigned long bval = bbits[idx/WORD_BITS] >> (idx%WORD_BITS);
+	    val = digit_index(aval & 15, bval & 15);
+	    dwid -= 1;
+	    rbuf[dwid] = hex_digits[val];
       }
 
 	/* Fill in X or Z if they are the only thing in the value. */
+      if (wid % 4) {
+	    unsigned idx = wid - wid%4;
+	    val = digit_index(get_word_bits(abits, idx, wid%4),
+	                      get_word_bits(bbits, idx, wid%4));
+      }
       switch (wid % 4) {
 	  case 1:
 	    if (val == 2) val = 170;
@@ -361,10 +431,19 @@ static void format_vpiRealVal(vvp_signal_value*sig, int base, unsigned wid,
       vvp_vector4_t vec4(wid);
       long ssize = (signed)sig->value_size();
       long end = base + (signed)wid;
-      if (end > ssize) end = ssize;
 
-      for (long idx = (base < 0) ? 0 : base ;  idx < end ;  idx += 1) {
-	    vec4.set_bit(idx-base, sig->value(idx));
+      if (base >= 0 && end <= ssize) {
+	    vvp_vector4_t tmp;
+	    sig->vec4_value(tmp);
+	    if (base == 0 && end == ssize)
+		  vec4 = tmp;
+	    else
+		  vec4 = tmp.subvalue(base, wid);
+      } else {
+	    if (end > ssize) end = ssize;
+	    for (long idx = (base < 0) ? 0 : base ;  idx < end ;  idx += 1) {
+		  vec4.set_bit(idx-base, sig->value(idx));
+	    }
       }
 
       vp->value.real = 0.0;
@@ -379,25 +458,24 @@ static void format_vpiStringVal(vvp_signal_value*sig, int base, unsigned wid,
 	 don't form an 8 bit group. */
       char *rbuf = (char *) need_result_buf(wid/8 + ((wid&7)!=0) + 1, RBUF_VAL);
       char *cp = rbuf;
+      const unsigned long*abits = get_signal_words(sig, base, wid);
+      const unsigned long*bbits = abits + (wid + WORD_BITS - 1) / WORD_BITS;
 
-      char tmp = 0;
-      for (long idx = base+(signed)wid-1; idx >= base; idx -= 1) {
-	    tmp <<= 1;
+      for (unsigned idx = (wid+7) & ~7U ;  idx > 0 ; ) {
+	    idx -= 8;
+	    unsigned trans = wid - idx;
+	    if (trans > 8) trans = 8;
 
-	    if (idx >=0 && idx < (signed)sig->value_size() &&
-	        sig->value(idx) == BIT4_1) {
-		   tmp |= 1;
-	    }
+	      /* Only the 1 bits are 1 in the character. */
+	    char tmp = get_word_bits(abits, idx, trans)
+	             & ~get_word_bits(bbits, idx, trans);
 
-	    if (((idx-base)&7)==0){
-		  /* Skip leading nulls. */
-		  if (tmp == 0 && cp == rbuf)
-			continue;
+	      /* Skip leading nulls. */
+	    if (tmp == 0 && cp == rbuf)
+		  continue;
 
-		  /* Nulls in the middle get turned into spaces. */
-		  *cp++ = tmp ? tmp : ' ';
-		  tmp = 0;
-	    }
+	      /* Nulls in the middle get turned into spaces. */
+	    *cp++ = tmp ? tmp : ' ';
       }
       *cp++ = 0;
 
@@ -488,47 +566,33 @@ static void format_vpiStrengthVal(vvp_signal_value*sig, int base,
 static void format_vpiVectorVal(vvp_signal_value*sig, int base, unsigned wid,
                                 s_vpi_value*vp)
 {
-      long end = base + (signed)wid;
-      unsigned int obit = 0;
       unsigned hwid = (wid + 31)/32;
 
       s_vpi_vecval *op = (p_vpi_vecval)
                          need_result_buf(hwid * sizeof(s_vpi_vecval), RBUF_VAL);
       vp->value.vector = op;
 
-      op->aval = op->bval = 0;
-      for (long idx = base ;  idx < end ;  idx += 1) {
-	    if (base >= 0 && base < (signed)sig->value_size()) {
-		switch (sig->value(idx)) {
-		case BIT4_0:
-		  op->aval &= ~(1 << obit);
-		  op->bval &= ~(1 << obit);
-		  break;
-		case BIT4_1:
-		  op->aval |= (1 << obit);
-		  op->bval &= ~(1 << obit);
-		  break;
-		case BIT4_X:
-		  op->aval |= (1 << obit);
-		  op->bval |= (1 << obit);
-		  break;
-		case BIT4_Z:
-		  op->aval &= ~(1 << obit);
-		  op->bval |= (1 << obit);
-		  break;
-		}
-	    } else {  /* BIT4_X */
-		  op->aval |= (1 << obit);
-		  op->bval |= (1 << obit);
+	/* A part select that starts below the signal has always read
+	   as all X, even for the bits that are in range. */
+      if (base < 0) {
+	    for (unsigned idx = 0 ;  idx < hwid ;  idx += 1) {
+		  unsigned trans = wid - idx*32;
+		  unsigned long mask = trans >= 32 ? 0xffffffffUL
+		                                   : (1UL << trans) - 1;
+		  op[idx].aval = mask;
+		  op[idx].bval = mask;
 	    }
+	    return;
+      }
 
-	    obit++;
-	    if (!(obit % 32)) {
-		  op += 1;
-		  if ((op - vp->value.vector) < (ptrdiff_t)hwid)
-			op->aval = op->bval = 0;
-		  obit = 0;
-	    }
+	/* The vecval has the same a/b encoding as the signal words,
+	   so this is only a matter of cutting them into 32bit parts. */
+      const unsigned long*abits = get_signal_words(sig, base, wid);
+      const unsigned long*bbits = abits + (wid + WORD_BITS - 1) / WORD_BITS;
+      for (unsigned idx = 0 ;  idx < hwid ;  idx += 1) {
+	    unsigned pos = idx * 32;
+	    op[idx].aval = (abits[pos/WORD_BITS] >> (pos%WORD_BITS)) & 0xffffffffUL;
+	    op[idx].bval = (bbits[pos/WORD_BITS] >> (pos%WORD_BITS)) & 0xffffffffUL;
       }
 }
 
@@ -981,6 +1045,25 @@ static vpiHandle signal_put_value(vpiHandle ref, s_vpi_value*vp, int flags)
       return ref;
 }
 
+/*
+ * Return true if none of the first wid bits of the vecval array have
+ * the bval bit set.
+ */
+static bool vpi_vector_is_2state(const s_vpi_vecval*vec, unsigned wid)
+{
+      unsigned nwords = wid / 32;
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    if (vec[idx].bval != 0)
+		  return false;
+      }
+      if (wid % 32) {
+	    uint32_t mask = ((uint32_t)1 << (wid%32)) - 1;
+	    if ((uint32_t)vec[nwords].bval & mask)
+		  return false;
+      }
+      return true;
+}
+
 vvp_vector4_t vec4_from_vpi_value(s_vpi_value*vp, unsigned wid)
 {
       vvp_vector4_t val (wid, BIT4_0);
@@ -998,6 +1081,23 @@ vvp_vector4_t vec4_from_vpi_value(s_vpi_value*vp, unsigned wid)
 	  }
 
 	  case vpiVectorVal:
+	    if (vpi_vector_is_2state(vp->value.vector, wid)) {
+		    // The common case has no X or Z bits, so the aval
+		    // words can be packed and set a word at a time.
+		  const unsigned BPW = 8*sizeof(unsigned long);
+		  unsigned nwords = (wid + BPW - 1) / BPW;
+		  unsigned long local[4];
+		  unsigned long*bits = nwords <= 4? local : new unsigned long[nwords];
+		  for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+			bits[idx] = 0;
+		  for (unsigned idx = 0 ;  idx < (wid+31)/32 ;  idx += 1) {
+			unsigned long aval = (uint32_t)vp->value.vector[idx].aval;
+			bits[idx*32/BPW] |= aval << (idx*32%BPW);
+		  }
+		  val.setarray(0, wid, bits);
+		  if (bits != local) delete[]bits;
+		  break;
+	    }
 	    for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
 		  unsigned long aval = vp->value.vector[idx/32].aval;
 		  unsigned long bval = vp->value.vector[idx/32].bval;
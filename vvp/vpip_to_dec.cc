@@ -108,12 +108,34 @@ static inline int write_digits(unsigned long v, char **buf,
 static unsigned long *valv=NULL;
 static unsigned int vlen_alloc=0;
 
+/* The a/b words of the vector are kept here, for the same reason. */
+#define ALLOC_MARGIN 4
+static unsigned long *bitv=NULL;
+static unsigned int blen_alloc=0;
+
+static inline unsigned count_ones(unsigned long word)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountl(word);
+#else
+	unsigned res = 0;
+	while (word) {
+		word &= word - 1;
+		res += 1;
+	}
+	return res;
+#endif
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void dec_str_delete(void)
 {
       free(valv);
       valv = 0;
       vlen_alloc = 0;
+      free(bitv);
+      bitv = 0;
+      blen_alloc = 0;
 }
 #endif
 
@@ -121,33 +143,39 @@ unsigned vpip_vec4_to_dec_str(const vvp_vector4_t&vec4,
 			      char *buf, unsigned int nbuf,
 			      int signed_flag)
 {
+      const unsigned WBITS = 8*sizeof(unsigned long);
       unsigned int idx, vlen;
       unsigned int mbits=vec4.size();   /* number of non-sign bits */
       unsigned count_x = 0, count_z = 0;
 
-      unsigned long val=0;
+	/* Get the a/b words of the vector, so that the bits can be
+	   counted and shifted in a word at a time. The b words
+	   follow the a words in the bitv array. */
+      unsigned blen = (vec4.size() + WBITS - 1) / WBITS;
+      if (!bitv || 2*blen > blen_alloc) {
+	    if (bitv) free(bitv);
+	    bitv = (unsigned long*) malloc((2*blen+ALLOC_MARGIN) * sizeof (*bitv));
+	    blen_alloc = 2*blen+ALLOC_MARGIN;
+      }
+      unsigned long*abits = bitv;
+      unsigned long*bbits = bitv + blen;
+      vec4.get_words(0, vec4.size(), abits, bbits);
+
+      for (idx = 0; idx < blen; idx += 1) {
+	    count_x += count_ones(abits[idx] & bbits[idx]);
+	    count_z += count_ones(~abits[idx] & bbits[idx]);
+      }
+
       int comp=0;
       if (signed_flag) {
-	    switch (vec4.value(vec4.size()-1)) {
-		case BIT4_X:
-		  count_x += 1;
-		  break;
-		case BIT4_Z:
-		  count_z += 1;
-		  break;
-		case BIT4_1:
+	    if (vec4.value(vec4.size()-1) == BIT4_1)
 		  comp=1;
-		  break;
-		case BIT4_0:
-		  break;
-	    }
 	    mbits -= 1;
       }
       assert(mbits<(UINT_MAX-92)/28);
       vlen = ((mbits*28+92)/93+BDIGITS-1)/BDIGITS;
 	/* printf("vlen=%d\n",vlen); */
 
-#define ALLOC_MARGIN 4
       if (!valv || vlen > vlen_alloc) {
 	    if (valv) free(valv);
 	    valv = (unsigned long*) calloc(vlen+ALLOC_MARGIN, sizeof (*valv));
@@ -156,32 +184,21 @@ unsigned vpip_vec4_to_dec_str(const vvp_vector4_t&vec4,
 	    memset(valv,0,vlen*sizeof(valv[0]));
       }
 
-      for (idx = 0; idx < mbits; idx += 1) {
-	      /* printf("%c ",bits[mbits-idx-1]); */
-	    switch (vec4.value(mbits-idx-1)) {
-		case BIT4_Z:
-		  count_z += 1;
-		  break;
-		case BIT4_X:
-		  count_x += 1;
-		  break;
-		case BIT4_1:
-		  if (! comp)
-			val += 1;
-		  break;
-		case BIT4_0:
+	/* Shift in BBITS bits at a time, starting with the most
+	   significant part. BBITS divides the word size, so a part
+	   never crosses a word boundary. If there are X or Z bits,
+	   the result does not depend on the valv array. */
+      if (count_x == 0 && count_z == 0) {
+	    for (idx = (mbits+BBITS-1)/BBITS; idx > 0; idx -= 1) {
+		  unsigned pos = (idx-1)*BBITS;
+		  unsigned long val = (abits[pos/WBITS] >> (pos%WBITS)) & BMASK;
 		  if (comp)
-			val += 1;
-		  break;
-	    }
-
-	    if ((mbits-idx-1)%BBITS==0) {
+			val = ~val & BMASK;
+		  if (mbits-pos < BBITS)
+			val &= (1UL << (mbits-pos)) - 1;
 		    /* make negative 2's complement, not 1's complement */
-		  if (comp && idx==mbits-1) ++val;
+		  if (comp && idx==1) ++val;
 		  shift_in(valv,vlen,val);
-		  val=0;
-	    } else {
-		  val=val+val;
 	    }
       }
 
@@ -28,12 +28,14 @@
 # include  "vvp_cobject.h"
 # include  "vvp_darray.h"
 # include  "class_type.h"
+# include  "profile.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
 # include  <set>
 # include  <typeinfo>
 # include  <vector>
+# include  <utility>
 # include  <cstdlib>
 # include  <climits>
 # include  <cstring>
@@ -118,7 +120,11 @@ struct vthread_s {
       inline vvp_vector4_t pop_vec4(void)
       {
 	    assert(! stack_vec4_.empty());
+#if __cplusplus >= 201103L
+	    vvp_vector4_t val (std::move(stack_vec4_.back()));
+#else
 	    vvp_vector4_t val = stack_vec4_.back();
+#endif
 	    stack_vec4_.pop_back();
 	    return val;
       }
@@ -126,6 +132,12 @@ struct vthread_s {
       {
 	    stack_vec4_.push_back(val);
       }
+#if __cplusplus >= 201103L
+      inline void push_vec4(vvp_vector4_t&&val)
+      {
+	    stack_vec4_.push_back(std::move(val));
+      }
+#endif
       inline const vvp_vector4_t& peek_vec4(unsigned depth)
       {
 	    unsigned size = stack_vec4_.size();
@@ -288,6 +300,8 @@ struct vthread_s {
 	/* These are used to pass non-blocking event control information. */
       vvp_net_t*event;
       uint64_t ecount;
+	/* This is the last %file_line handle, for the profiler. */
+      vpiHandle fileline;
 	/* Save the file/line information when available. */
     private:
       char *filenm_;
@@ -316,6 +330,7 @@ struct vthread_s {
 inline vthread_s::vthread_s()
 {
       stack_obj_size_ = 0;
+      fileline = 0;
       filenm_ = 0;
       lineno_ = 0;
 }
@@ -373,6 +388,18 @@ __vpiScope* vthread_scope(struct vthread_s*thr)
 
 struct vthread_s*running_thread = 0;
 
+/*
+ * Set the running thread, and let the profiler know where it is.
+ */
+static inline void set_running_thread(vthread_t thr)
+{
+      running_thread = thr;
+      if (profile_flag) {
+	    profile_scope = thr ? thr->parent_scope : 0;
+	    profile_fileline = thr ? thr->fileline : 0;
+      }
+}
+
 string get_fileline()
 {
       return running_thread->get_fileline();
@@ -543,25 +570,6 @@ template vvp_vector4_t coerce_to_width(const vvp_vector4_t&that,
                                        unsigned width);
 
 
-static void multiply_array_imm(unsigned long*res, unsigned long*val,
-			       unsigned words, unsigned long imm)
-{
-      for (unsigned idx = 0 ; idx < words ; idx += 1)
-	    res[idx] = 0;
-
-      for (unsigned mul_idx = 0 ; mul_idx < words ; mul_idx += 1) {
-	    unsigned long sum;
-	    unsigned long tmp = multiply_with_carry(val[mul_idx], imm, sum);
-
-	    unsigned long carry = 0;
-	    res[mul_idx] = add_with_carry(res[mul_idx], tmp, carry);
-	    for (unsigned add_idx = mul_idx+1 ; add_idx < words ; add_idx += 1) {
-		  res[add_idx] = add_with_carry(res[add_idx], sum, carry);
-		  sum = 0;
-	    }
-      }
-}
-
 /*
  * Allocate a context for use by a child thread. By preference, use
  * the last freed context. If none available, create a new one. Add
@@ -799,7 +807,7 @@ void vthread_run(vthread_t thr)
 	    assert(thr->is_scheduled);
 	    thr->is_scheduled = 0;
 
-            running_thread = thr;
+            set_running_thread(thr);
 
 	    for (;;) {
 		  vvp_code_t cp = thr->pc;
@@ -815,7 +823,7 @@ void vthread_run(vthread_t thr)
 
 	    thr = tmp;
       }
-      running_thread = 0;
+      set_running_thread(0);
 }
 
 /*
@@ -829,6 +837,87 @@ bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code)
       return true;
 }
 
+/*
+ * A fused opcode (superinstruction) executes the instruction at cp and
+ * then the instruction at cp+1 in a single dispatch from
+ * vthread_run. Both opcode implementations are called directly, so
+ * the compiler can inline them, and the thread loop sees one indirect
+ * call instead of two.
+ *
+ * The first opcode of a pair must always return true and must not
+ * touch the thread PC. The second opcode can be anything, so it can
+ * jump or pause the thread as usual.
+ */
+template <vvp_code_fun first, vvp_code_fun second>
+static bool of_FUSED(vthread_t thr, vvp_code_t cp)
+{
+      first(thr, cp);
+      thr->pc += 1;
+      return second(thr, cp+1);
+}
+
+struct opcode_fusion_s {
+      vvp_code_fun first;
+      vvp_code_fun second;
+      vvp_code_fun fused;
+};
+
+#define FUSE(a,b) { &a, &b, &of_FUSED<&a,&b> }
+
+static const struct opcode_fusion_s opcode_fusion_table[] = {
+      FUSE(of_LOAD_VEC4,     of_STORE_VEC4),
+      FUSE(of_LOAD_VEC4,     of_LOAD_VEC4),
+      FUSE(of_LOAD_VEC4,     of_PUSHI_VEC4),
+      FUSE(of_LOAD_VEC4,     of_FLAG_SET_VEC4),
+      FUSE(of_LOAD_VEC4,     of_ADD),
+      FUSE(of_PUSHI_VEC4,    of_STORE_VEC4),
+      FUSE(of_PUSHI_VEC4,    of_ADD),
+      FUSE(of_PUSHI_VEC4,    of_SUB),
+      FUSE(of_PUSHI_VEC4,    of_CMPE),
+      FUSE(of_PUSHI_VEC4,    of_CMPNE),
+      FUSE(of_PUSHI_VEC4,    of_CMPU),
+      FUSE(of_PUSHI_VEC4,    of_CMPS),
+      FUSE(of_ADD,           of_STORE_VEC4),
+      FUSE(of_SUB,           of_STORE_VEC4),
+      FUSE(of_LOAD_VEC4,     of_ADD2),
+      FUSE(of_ADD2,          of_STORE_VEC4),
+      FUSE(of_SUB2,          of_STORE_VEC4),
+      FUSE(of_ADDI2,         of_STORE_VEC4),
+      FUSE(of_SUBI2,         of_STORE_VEC4),
+      FUSE(of_AND,           of_STORE_VEC4),
+      FUSE(of_OR,            of_STORE_VEC4),
+      FUSE(of_FLAG_SET_VEC4, of_JMP0XZ),
+      FUSE(of_FLAG_SET_VEC4, of_JMP1XZ),
+      FUSE(of_CMPE,          of_JMP0),
+      FUSE(of_CMPE,          of_JMP1),
+      FUSE(of_CMPU,          of_JMP0),
+      FUSE(of_CMPU,          of_JMP1),
+      FUSE(of_CMPS,          of_JMP0),
+      FUSE(of_CMPS,          of_JMP1),
+      FUSE(of_PUSHI_VEC4,    of_CMP2U),
+      FUSE(of_PUSHI_VEC4,    of_CMP2S),
+      FUSE(of_CMP2U,         of_JMP0),
+      FUSE(of_CMP2U,         of_JMP1),
+      FUSE(of_CMP2S,         of_JMP0),
+      FUSE(of_CMP2S,         of_JMP1),
+      FUSE(of_CMPI2U,        of_JMP0),
+      FUSE(of_CMPI2U,        of_JMP1),
+      FUSE(of_CMPI2S,        of_JMP0),
+      FUSE(of_CMPI2S,        of_JMP1),
+      { 0, 0, 0 }
+};
+
+#undef FUSE
+
+vvp_code_fun vthread_fused_opcode(vvp_code_fun first, vvp_code_fun second)
+{
+      for (const opcode_fusion_s*cur = opcode_fusion_table ; cur->first ; cur += 1) {
+	    if (cur->first == first && cur->second == second)
+		  return cur->fused;
+      }
+      return 0;
+}
+
 /*
  * This is called by an event functor to wake up all the threads on
  * its list. I in fact created that list in the %wait instruction, and
@@ -902,6 +991,38 @@ bool of_AND(vthread_t thr, vvp_code_t)
       return true;
 }
 
+/*
+ * Get the operands of a 2-state instruction as native words. These
+ * return false if the operands are too wide or have X/Z bits, and
+ * the caller then uses the 4-state instruction instead.
+ */
+static bool get_cmp2_operands(vthread_t thr, unsigned long&lv, unsigned long&rv)
+{
+      const vvp_vector4_t&rval = thr->peek_vec4(0);
+      const vvp_vector4_t&lval = thr->peek_vec4(1);
+
+      return lval.size() == rval.size()
+	    && lval.get_word2(lv) && rval.get_word2(rv);
+}
+
+static bool get_cmpi2_operands(vthread_t thr, vvp_code_t cp,
+			       unsigned long&lv, unsigned long&rv)
+{
+      unsigned wid = cp->number;
+      const vvp_vector4_t&lval = thr->peek_vec4();
+
+	// The immediate value has no X/Z bits if valb is zero.
+      if (cp->bit_idx[1] != 0 || lval.size() != wid)
+	    return false;
+      if (! lval.get_word2(lv))
+	    return false;
+
+      rv = cp->bit_idx[0];
+      if (wid < CPU_WORD_BITS)
+	    rv &= (1UL << wid) - 1;
+      return true;
+}
+
 /*
  * This function must ALWAYS be called with the val set to the right
  * size, and initialized with BIT4_0 bits. Certain optimizations rely
@@ -998,6 +1119,38 @@ bool of_ADDI(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %add/2
+ * %addi/2 <vala>, <valb>, <wid>
+ *
+ * These are the 2-state versions of %add and %addi. When both
+ * operands fit in a native word and have no X/Z bits, do the
+ * arithmetic directly on the words and write the result back in
+ * place. The immediate form also skips building a vector for the
+ * immediate operand. Anything else falls back to the 4-state
+ * instruction. The %sub/2 and %mul/2 families work the same way.
+ */
+bool of_ADD2(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmp2_operands(thr, lv, rv))
+	    return of_ADD(thr, cp);
+
+      thr->pop_vec4(1);
+      thr->peek_vec4().set_word2(lv + rv);
+      return true;
+}
+
+bool of_ADDI2(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmpi2_operands(thr, cp, lv, rv))
+	    return of_ADDI(thr, cp);
+
+      thr->peek_vec4().set_word2(lv + rv);
+      return true;
+}
+
 /*
  * %add/wr
  */
@@ -1432,7 +1585,7 @@ static bool do_callf_void(vthread_t thr, vthread_t child)
       child->is_scheduled = 1;
       child->i_am_in_function = 1;
       vthread_run(child);
-      running_thread = thr;
+      set_running_thread(thr);
 
       if (child->i_have_ended) {
 	    do_join(thr, child);
@@ -2095,6 +2248,84 @@ bool of_CMPIU(vthread_t thr, vvp_code_t cp)
 }
 
 
+/*
+ * %cmp/2s
+ * %cmp/2u
+ * %cmpi/2s <vala>, <valb>, <wid>
+ * %cmpi/2u <vala>, <valb>, <wid>
+ *
+ * The code generator uses these compares when both operands are of
+ * 2-state types. If the values fit in a CPU word, then they are
+ * compared as native integers. A 2-state expression can still carry
+ * X bits (a division by zero, for example) so any operands that are
+ * too wide or not fully defined go to the 4-state compare instead.
+ */
+static void do_CMP2(vthread_t thr, unsigned wid, unsigned long lv,
+		    unsigned long rv, bool signed_flag)
+{
+      bool lt;
+      if (signed_flag) {
+	    if (wid > 0 && wid < CPU_WORD_BITS) {
+		  if ((lv >> (wid-1)) & 1)
+			lv |= -1UL << wid;
+		  if ((rv >> (wid-1)) & 1)
+			rv |= -1UL << wid;
+	    }
+	    lt = (long)lv < (long)rv;
+      } else {
+	    lt = lv < rv;
+      }
+
+      thr->flags[4] = lv == rv? BIT4_1 : BIT4_0; // eq
+      thr->flags[5] = lt? BIT4_1 : BIT4_0;       // lt
+      thr->flags[6] = thr->flags[4];             // eeq
+}
+
+bool of_CMP2S(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmp2_operands(thr, lv, rv))
+	    return of_CMPS(thr, cp);
+
+      do_CMP2(thr, thr->peek_vec4().size(), lv, rv, true);
+      thr->pop_vec4(2);
+      return true;
+}
+
+bool of_CMP2U(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmp2_operands(thr, lv, rv))
+	    return of_CMPU(thr, cp);
+
+      do_CMP2(thr, thr->peek_vec4().size(), lv, rv, false);
+      thr->pop_vec4(2);
+      return true;
+}
+
+bool of_CMPI2S(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmpi2_operands(thr, cp, lv, rv))
+	    return of_CMPIS(thr, cp);
+
+      do_CMP2(thr, cp->number, lv, rv, true);
+      thr->pop_vec4(1);
+      return true;
+}
+
+bool of_CMPI2U(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmpi2_operands(thr, cp, lv, rv))
+	    return of_CMPIU(thr, cp);
+
+      do_CMP2(thr, cp->number, lv, rv, false);
+      thr->pop_vec4(1);
+      return true;
+}
+
+
 /*
  * %cmp/x
  */
@@ -2699,134 +2930,6 @@ bool of_DISABLE_FORK(vthread_t thr, vvp_code_t)
       return true;
 }
 
-/*
- * This function divides a 2-word number {high, a} by a 1-word
- * number. Assume that high < b.
- */
-static unsigned long divide2words(unsigned long a, unsigned long b,
-				  unsigned long high)
-{
-      unsigned long result = 0;
-      while (high > 0) {
-	    unsigned long tmp_result = ULONG_MAX / b;
-	    unsigned long remain = ULONG_MAX % b;
-
-	    remain += 1;
-	    if (remain >= b) {
-		  remain -= b;
-		  tmp_result += 1;
-	    }
-
-	      // Now 0x1_0...0 = b*tmp_result + remain
-	      // high*0x1_0...0 = high*(b*tmp_result + remain)
-	      // high*0x1_0...0 = high*b*tmp_result + high*remain
-
-	      // We know that high*0x1_0...0 >= high*b*tmp_result, and
-	      // we know that high*0x1_0...0 > high*remain. Use
-	      // high*remain as the remainder for another iteration,
-	      // and add tmp_result*high into the current estimate of
-	      // the result.
-	    result += tmp_result * high;
-
-	      // The new iteration starts with high*remain + a.
-	    remain = multiply_with_carry(high, remain, high);
-	    a += remain;
-            if(a < remain)
-              high += 1;
-
-	      // Now result*b + {high,a} == the input {high,a}. It is
-	      // possible that the new high >= 1. If so, it will
-	      // certainly be less than high from the previous
-	      // iteration. Do another iteration and it will shrink,
-	      // eventually to 0.
-      }
-
-	// high is now 0, so a is the remaining remainder, so we can
-	// finish off the integer divide with a simple a/b.
-
-      return result + a/b;
-}
-
-static unsigned long* divide_bits(unsigned long*ap, unsigned long*bp, unsigned wid)
-{
-	// Do all our work a cpu-word at a time. The "words" variable
-	// is the number of words of the wid.
-      unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
-
-      unsigned btop = words-1;
-      while (btop > 0 && bp[btop] == 0)
-	    btop -= 1;
-
-	// Detect divide by 0, and exit.
-      if (btop==0 && bp[0]==0)
-	    return 0;
-
-	// The result array will eventually accumulate the result. The
-	// diff array is a difference that we use in the intermediate.
-      unsigned long*diff  = new unsigned long[words];
-      unsigned long*result= new unsigned long[words];
-      for (unsigned idx = 0 ; idx < words ; idx += 1)
-	    result[idx] = 0;
-
-      for (unsigned cur = words-btop ; cur > 0 ; cur -= 1) {
-	    unsigned cur_ptr = cur-1;
-	    unsigned long cur_res;
-	    if (ap[cur_ptr+btop] >= bp[btop]) {
-		  unsigned long high = 0;
-		  if (cur_ptr+btop+1 < words)
-			high = ap[cur_ptr+btop+1];
-		  cur_res = divide2words(ap[cur_ptr+btop], bp[btop], high);
-
-	    } else if (cur_ptr+btop+1 >= words) {
-		  continue;
-
-	    } else if (ap[cur_ptr+btop+1] == 0) {
-		  continue;
-
-	    } else {
-		  cur_res = divide2words(ap[cur_ptr+btop], bp[btop],
-					 ap[cur_ptr+btop+1]);
-	    }
-
-	      // cur_res is a guesstimate of the result this far. It
-	      // may be 1 too big. (But it will also be >0) Try it,
-	      // and if the difference comes out negative, then adjust.
-
-	      // diff = (bp * cur_res)  << cur_ptr;
-	    multiply_array_imm(diff+cur_ptr, bp, words-cur_ptr, cur_res);
-	      // ap -= diff
-	    unsigned long carry = 1;
-	    for (unsigned idx = cur_ptr ; idx < words ; idx += 1)
-		  ap[idx] = add_with_carry(ap[idx], ~diff[idx], carry);
-
-	      // ap has the diff subtracted out of it. If cur_res was
-	      // too large, then ap will turn negative. (We easily
-	      // tell that ap turned negative by looking at
-	      // carry&1. If it is 0, then it is *negative*.) In that
-	      // case, we know that cur_res was too large by 1. Correct by
-	      // adding 1b back in and reducing cur_res.
-	    if ((carry&1) == 0) {
-		    // Keep adding b back in until the remainder
-		    // becomes positive again.
-		  do {
-			cur_res -= 1;
-			carry = 0;
-			for (unsigned idx = cur_ptr ; idx < words ; idx += 1)
-			      ap[idx] = add_with_carry(ap[idx], bp[idx-cur_ptr], carry);
-		  } while (carry == 0);
-	    }
-
-	    result[cur_ptr] = cur_res;
-      }
-
-	// Now ap contains the remainder and result contains the
-	// desired result. We should find that:
-	//  input-a = bp * result + ap;
-
-      delete[]diff;
-      return result;
-}
-
 /*
  * %div
  */
@@ -2868,24 +2971,21 @@ bool of_DIV(vthread_t thr, vvp_code_t)
 	    return true;
       }
 
-      unsigned long*result = divide_bits(ap, bp, wid);
-      if (result == 0) {
-	    delete[]ap;
-	    delete[]bp;
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
+      unsigned long*result = new unsigned long[words];
+      unsigned long*remain = new unsigned long[words];
+      if (! divide_words(result, remain, ap, bp, words)) {
 	    vvp_vector4_t tmp(wid, BIT4_X);
 	    thr->push_vec4(tmp);
-	    return true;
+      } else {
+	    vala.setarray(0, wid, result);
+	    thr->push_vec4(vala);
       }
 
-	// Now ap contains the remainder and result contains the
-	// desired result. We should find that:
-	//  input-a = bp * result + ap;
-
-      vala.setarray(0, wid, result);
-      thr->push_vec4(vala);
       delete[]ap;
       delete[]bp;
       delete[]result;
+      delete[]remain;
 
       return true;
 }
@@ -2971,25 +3071,117 @@ bool of_DIV_S(vthread_t thr, vvp_code_t)
 	    negate_words(bp, words);
       }
 
-      unsigned long*result = divide_bits(ap, bp, wid);
-      if (result == 0) {
-	    delete[]ap;
-	    delete[]bp;
+      unsigned long*result = new unsigned long[words];
+      unsigned long*remain = new unsigned long[words];
+      if (! divide_words(result, remain, ap, bp, words)) {
 	    vvp_vector4_t tmp(wid, BIT4_X);
 	    vala = tmp;
-	    return true;
-      }
+      } else {
+	    if (negate_flag)
+		  negate_words(result, words);
 
-      if (negate_flag) {
-	    negate_words(result, words);
+	    result[words-1] &= ~sign_mask;
+	    vala.setarray(0, wid, result);
       }
 
-      result[words-1] &= ~sign_mask;
-
-      vala.setarray(0, wid, result);
       delete[]ap;
       delete[]bp;
       delete[]result;
+      delete[]remain;
+      return true;
+}
+
+/*
+ * %div/2s
+ * %div/2u
+ * %mod/2s
+ * %mod/2u
+ *
+ * These are the 2-state versions of %div and %mod. Like the 2-state
+ * compares, they do the arithmetic on native words when the operands
+ * fit, and otherwise use the 4-state instruction. Division by zero
+ * still gives an X result.
+ */
+static bool get_div2_operands(vthread_t thr, unsigned long&lv, unsigned long&rv,
+			      bool signed_flag)
+{
+      const vvp_vector4_t&valb = thr->peek_vec4(0);
+      const vvp_vector4_t&vala = thr->peek_vec4(1);
+
+      if (vala.size() != valb.size())
+	    return false;
+      if (! (vala.get_word2(lv) && valb.get_word2(rv)))
+	    return false;
+
+      unsigned wid = vala.size();
+      if (signed_flag && wid > 0 && wid < CPU_WORD_BITS) {
+	    if ((lv >> (wid-1)) & 1)
+		  lv |= -1UL << wid;
+	    if ((rv >> (wid-1)) & 1)
+		  rv |= -1UL << wid;
+      }
+      return true;
+}
+
+static void put_div2_result(vthread_t thr, bool defined, unsigned long res)
+{
+      thr->pop_vec4(1);
+      vvp_vector4_t&vala = thr->peek_vec4();
+      if (defined)
+	    vala.set_word2(res);
+      else
+	    vala = vvp_vector4_t(vala.size(), BIT4_X);
+}
+
+bool of_DIV2S(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_div2_operands(thr, lv, rv, true))
+	    return of_DIV_S(thr, cp);
+
+	// Dividing by -1 is a negate. Handle it separately, because
+	// the native divide overflows for the most negative value.
+      unsigned long res = 0;
+      if (rv == -1UL)
+	    res = -lv;
+      else if (rv != 0)
+	    res = (unsigned long) ((long)lv / (long)rv);
+
+      put_div2_result(thr, rv != 0, res);
+      return true;
+}
+
+bool of_DIV2U(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_div2_operands(thr, lv, rv, false))
+	    return of_DIV(thr, cp);
+
+      put_div2_result(thr, rv != 0, rv != 0? lv / rv : 0);
+      return true;
+}
+
+bool of_MOD2S(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_div2_operands(thr, lv, rv, true))
+	    return of_MOD_S(thr, cp);
+
+      unsigned long res = 0;
+      if (rv != 0 && rv != -1UL)
+	    res = (unsigned long) ((long)lv % (long)rv);
+
+      put_div2_result(thr, rv != 0, res);
+      return true;
+}
+
+bool of_MOD2U(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_div2_operands(thr, lv, rv, false))
+	    return of_MOD(thr, cp);
+
+      put_div2_result(thr, rv != 0, rv != 0? lv % rv : 0);
       return true;
 }
 
@@ -3361,7 +3553,7 @@ bool of_FORK(vthread_t thr, vvp_code_t cp)
 	    child->is_scheduled = 1;
 	    child->i_am_in_function = 1;
 	    vthread_run(child);
-	    running_thread = thr;
+	    set_running_thread(thr);
       } else {
 	    schedule_vthread(child, 0, true);
       }
@@ -3979,120 +4171,66 @@ bool of_LOAD_VEC4A(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * Calculate the remainder of wide values. The sign of a signed result
+ * follows the sign of the left operand.
+ */
 static void do_verylong_mod(vvp_vector4_t&vala, const vvp_vector4_t&valb,
-			    bool left_is_neg, bool right_is_neg)
-{
-      bool out_is_neg = left_is_neg;
-      const int len=vala.size();
-      unsigned char *a, *z, *t;
-      a = new unsigned char[len+1];
-      z = new unsigned char[len+1];
-      t = new unsigned char[len+1];
-
-      unsigned char carry;
-      unsigned char temp;
-
-      int mxa = -1, mxz = -1;
-      int i;
-      int current, copylen;
-
-      unsigned lb_carry = left_is_neg? 1 : 0;
-      unsigned rb_carry = right_is_neg? 1 : 0;
-      for (int idx = 0 ;  idx < len ;  idx += 1) {
-	    unsigned lb = vala.value(idx);
-	    unsigned rb = valb.value(idx);
-
-	    if ((lb | rb) & 2) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
-		  vvp_vector4_t tmp(len, BIT4_X);
-		  vala = tmp;
-		  return;
-	    }
-
-	    if (left_is_neg) {
-		  lb = (1-lb) + lb_carry;
-		  lb_carry = (lb & ~1)? 1 : 0;
-		  lb &= 1;
-	    }
-	    if (right_is_neg) {
-		  rb = (1-rb) + rb_carry;
-		  rb_carry = (rb & ~1)? 1 : 0;
-		  rb &= 1;
-	    }
-
-	    z[idx]=lb;
-	    a[idx]=1-rb;	// for 2s complement add..
-      }
-
-      z[len]=0;
-      a[len]=1;
-
-      for(i=len-1;i>=0;i--) {
-	    if(! a[i]) {
-		  mxa=i;
-		  break;
-	    }
-      }
+			    bool signed_flag)
+{
+      unsigned wid = vala.size();
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
 
-      for(i=len-1;i>=0;i--) {
-	    if(z[i]) {
-		  mxz=i;
-		  break;
-	    }
+      unsigned long*ap = vala.subarray(0, wid);
+      if (ap == 0) {
+	    vala = vvp_vector4_t(wid, BIT4_X);
+	    return;
       }
 
-      if((mxa>mxz)||(mxa==-1)) {
-	    if(mxa==-1) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
-		  vvp_vector4_t tmpx (len, BIT4_X);
-		  vala = tmpx;
-		  return;
-	    }
-
-	    goto tally;
+      unsigned long*bp = valb.subarray(0, wid);
+      if (bp == 0) {
+	    delete[]ap;
+	    vala = vvp_vector4_t(wid, BIT4_X);
+	    return;
       }
 
-      copylen = mxa + 2;
-      current = mxz - mxa;
+	// Sign extend the bits in the array to fill out the array,
+	// then work with the magnitudes.
+      unsigned long sign_mask = 0;
+      if (unsigned long sign_bits = (words*CPU_WORD_BITS) - wid)
+	    sign_mask = -1UL << (CPU_WORD_BITS-sign_bits);
 
-      while(current > -1) {
-	    carry = 1;
-	    for(i=0;i<copylen;i++) {
-		  temp = z[i+current] + a[i] + carry;
-		  t[i] = (temp&1);
-		  carry = (temp>>1);
-	    }
+      bool negate_flag = false;
+      if (signed_flag) {
+	    if (ap[words-1] & (sign_mask>>1))
+		  ap[words-1] |= sign_mask;
+	    if (bp[words-1] & (sign_mask>>1))
+		  bp[words-1] |= sign_mask;
 
-	    if(carry) {
-		  for(i=0;i<copylen;i++) {
-			z[i+current] = t[i];
-		  }
+	    if ( ((long) ap[words-1]) < 0 ) {
+		  negate_flag = true;
+		  negate_words(ap, words);
 	    }
-
-	    current--;
+	    if ( ((long) bp[words-1]) < 0 )
+		  negate_words(bp, words);
       }
 
- tally:
+      unsigned long*result = new unsigned long[words];
+      unsigned long*remain = new unsigned long[words];
+      if (! divide_words(result, remain, ap, bp, words)) {
+	    vala = vvp_vector4_t(wid, BIT4_X);
+      } else {
+	    if (negate_flag)
+		  negate_words(remain, words);
 
-      vvp_vector4_t tmp (len, BIT4_X);
-      carry = out_is_neg? 1 : 0;
-      for (int idx = 0 ;  idx < len ;  idx += 1) {
-	    unsigned ob = z[idx];
-	    if (out_is_neg) {
-		  ob = (1-ob) + carry;
-		  carry = (ob & ~1)? 1 : 0;
-		  ob = ob & 1;
-	    }
-	    tmp.set_bit(idx, ob?BIT4_1:BIT4_0);
+	    remain[words-1] &= ~sign_mask;
+	    vala.setarray(0, wid, remain);
       }
-      vala = tmp;
-      delete []t;
-      delete []z;
-      delete []a;
+
+      delete[]ap;
+      delete[]bp;
+      delete[]result;
+      delete[]remain;
 }
 
 bool of_MAX_WR(vthread_t thr, vvp_code_t)
@@ -4160,7 +4298,7 @@ bool of_MOD(vthread_t thr, vvp_code_t)
 	    return true;
 
       } else {
-	    do_verylong_mod(vala, valb, false, false);
+	    do_verylong_mod(vala, valb, false);
 	    return true;
       }
 
@@ -4224,9 +4362,7 @@ bool of_MOD_S(vthread_t thr, vvp_code_t)
 
       } else {
 
-	    bool left_is_neg  = vala.value(vala.size()-1) == BIT4_1;
-	    bool right_is_neg = valb.value(valb.size()-1) == BIT4_1;
-	    do_verylong_mod(vala, valb, left_is_neg, right_is_neg);
+	    do_verylong_mod(vala, valb, true);
 	    return true;
       }
 
@@ -4451,6 +4587,31 @@ bool of_MULI(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %mul/2
+ * %muli/2 <vala>, <valb>, <wid>
+ */
+bool of_MUL2(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmp2_operands(thr, lv, rv))
+	    return of_MUL(thr, cp);
+
+      thr->pop_vec4(1);
+      thr->peek_vec4().set_word2(lv * rv);
+      return true;
+}
+
+bool of_MULI2(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmpi2_operands(thr, cp, lv, rv))
+	    return of_MULI(thr, cp);
+
+      thr->peek_vec4().set_word2(lv * rv);
+      return true;
+}
+
 bool of_MUL_WR(vthread_t thr, vvp_code_t)
 {
       double r = thr->pop_real();
@@ -6390,6 +6551,31 @@ bool of_SUBI(vthread_t thr, vvp_code_t cp)
 
 }
 
+/*
+ * %sub/2
+ * %subi/2 <vala>, <valb>, <wid>
+ */
+bool of_SUB2(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmp2_operands(thr, lv, rv))
+	    return of_SUB(thr, cp);
+
+      thr->pop_vec4(1);
+      thr->peek_vec4().set_word2(lv - rv);
+      return true;
+}
+
+bool of_SUBI2(vthread_t thr, vvp_code_t cp)
+{
+      unsigned long lv, rv;
+      if (! get_cmpi2_operands(thr, cp, lv, rv))
+	    return of_SUBI(thr, cp);
+
+      thr->peek_vec4().set_word2(lv - rv);
+      return true;
+}
+
 bool of_SUB_WR(vthread_t thr, vvp_code_t)
 {
       double r = thr->pop_real();
@@ -6460,6 +6646,10 @@ bool of_FILE_LINE(vthread_t thr, vvp_code_t cp)
       thr->set_fileline(vpi_get_str(vpiFile, handle),
                         vpi_get(vpiLineNo, handle));
 
+      thr->fileline = handle;
+      if (profile_flag)
+	    profile_fileline = handle;
+
       if (show_file_line)
 	    cerr << thr->get_fileline()
 	         << vpi_get_str(_vpiDescription, handle) << endl;
@@ -6703,7 +6893,7 @@ static bool do_exec_ufunc(vthread_t thr, vvp_code_t cp, vthread_t child)
       child->is_scheduled = 1;
       child->i_am_in_function = 1;
       vthread_run(child);
-      running_thread = thr;
+      set_running_thread(thr);
 
       if (child->i_have_ended) {
 	    do_join(thr, child);
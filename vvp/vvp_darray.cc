@@ -211,67 +211,134 @@ vvp_vector4_t vvp_darray_vec4::get_bitstream(bool as_vec4)
       return vec;
 }
 
-vvp_darray_vec2::~vvp_darray_vec2()
+vvp_darray_vec2_base::vvp_darray_vec2_base(size_t siz, unsigned word_wid)
+: size_(siz), word_wid_(word_wid),
+  word_cnt_((word_wid+BITS_PER_WORD-1) / BITS_PER_WORD)
 {
 }
 
-size_t vvp_darray_vec2::get_size(void) const
+vvp_darray_vec2_base::~vvp_darray_vec2_base()
 {
-      return array_.size();
 }
 
-void vvp_darray_vec2::set_word(unsigned adr, const vvp_vector4_t&value)
+size_t vvp_darray_vec2_base::get_size(void) const
 {
-      if (adr >= array_.size()) return;
+      return size_;
+}
+
+void vvp_darray_vec2_base::set_word(unsigned adr, const vvp_vector4_t&value)
+{
+      if (adr >= size_) return;
       assert(value.size() == word_wid_);
-      array_[adr] = value;
+
+      unsigned long*dst = word_ptr_(adr, true);
+      if (word_cnt_ == 1 && value.get_word2(dst[0]))
+	    return;
+
+	// Use the Verilog rules for converting XZ values to 0.
+      unsigned long*val = value.subarray(0, word_wid_, true);
+      for (unsigned idx = 0 ; idx < word_cnt_ ; idx += 1)
+	    dst[idx] = val[idx];
+      delete[]val;
 }
 
-void vvp_darray_vec2::get_word(unsigned adr, vvp_vector4_t&value)
+void vvp_darray_vec2_base::get_word(unsigned adr, vvp_vector4_t&value)
 {
 	/*
-	 * Return a zero value for an out of range address or if the
-	 * value has not been written yet (has a size of zero).
+	 * Return a zero value for an out of range address. Words that
+	 * have not been written yet are already zero.
 	 */
-      if ((adr >= array_.size()) || (array_[adr].size() == 0)) {
-	    value = vvp_vector4_t(word_wid_, BIT4_0);
+      value = vvp_vector4_t(word_wid_, BIT4_0);
+      if (adr >= size_)
 	    return;
-      }
-      assert(array_[adr].size() == word_wid_);
-      value.resize(word_wid_);
-      for (unsigned idx = 0; idx < word_wid_; idx += 1) {
-	    value.set_bit(idx, array_[adr].value4(idx));
-      }
+
+      if (const unsigned long*src = word_ptr_(adr))
+	    value.setarray(0, word_wid_, src);
 }
 
-void vvp_darray_vec2::shallow_copy(const vvp_object*obj)
+void vvp_darray_vec2_base::shallow_copy(const vvp_object*obj)
 {
-      const vvp_darray_vec2*that = dynamic_cast<const vvp_darray_vec2*>(obj);
+	// The source may be stored differently, so only the packing
+	// needs to match.
+      const vvp_darray_vec2_base*that = dynamic_cast<const vvp_darray_vec2_base*>(obj);
       assert(that);
+      assert(word_cnt_ == that->word_cnt_);
 
-      unsigned num_items = min(array_.size(), that->array_.size());
-      for (unsigned idx = 0 ; idx < num_items ; idx += 1)
-	    array_[idx] = that->array_[idx];
+      size_t num_items = min(size_, that->size_);
+      for (size_t idx = 0 ; idx < num_items ; idx += 1) {
+	    const unsigned long*src = that->word_ptr_(idx);
+	    unsigned long*dst = word_ptr_(idx, src != 0);
+	    if (dst == 0)
+		  continue;
+
+	    for (unsigned wdx = 0 ; wdx < word_cnt_ ; wdx += 1)
+		  dst[wdx] = src? src[wdx] : 0;
+      }
 }
 
-vvp_vector4_t vvp_darray_vec2::get_bitstream(bool)
+vvp_vector4_t vvp_darray_vec2_base::get_bitstream(bool)
 {
-      vvp_vector4_t vec(array_.size() * word_wid_, BIT4_0);
+      vvp_vector4_t vec(size_ * word_wid_, BIT4_0);
 
-      unsigned adx = 0;
       unsigned vdx = vec.size();
-      while (vdx > 0) {
+      for (size_t adx = 0 ; adx < size_ ; adx += 1) {
             vdx -= word_wid_;
-            for (unsigned bdx = 0; bdx < word_wid_; bdx += 1) {
-                  if (array_[adx].value(bdx))
-                        vec.set_bit(vdx+bdx, BIT4_1);
-            }
-            adx++;
+	    if (const unsigned long*src = word_ptr_(adx))
+		  vec.setarray(vdx, word_wid_, src);
       }
 
       return vec;
 }
 
+vvp_darray_vec2::~vvp_darray_vec2()
+{
+}
+
+unsigned long* vvp_darray_vec2::word_ptr_(unsigned adr, bool)
+{
+      return &bits_[adr * word_cnt_];
+}
+
+const unsigned long* vvp_darray_vec2::word_ptr_(unsigned adr) const
+{
+      return &bits_[adr * word_cnt_];
+}
+
+vvp_darray_sparse_vec2::vvp_darray_sparse_vec2(size_t siz, unsigned word_wid)
+: vvp_darray_vec2_base(siz, word_wid),
+  pages_((siz+PAGE_WORDS-1) / PAGE_WORDS, (unsigned long*)0)
+{
+}
+
+vvp_darray_sparse_vec2::~vvp_darray_sparse_vec2()
+{
+      for (size_t idx = 0 ; idx < pages_.size() ; idx += 1)
+	    delete[]pages_[idx];
+}
+
+unsigned long* vvp_darray_sparse_vec2::word_ptr_(unsigned adr, bool alloc)
+{
+      unsigned long*&page = pages_[adr / PAGE_WORDS];
+      if (page == 0) {
+	    if (! alloc)
+		  return 0;
+
+	    unsigned cnt = PAGE_WORDS * word_cnt_;
+	    page = new unsigned long[cnt];
+	    for (unsigned idx = 0 ; idx < cnt ; idx += 1)
+		  page[idx] = 0;
+      }
+      return page + (adr % PAGE_WORDS) * word_cnt_;
+}
+
+const unsigned long* vvp_darray_sparse_vec2::word_ptr_(unsigned adr) const
+{
+      const unsigned long*page = pages_[adr / PAGE_WORDS];
+      if (page == 0)
+	    return 0;
+      return page + (adr % PAGE_WORDS) * word_cnt_;
+}
+
 vvp_darray_object::~vvp_darray_object()
 {
 }
@@ -84,12 +84,18 @@ class vvp_darray_vec4 : public vvp_darray {
       unsigned word_wid_;
 };
 
-class vvp_darray_vec2 : public vvp_darray {
+/*
+ * The words of a 2-state array are packed into machine words, one bit
+ * per bit, with each array word starting on a machine word
+ * boundary. There is no per-word object, and words that have not been
+ * written read as zero. This base class does the packing, and the
+ * derived classes decide where the words live.
+ */
+class vvp_darray_vec2_base : public vvp_darray {
 
     public:
-      inline vvp_darray_vec2(size_t siz, unsigned word_wid) :
-                             array_(siz), word_wid_(word_wid) { }
-      ~vvp_darray_vec2();
+      vvp_darray_vec2_base(size_t siz, unsigned word_wid);
+      ~vvp_darray_vec2_base();
 
       size_t get_size(void) const;
       void set_word(unsigned adr, const vvp_vector4_t&value);
@@ -97,9 +103,59 @@ class vvp_darray_vec2 : public vvp_darray {
       void shallow_copy(const vvp_object*obj);
       vvp_vector4_t get_bitstream(bool as_vec4);
 
-    private:
-      std::vector<vvp_vector2_t> array_;
+    protected:
+      enum { BITS_PER_WORD = 8 * sizeof(unsigned long) };
+	// Return the machine words for the array word at adr, which
+	// must be in range. If the storage does not exist yet, then
+	// create it if alloc is true, or return nil if not.
+      virtual unsigned long*word_ptr_(unsigned adr, bool alloc) =0;
+	// Return the machine words for reading only. This is nil if
+	// the storage does not exist, in which case the word is zero.
+      virtual const unsigned long*word_ptr_(unsigned adr) const =0;
+
+      size_t size_;
       unsigned word_wid_;
+	// The number of machine words for each array word.
+      unsigned word_cnt_;
+};
+
+/*
+ * The dense 2-state array keeps all the words in one contiguous array.
+ */
+class vvp_darray_vec2 : public vvp_darray_vec2_base {
+
+    public:
+      inline vvp_darray_vec2(size_t siz, unsigned word_wid) :
+                             vvp_darray_vec2_base(siz, word_wid),
+                             bits_(siz * word_cnt_, 0) { }
+      ~vvp_darray_vec2();
+
+    private:
+      unsigned long*word_ptr_(unsigned adr, bool alloc);
+      const unsigned long*word_ptr_(unsigned adr) const;
+
+      std::vector<unsigned long> bits_;
+};
+
+/*
+ * This is a sparse 2-state array for static arrays that are too big
+ * to allocate up front. The words are kept in pages of PAGE_WORDS
+ * words that are allocated the first time a word in the page is
+ * written. Pages that are not allocated read as zero, so the array
+ * takes memory only for the parts that are used.
+ */
+class vvp_darray_sparse_vec2 : public vvp_darray_vec2_base {
+
+    public:
+      vvp_darray_sparse_vec2(size_t siz, unsigned word_wid);
+      ~vvp_darray_sparse_vec2();
+
+    private:
+      enum { PAGE_WORDS = 1024 };
+      unsigned long*word_ptr_(unsigned adr, bool alloc);
+      const unsigned long*word_ptr_(unsigned adr) const;
+
+      std::vector<unsigned long*> pages_;
 };
 
 class vvp_darray_real : public vvp_darray {
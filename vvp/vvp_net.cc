@@ -33,6 +33,7 @@
 # include  <climits>
 # include  <cmath>
 # include  <cassert>
+# include  <vector>
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
 # include  <map>
@@ -57,6 +58,10 @@ static vvp_net_t **vvp_net_pool = NULL;
 static unsigned vvp_net_pool_count = 0;
 #endif
 static size_t vvp_net_alloc_remaining = 0;
+// All the chunks allocated so far, so that the nets can be scanned.
+static std::vector<vvp_net_t*> vvp_net_chunks;
+// The storage for all the frozen fanout arrays.
+static vvp_fanout_s*vvp_fanout_table = 0;
 // For statistics, count the vvp_nets allocated and the bytes of alloc
 // chunks allocated.
 unsigned long count_vvp_nets = 0;
@@ -69,6 +74,7 @@ void* vvp_net_t::operator new (size_t size)
 	    vvp_net_alloc_table = ::new vvp_net_t[VVP_NET_CHUNK];
 	    vvp_net_alloc_remaining = VVP_NET_CHUNK;
 	    size_vvp_nets += size*VVP_NET_CHUNK;
+	    vvp_net_chunks.push_back(vvp_net_alloc_table);
 #ifdef CHECK_WITH_VALGRIND
 	    VALGRIND_MAKE_MEM_NOACCESS(vvp_net_alloc_table, size*VVP_NET_CHUNK);
 	    VALGRIND_CREATE_MEMPOOL(vvp_net_alloc_table, 0, 0);
@@ -179,6 +185,12 @@ void vvp_net_pool_delete()
       free(vvp_net_pool);
       vvp_net_pool = NULL;
       vvp_net_pool_count = 0;
+
+      vvp_vector4_t::delete_pool();
+
+      delete[] vvp_fanout_table;
+      vvp_fanout_table = 0;
+      vvp_net_chunks.clear();
 }
 #endif
 
@@ -194,8 +206,126 @@ vvp_net_t::vvp_net_t()
       fil = 0;
 }
 
+uintptr_t vvp_net_t::fanout_table_base_ = 0;
+uintptr_t vvp_net_t::fanout_table_size_ = 0;
+unsigned long vvp_net_t::count_fanout_nets = 0;
+unsigned long vvp_net_t::count_fanout_targets = 0;
+unsigned long vvp_net_t::count_filter_sends = 0;
+unsigned long vvp_net_t::count_filter_copies = 0;
+
+/*
+ * Copy the fan-out chain of every net that has more than one receiver
+ * into a contiguous array of (fun, port) pairs. All the arrays are
+ * carved out of a single table so that the fan-out lists are dense in
+ * memory as well. The nets themselves stay where they are, since
+ * pointers to them are held all over (code space, VPI objects, etc.)
+ */
+void vvp_net_freeze_fanout(void)
+{
+      assert(vvp_fanout_table == 0);
+
+      size_t total = 0;
+      for (size_t cdx = 0 ; cdx < vvp_net_chunks.size() ; cdx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[cdx];
+	    size_t cnt = VVP_NET_CHUNK;
+	    if (cdx+1 == vvp_net_chunks.size())
+		  cnt -= vvp_net_alloc_remaining;
+
+	    for (size_t idx = 0 ; idx < cnt ; idx += 1) {
+		  vvp_net_ptr_t cur = chunk[idx].out_;
+		  unsigned len = 0;
+		  while (vvp_net_t*net = cur.ptr()) {
+			len += 1;
+			cur = net->port[cur.port()];
+		  }
+		  if (len < 2)
+			continue;
+		  vvp_net_t::count_fanout_nets += 1;
+		  vvp_net_t::count_fanout_targets += len;
+		  total += len + 2;
+	    }
+      }
+
+      if (total == 0)
+	    return;
+
+      vvp_fanout_table = new vvp_fanout_s[total];
+      vvp_fanout_s*fill = vvp_fanout_table;
+
+      for (size_t cdx = 0 ; cdx < vvp_net_chunks.size() ; cdx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[cdx];
+	    size_t cnt = VVP_NET_CHUNK;
+	    if (cdx+1 == vvp_net_chunks.size())
+		  cnt -= vvp_net_alloc_remaining;
+
+	    for (size_t idx = 0 ; idx < cnt ; idx += 1) {
+		  vvp_net_t*src = chunk + idx;
+		  vvp_net_ptr_t cur = src->out_;
+		  if (cur.nil() || cur.ptr()->port[cur.port()].nil())
+			continue;
+
+		    // Leave the first entry for the chain head.
+		  fill += 1;
+		  src->set_frozen_fanout_(fill);
+		  while (vvp_net_t*net = cur.ptr()) {
+			  // Receivers without a function are skipped
+			  // by the chain walk, so leave them out.
+			if (net->fun) {
+			      fill->fun = net->fun;
+			      fill->port = cur;
+			      fill += 1;
+			}
+			cur = net->port[cur.port()];
+		  }
+		  fill->fun = 0;
+		  fill->port = vvp_net_ptr_t(0,0);
+		  fill += 1;
+	    }
+      }
+
+      assert(fill <= vvp_fanout_table + total);
+      vvp_net_t::fanout_table_base_ = reinterpret_cast<uintptr_t>(vvp_fanout_table);
+      vvp_net_t::fanout_table_size_ = total * sizeof(vvp_fanout_s);
+}
+
+void vvp_net_scan(void (*fun)(vvp_net_t*net, void*cd), void*cd)
+{
+      for (size_t cdx = 0 ; cdx < vvp_net_chunks.size() ; cdx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[cdx];
+	    size_t cnt = VVP_NET_CHUNK;
+	    if (cdx+1 == vvp_net_chunks.size())
+		  cnt -= vvp_net_alloc_remaining;
+
+	    for (size_t idx = 0 ; idx < cnt ; idx += 1)
+		  fun(chunk + idx, cd);
+      }
+}
+
+vvp_net_ptr_t vvp_net_t::single_receiver(void) const
+{
+      vvp_net_ptr_t head = out_chain_();
+      if (head.nil() || ! head.ptr()->port[head.port()].nil())
+	    return vvp_net_ptr_t(0,0);
+
+      return head;
+}
+
+void vvp_net_t::set_frozen_fanout_(vvp_fanout_s*list)
+{
+      list[-1].fun = 0;
+      list[-1].port = out_;
+      out_ = vvp_net_ptr_t(reinterpret_cast<vvp_net_t*>(list), 0);
+}
+
+void vvp_net_t::thaw_fanout_()
+{
+      if (const vvp_fanout_s*list = frozen_fanout_())
+	    out_ = frozen_chain_(list);
+}
+
 void vvp_net_t::link(vvp_net_ptr_t port_to_link)
 {
+      thaw_fanout_();
       vvp_net_t*net = port_to_link.ptr();
       net->port[port_to_link.port()] = out_;
       out_ = port_to_link;
@@ -209,6 +339,7 @@ void vvp_net_t::link(vvp_net_ptr_t port_to_link)
  */
 void vvp_net_t::unlink(vvp_net_ptr_t dst_ptr)
 {
+      thaw_fanout_();
       vvp_net_t*net = dst_ptr.ptr();
       unsigned net_port = dst_ptr.port();
 
@@ -557,6 +688,297 @@ unsigned long multiply_with_carry(unsigned long a, unsigned long b,
       return (r1 << (CPU_WORD_BITS/2)) + r00;
 }
 
+/*
+ * The following functions do arithmetic on wide unsigned values that
+ * are held in arrays of words, least significant word first. They
+ * are the engines behind the multiply, divide and modulus operators
+ * of the wide vectors.
+ */
+
+unsigned long karatsuba_words = 32;
+
+static inline bool use_long_multiply(unsigned words)
+{
+      return words < karatsuba_words || words < 4;
+}
+
+  // res = a + b, where a has an words and b has bn <= an words. The
+  // carry out of the top word is returned.
+static unsigned long add_words(unsigned long*res,
+			       const unsigned long*a, unsigned an,
+			       const unsigned long*b, unsigned bn)
+{
+      unsigned long carry = 0;
+      for (unsigned idx = 0 ; idx < bn ; idx += 1)
+	    res[idx] = add_with_carry(a[idx], b[idx], carry);
+      for (unsigned idx = bn ; idx < an ; idx += 1)
+	    res[idx] = add_with_carry(a[idx], 0, carry);
+      return carry;
+}
+
+  // res -= b, where res has rn words and b has bn <= rn words.
+static void sub_words(unsigned long*res, unsigned rn,
+		      const unsigned long*b, unsigned bn)
+{
+      unsigned long carry = 1;
+      for (unsigned idx = 0 ; idx < bn ; idx += 1)
+	    res[idx] = add_with_carry(res[idx], ~b[idx], carry);
+      for (unsigned idx = bn ; idx < rn ; idx += 1)
+	    res[idx] = add_with_carry(res[idx], ~0UL, carry);
+}
+
+  // res = a * b, where res has an+bn words.
+static void multiply_words_long(unsigned long*res,
+				const unsigned long*a, unsigned an,
+				const unsigned long*b, unsigned bn)
+{
+      for (unsigned idx = 0 ; idx < an+bn ; idx += 1)
+	    res[idx] = 0;
+
+      for (unsigned adx = 0 ; adx < an ; adx += 1) {
+	    unsigned long tmpa = a[adx];
+	    if (tmpa == 0)
+		  continue;
+
+	    unsigned long carry = 0;
+	    for (unsigned bdx = 0 ; bdx < bn ; bdx += 1) {
+		  unsigned long high;
+		  unsigned long low = multiply_with_carry(tmpa, b[bdx], high);
+		  low += carry;
+		  high += low < carry;
+		  res[adx+bdx] += low;
+		  high += res[adx+bdx] < low;
+		  carry = high;
+	    }
+	    res[adx+bn] = carry;
+      }
+}
+
+  // res = a * b, where a and b have words words and res has twice
+  // that. The halves of the operands are multiplied in three
+  // smaller products instead of four:
+  //    a*b = z2*B^2l + (z1 - z2 - z0)*B^l + z0
+  // with z0 = a0*b0, z2 = a1*b1 and z1 = (a0+a1)*(b0+b1).
+static void multiply_words_full(unsigned long*res, const unsigned long*a,
+				const unsigned long*b, unsigned words)
+{
+      if (use_long_multiply(words)) {
+	    multiply_words_long(res, a, words, b, words);
+	    return;
+      }
+
+      unsigned lo = (words + 1) / 2;
+      unsigned hi = words - lo;
+
+      multiply_words_full(res, a, b, lo);
+      multiply_words_full(res+2*lo, a+lo, b+lo, hi);
+
+      unsigned long*sa = new unsigned long[lo+1];
+      unsigned long*sb = new unsigned long[lo+1];
+      unsigned long*mid = new unsigned long[2*lo+2];
+
+      sa[lo] = add_words(sa, a, lo, a+lo, hi);
+      sb[lo] = add_words(sb, b, lo, b+lo, hi);
+      multiply_words_full(mid, sa, sb, lo+1);
+      sub_words(mid, 2*lo+2, res, 2*lo);
+      sub_words(mid, 2*lo+2, res+2*lo, 2*hi);
+
+	// The middle term is now a0*b1 + a1*b0, which fits in the
+	// remaining words of the result.
+      unsigned mid_words = 2*words - lo;
+      if (mid_words > 2*lo+2)
+	    mid_words = 2*lo+2;
+      add_words(res+lo, res+lo, 2*words-lo, mid, mid_words);
+
+      delete[]mid;
+      delete[]sb;
+      delete[]sa;
+}
+
+void multiply_words(unsigned long*res, const unsigned long*a,
+		    const unsigned long*b, unsigned words)
+{
+      if (use_long_multiply(words)) {
+	    for (unsigned idx = 0 ; idx < words ; idx += 1)
+		  res[idx] = 0;
+
+	    for (unsigned adx = 0 ; adx < words ; adx += 1) {
+		  unsigned long tmpa = a[adx];
+		  if (tmpa == 0)
+			continue;
+
+		  unsigned long carry = 0;
+		  for (unsigned bdx = 0 ; adx+bdx < words ; bdx += 1) {
+			unsigned long high;
+			unsigned long low = multiply_with_carry(tmpa, b[bdx], high);
+			low += carry;
+			high += low < carry;
+			res[adx+bdx] += low;
+			high += res[adx+bdx] < low;
+			carry = high;
+		  }
+	    }
+	    return;
+      }
+
+	// Only the low words of the product are wanted, so the full
+	// product of the low halves is added to the truncated cross
+	// products. The a1*b1 product is entirely out of range.
+      unsigned lo = (words + 1) / 2;
+      unsigned hi = words - lo;
+
+      unsigned long*tmp = new unsigned long[2*lo];
+      multiply_words_full(tmp, a, b, lo);
+      for (unsigned idx = 0 ; idx < words ; idx += 1)
+	    res[idx] = tmp[idx];
+
+      multiply_words(tmp, a+lo, b, hi);
+      add_words(res+lo, res+lo, hi, tmp, hi);
+      multiply_words(tmp, a, b+lo, hi);
+      add_words(res+lo, res+lo, hi, tmp, hi);
+
+      delete[]tmp;
+}
+
+/*
+ * The divide uses the long division of Knuth (The Art of Computer
+ * Programming, Vol. 2, Algorithm D). The digits are half words, so
+ * that the product or quotient of two digits fits in a word.
+ */
+static const unsigned DIGIT_BITS = CPU_WORD_BITS / 2;
+static const unsigned long DIGIT_MASK = (1UL << DIGIT_BITS) - 1;
+static const unsigned long DIGIT_BASE = 1UL << DIGIT_BITS;
+
+static inline unsigned long get_digit(const unsigned long*val, unsigned idx)
+{
+      return (val[idx/2] >> (DIGIT_BITS * (idx%2))) & DIGIT_MASK;
+}
+
+static inline void set_digit(unsigned long*val, unsigned idx,
+			     unsigned long digit)
+{
+      val[idx/2] |= digit << (DIGIT_BITS * (idx%2));
+}
+
+bool divide_words(unsigned long*quot, unsigned long*rem,
+		  const unsigned long*a, const unsigned long*b, unsigned words)
+{
+      unsigned m = 2*words;
+      while (m > 0 && get_digit(a, m-1) == 0)
+	    m -= 1;
+      unsigned n = 2*words;
+      while (n > 0 && get_digit(b, n-1) == 0)
+	    n -= 1;
+
+      if (n == 0)
+	    return false;
+
+      for (unsigned idx = 0 ; idx < words ; idx += 1) {
+	    quot[idx] = 0;
+	    rem[idx] = 0;
+      }
+
+      if (m < n) {
+	    for (unsigned idx = 0 ; idx < words ; idx += 1)
+		  rem[idx] = a[idx];
+	    return true;
+      }
+
+      if (n == 1) {
+	    unsigned long v = get_digit(b, 0);
+	    unsigned long r = 0;
+	    for (unsigned idx = m ; idx > 0 ; idx -= 1) {
+		  unsigned long u = (r << DIGIT_BITS) | get_digit(a, idx-1);
+		  set_digit(quot, idx-1, u / v);
+		  r = u % v;
+	    }
+	    rem[0] = r;
+	    return true;
+      }
+
+	// Normalize the divisor so that its top digit has its top bit
+	// set. This keeps the estimates of the quotient digits within
+	// 2 of the correct value.
+      unsigned shift = 0;
+      while ((get_digit(b, n-1) << shift & (DIGIT_BASE >> 1)) == 0)
+	    shift += 1;
+
+      unsigned long*vn = new unsigned long[n];
+      unsigned long*un = new unsigned long[m+1];
+
+      for (unsigned idx = n-1 ; idx > 0 ; idx -= 1)
+	    vn[idx] = ((get_digit(b, idx) << shift)
+		       | (get_digit(b, idx-1) >> (DIGIT_BITS-shift)))
+		  & DIGIT_MASK;
+      vn[0] = (get_digit(b, 0) << shift) & DIGIT_MASK;
+
+      un[m] = get_digit(a, m-1) >> (DIGIT_BITS-shift);
+      for (unsigned idx = m-1 ; idx > 0 ; idx -= 1)
+	    un[idx] = ((get_digit(a, idx) << shift)
+		       | (get_digit(a, idx-1) >> (DIGIT_BITS-shift)))
+		  & DIGIT_MASK;
+      un[0] = (get_digit(a, 0) << shift) & DIGIT_MASK;
+
+      for (unsigned jdx = m-n+1 ; jdx > 0 ; jdx -= 1) {
+	    unsigned j = jdx - 1;
+
+	      // Estimate the quotient digit from the top two digits
+	      // of the remainder and the top digit of the divisor,
+	      // and correct it with the next digit.
+	    unsigned long num = (un[j+n] << DIGIT_BITS) | un[j+n-1];
+	    unsigned long qhat = num / vn[n-1];
+	    unsigned long rhat = num % vn[n-1];
+	    while (qhat >= DIGIT_BASE
+		   || qhat*vn[n-2] > ((rhat << DIGIT_BITS) | un[j+n-2])) {
+		  qhat -= 1;
+		  rhat += vn[n-1];
+		  if (rhat >= DIGIT_BASE)
+			break;
+	    }
+
+	      // Multiply and subtract.
+	    unsigned long carry = 0;
+	    unsigned long borrow = 0;
+	    for (unsigned idx = 0 ; idx < n ; idx += 1) {
+		  unsigned long prod = qhat*vn[idx] + carry;
+		  carry = prod >> DIGIT_BITS;
+		  unsigned long tmp = un[idx+j] + DIGIT_BASE
+			- (prod & DIGIT_MASK) - borrow;
+		  un[idx+j] = tmp & DIGIT_MASK;
+		  borrow = 1 - (tmp >> DIGIT_BITS);
+	    }
+	    unsigned long tmp = un[j+n] + DIGIT_BASE - carry - borrow;
+	    un[j+n] = tmp & DIGIT_MASK;
+
+	      // If the result went negative, then the estimate was
+	      // one too large, so add the divisor back in.
+	    if ((tmp >> DIGIT_BITS) == 0) {
+		  qhat -= 1;
+		  carry = 0;
+		  for (unsigned idx = 0 ; idx < n ; idx += 1) {
+			tmp = un[idx+j] + vn[idx] + carry;
+			un[idx+j] = tmp & DIGIT_MASK;
+			carry = tmp >> DIGIT_BITS;
+		  }
+		  un[j+n] = (un[j+n] + carry) & DIGIT_MASK;
+	    }
+
+	    set_digit(quot, j, qhat);
+      }
+
+	// The remainder is what is left of un, un-normalized.
+      for (unsigned idx = 0 ; idx < n ; idx += 1) {
+	    unsigned long digit = un[idx] >> shift;
+	    if (shift > 0)
+		  digit |= (un[idx+1] << (DIGIT_BITS-shift)) & DIGIT_MASK;
+	    set_digit(rem, idx, digit);
+      }
+
+      delete[]un;
+      delete[]vn;
+      return true;
+}
+
 
 void vvp_send_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&val)
 {
@@ -695,10 +1117,52 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
  * This function should ONLY BE CALLED FROM vvp_vector4_t::copy_from_,
  * as it performs part of that functions tasks.
  */
+unsigned long* vvp_vector4_t::array_pool_[POOL_WORDS+1];
+unsigned long vvp_vector4_t::count_array_allocs = 0;
+unsigned long vvp_vector4_t::count_array_heap = 0;
+
+unsigned long* vvp_vector4_t::allocate_array_(unsigned cnt)
+{
+      count_array_allocs += 1;
+      if (cnt <= POOL_WORDS && array_pool_[cnt]) {
+	    unsigned long*res = array_pool_[cnt];
+	    array_pool_[cnt] = *reinterpret_cast<unsigned long**>(res);
+	    return res;
+      }
+
+      count_array_heap += 1;
+      return new unsigned long[2*cnt];
+}
+
+void vvp_vector4_t::release_array_(unsigned long*ptr, unsigned cnt)
+{
+      if (cnt <= POOL_WORDS) {
+	      // The free list link is kept in the (now unused) array
+	      // itself. Even the smallest array has room for a pointer.
+	    *reinterpret_cast<unsigned long**>(ptr) = array_pool_[cnt];
+	    array_pool_[cnt] = ptr;
+	    return;
+      }
+
+      delete[]ptr;
+}
+
+#ifdef CHECK_WITH_VALGRIND
+void vvp_vector4_t::delete_pool(void)
+{
+      for (unsigned cnt = 0 ; cnt <= POOL_WORDS ; cnt += 1) {
+	    while (unsigned long*cur = array_pool_[cnt]) {
+		  array_pool_[cnt] = *reinterpret_cast<unsigned long**>(cur);
+		  delete[]cur;
+	    }
+      }
+}
+#endif
+
 void vvp_vector4_t::copy_from_big_(const vvp_vector4_t&that)
 {
       unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-      abits_ptr_ = new unsigned long[2*words];
+      abits_ptr_ = allocate_array_(words);
       bbits_ptr_ = abits_ptr_ + words;
 
       for (unsigned idx = 0 ;  idx < words ;  idx += 1)
@@ -717,7 +1181,7 @@ void vvp_vector4_t::copy_inverted_from_(const vvp_vector4_t&that)
       size_ = that.size_;
       if (size_ > BITS_PER_WORD) {
 	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*words];
+	    abits_ptr_ = allocate_array_(words);
 	    bbits_ptr_ = abits_ptr_ + words;
 
 	    unsigned remaining = size_;
@@ -743,21 +1207,16 @@ void vvp_vector4_t::copy_inverted_from_(const vvp_vector4_t&that)
 }
 
 /* Make sure to set size_ before calling this routine. */
-void vvp_vector4_t::allocate_words_(unsigned long inita, unsigned long initb)
+void vvp_vector4_t::allocate_words_big_(unsigned long inita, unsigned long initb)
 {
-      if (size_ > BITS_PER_WORD) {
-	    unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*cnt];
-	    bbits_ptr_ = abits_ptr_ + cnt;
-	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
-		  abits_ptr_[idx] = inita;
-	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
-		  bbits_ptr_[idx] = initb;
-
-      } else {
-	    abits_val_ = inita;
-	    bbits_val_ = initb;
-      }
+      assert(size_ > BITS_PER_WORD);
+      unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+      abits_ptr_ = allocate_array_(cnt);
+      bbits_ptr_ = abits_ptr_ + cnt;
+      for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
+	    abits_ptr_[idx] = inita;
+      for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
+	    bbits_ptr_[idx] = initb;
 }
 
 vvp_vector4_t::vvp_vector4_t(unsigned size__, double val)
@@ -997,7 +1456,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 		  return;
 	    }
 
-	    unsigned long*newbits = new unsigned long[2*newcnt];
+	    unsigned long*newbits = allocate_array_(newcnt);
 
 	    if (cnt > 1) {
 		  unsigned trans = cnt;
@@ -1009,7 +1468,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 		  for (unsigned idx = 0 ;  idx < trans ;  idx += 1)
 			newbits[newcnt+idx] = bbits_ptr_[idx];
 
-		  delete[]abits_ptr_;
+		  release_array_(abits_ptr_, cnt);
 
 	    } else {
 		  newbits[0] = abits_val_;
@@ -1037,7 +1496,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 	    if (cnt > 1) {
 		  unsigned long newvala = abits_ptr_[0];
 		  unsigned long newvalb = bbits_ptr_[0];
-		  delete[]abits_ptr_;
+		  release_array_(abits_ptr_, cnt);
 		  abits_val_ = newvala;
 		  bbits_val_ = newvalb;
 	    }
@@ -1198,6 +1657,53 @@ void vvp_vector4_t::setarray(unsigned adr, unsigned wid, const unsigned long*val
       }
 }
 
+void vvp_vector4_t::get_words(unsigned adr, unsigned wid,
+			      unsigned long*abits, unsigned long*bbits) const
+{
+      assert(adr+wid <= size_);
+      if (wid == 0)
+	    return;
+
+      unsigned long tail = (wid % BITS_PER_WORD)
+	    ? (1UL << (wid % BITS_PER_WORD)) - 1
+	    : ~0UL;
+
+      if (size_ <= BITS_PER_WORD) {
+	    abits[0] = (abits_val_ >> adr) & tail;
+	    bbits[0] = (bbits_val_ >> adr) & tail;
+	    return;
+      }
+
+      const unsigned long*ap = abits_ptr_ + adr/BITS_PER_WORD;
+      const unsigned long*bp = bbits_ptr_ + adr/BITS_PER_WORD;
+      unsigned off = adr % BITS_PER_WORD;
+      unsigned cnt = (wid + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+      if (off == 0) {
+	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1) {
+		  abits[idx] = ap[idx];
+		  bbits[idx] = bp[idx];
+	    }
+      } else {
+	      // The source word after the last one is only needed if
+	      // the remaining bits spill over into it.
+	    unsigned src_cnt = (off + wid + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1) {
+		  unsigned long atmp = ap[idx] >> off;
+		  unsigned long btmp = bp[idx] >> off;
+		  if (idx+1 < src_cnt) {
+			atmp |= ap[idx+1] << (BITS_PER_WORD-off);
+			btmp |= bp[idx+1] << (BITS_PER_WORD-off);
+		  }
+		  abits[idx] = atmp;
+		  bbits[idx] = btmp;
+	    }
+      }
+
+      abits[cnt-1] &= tail;
+      bbits[cnt-1] &= tail;
+}
+
 /*
  * Set the bits of that vector, which must be a subset of this vector,
  * into the addressed part of this vector. Use bit masking and word
@@ -1674,30 +2180,7 @@ void vvp_vector4_t::mul(const vvp_vector4_t&that)
 	// separate from the "this" array because we are making
 	// multiple passes.
       unsigned long*res = new unsigned long[cnt];
-      for (int idx = 0 ; idx < cnt ; idx += 1)
-	    res[idx] = 0;
-
-      for (int mul_a = 0 ; mul_a < cnt ; mul_a += 1) {
-	    unsigned long lval = abits_ptr_[mul_a];
-	    if (mul_a == (cnt-1))
-		  lval &= mask;
-
-	    for (int mul_b = 0 ; mul_b < (cnt-mul_a) ; mul_b += 1) {
-		  unsigned long rval = that.abits_ptr_[mul_b];
-		  if (mul_b == (cnt-1))
-			rval &= mask;
-
-		  unsigned long sum;
-		  unsigned long tmp = multiply_with_carry(lval, rval, sum);
-		  int base = mul_a + mul_b;
-		  unsigned long carry = 0;
-		  res[base] = add_with_carry(res[base], tmp, carry);
-		  for (int add_idx = base+1 ; add_idx < cnt ; add_idx += 1) {
-			res[add_idx] = add_with_carry(res[add_idx], sum, carry);
-			sum = 0;
-		  }
-	    }
-      }
+      multiply_words(res, abits_ptr_, that.abits_ptr_, cnt);
 
 	// Replace the "this" value with the calculated result. We
 	// know a-priori that the bbits are zero and unchanged.
@@ -1745,6 +2228,43 @@ bool vvp_vector4_t::eeq(const vvp_vector4_t&that) const
       return true;
 }
 
+/*
+ * This is the part of update() for vectors that do not fit in a
+ * single word, or that change size. The scan stops at the first word
+ * that differs, and only the words from there on are copied.
+ */
+bool vvp_vector4_t::update_big_(const vvp_vector4_t&that)
+{
+      if (size_ != that.size_) {
+	    *this = that;
+	    return true;
+      }
+
+      assert(size_ > BITS_PER_WORD);
+      unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+      unsigned words = size_ / BITS_PER_WORD;
+
+      unsigned idx = 0;
+      while (idx < words && abits_ptr_[idx] == that.abits_ptr_[idx]
+	     && bbits_ptr_[idx] == that.bbits_ptr_[idx])
+	    idx += 1;
+
+      if (idx == words) {
+	    if (words == cnt)
+		  return false;
+	    unsigned long mask = (1UL << (size_%BITS_PER_WORD)) - 1;
+	    if ((((abits_ptr_[idx] ^ that.abits_ptr_[idx])
+		  | (bbits_ptr_[idx] ^ that.bbits_ptr_[idx])) & mask) == 0)
+		  return false;
+      }
+
+      for ( ; idx < cnt ;  idx += 1) {
+	    abits_ptr_[idx] = that.abits_ptr_[idx];
+	    bbits_ptr_[idx] = that.bbits_ptr_[idx];
+      }
+      return true;
+}
+
 bool vvp_vector4_t::eq_xz(const vvp_vector4_t&that) const
 {
       if (size_ != that.size_)
@@ -1948,6 +2468,29 @@ vvp_vector4_t& vvp_vector4_t::operator |= (const vvp_vector4_t&that)
       return *this;
 }
 
+vvp_vector4_t& vvp_vector4_t::operator ^= (const vvp_vector4_t&that)
+{
+	// The truth table is:
+	//     00 01 11 10
+	//  00 00 01 11 11
+	//  01 01 00 11 11
+	//  11 11 11 11 11
+	//  10 11 11 11 11
+      if (size_ <= BITS_PER_WORD) {
+	    bbits_val_ |= that.bbits_val_;
+	    abits_val_ = (abits_val_ ^ that.abits_val_) | bbits_val_;
+      } else {
+	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    for (unsigned idx = 0; idx < words ; idx += 1) {
+		  bbits_ptr_[idx] |= that.bbits_ptr_[idx];
+		  abits_ptr_[idx] = (abits_ptr_[idx] ^ that.abits_ptr_[idx])
+		                  | bbits_ptr_[idx];
+	    }
+      }
+
+      return *this;
+}
+
 /*
 * Add an integer to the vvp_vector4_t in place, bit by bit so that
 * there is no size limitations.
@@ -2200,55 +2743,170 @@ vvp_vector4_t vvp_vector4array_t::get_word_(v4cell*cell) const
       return res;
 }
 
-vvp_vector4array_sa::vvp_vector4array_sa(unsigned width__, unsigned words__)
-: vvp_vector4array_t(width__, words__)
+/*
+ * Copy wid bits starting at bit off of the packed plane src into the
+ * words of dst. The bits above wid in the last word of dst are
+ * cleared. The plane has an extra word at the end, so it is safe to
+ * read the word past the last bit.
+ */
+static void get_plane_bits(const unsigned long*src, unsigned long off,
+			   unsigned long*dst, unsigned wid)
 {
-      array_ = new v4cell[words_];
+      const unsigned BPW = 8*sizeof(unsigned long);
+      const unsigned long*ptr = src + off/BPW;
+      unsigned shift = off % BPW;
+      unsigned cnt = (wid + BPW - 1) / BPW;
 
-      if (width_ <= vvp_vector4_t::BITS_PER_WORD) {
-	    for (unsigned idx = 0 ; idx < words_ ; idx += 1) {
-		  array_[idx].abits_val_ = vvp_vector4_t::WORD_X_ABITS;
-		  array_[idx].bbits_val_ = vvp_vector4_t::WORD_X_BBITS;
-	    }
-      } else {
-	    for (unsigned idx = 0 ; idx < words_ ; idx += 1) {
-		  array_[idx].abits_ptr_ = 0;
-		  array_[idx].bbits_ptr_ = 0;
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    unsigned long val = ptr[idx] >> shift;
+	    if (shift)
+		  val |= ptr[idx+1] << (BPW - shift);
+	    dst[idx] = val;
+      }
+
+      if (wid % BPW)
+	    dst[cnt-1] &= (1UL << (wid % BPW)) - 1;
+}
+
+/*
+ * Write wid bits from the words of src into the packed plane dst,
+ * starting at bit off. The other bits of the plane are not changed.
+ */
+static void put_plane_bits(unsigned long*dst, unsigned long off,
+			   const unsigned long*src, unsigned wid)
+{
+      const unsigned BPW = 8*sizeof(unsigned long);
+      unsigned long*ptr = dst + off/BPW;
+      unsigned shift = off % BPW;
+
+      for (unsigned idx = 0 ; wid > 0 ; idx += 1) {
+	    unsigned trans = wid < BPW? wid : BPW;
+	    unsigned long mask = trans < BPW? (1UL << trans) - 1 : -1UL;
+	    unsigned long val = src[idx] & mask;
+
+	    ptr[idx] = (ptr[idx] & ~(mask << shift)) | (val << shift);
+	    if (shift && shift + trans > BPW) {
+		  ptr[idx+1] &= ~(mask >> (BPW - shift));
+		  ptr[idx+1] |= val >> (BPW - shift);
 	    }
+	    wid -= trans;
       }
 }
 
+vvp_vector4array_sa::vvp_vector4array_sa(unsigned width__, unsigned words__)
+: vvp_vector4array_t(width__, words__)
+{
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
+      plane_cnt_ = ((unsigned long)PAGE_WORDS * width_ + BPW - 1) / BPW;
+
+      unsigned npages = (words_ + PAGE_WORDS - 1) / PAGE_WORDS;
+      pages_ = new page_s*[npages];
+      for (unsigned idx = 0 ; idx < npages ; idx += 1)
+	    pages_[idx] = 0;
+}
+
 vvp_vector4array_sa::~vvp_vector4array_sa()
 {
-      if (array_) {
-	    if (width_ > vvp_vector4_t::BITS_PER_WORD) {
-		  for (unsigned idx = 0 ; idx < words_ ; idx += 1)
-			if (array_[idx].abits_ptr_)
-			      delete[]array_[idx].abits_ptr_;
-	    }
-	    delete[]array_;
+      unsigned npages = (words_ + PAGE_WORDS - 1) / PAGE_WORDS;
+      for (unsigned idx = 0 ; idx < npages ; idx += 1) {
+	    page_s*page = pages_[idx];
+	    if (page == 0)
+		  continue;
+	    delete[]page->abits;
+	    delete[]page->bbits;
+	    delete[]page->valid;
+	    delete page;
       }
+      delete[]pages_;
+}
+
+/*
+ * Make a cleared bit plane for a page. There is an extra word at the
+ * end so that get_plane_bits() and put_plane_bits() can touch the
+ * word after the last bit.
+ */
+unsigned long* vvp_vector4array_sa::make_plane_() const
+{
+      unsigned long*plane = new unsigned long[plane_cnt_ + 1];
+      for (unsigned long idx = 0 ; idx <= plane_cnt_ ; idx += 1)
+	    plane[idx] = 0;
+      return plane;
+}
+
+vvp_vector4array_sa::page_s* vvp_vector4array_sa::make_page_(unsigned pdx)
+{
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
+      page_s*page = new page_s;
+      page->abits = make_plane_();
+      page->bbits = 0;
+
+      unsigned vcnt = (PAGE_WORDS + BPW - 1) / BPW;
+      page->valid = new unsigned long[vcnt];
+      for (unsigned idx = 0 ; idx < vcnt ; idx += 1)
+	    page->valid[idx] = 0;
+
+      pages_[pdx] = page;
+      return page;
 }
 
 void vvp_vector4array_sa::set_word(unsigned index, const vvp_vector4_t&that)
 {
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
       assert(index < words_);
+      assert(that.size_ == width_);
 
-      v4cell*cell = &array_[index];
+      page_s*page = pages_[index / PAGE_WORDS];
+      if (page == 0)
+	    page = make_page_(index / PAGE_WORDS);
 
-      set_word_(cell, that);
+      const unsigned long*abits, *bbits;
+      if (width_ <= BPW) {
+	    abits = &that.abits_val_;
+	    bbits = &that.bbits_val_;
+      } else {
+	    abits = that.abits_ptr_;
+	    bbits = that.bbits_ptr_;
+      }
+
+      unsigned pos = index % PAGE_WORDS;
+      unsigned long off = (unsigned long)pos * width_;
+      put_plane_bits(page->abits, off, abits, width_);
+
+	// Only create the bbits plane if there is an X or Z to put in
+	// it. Otherwise the bbits are all 0, which is what a missing
+	// plane means.
+      if (page->bbits == 0 && that.has_xz())
+	    page->bbits = make_plane_();
+      if (page->bbits)
+	    put_plane_bits(page->bbits, off, bbits, width_);
+
+      page->valid[pos / BPW] |= 1UL << (pos % BPW);
 }
 
 vvp_vector4_t vvp_vector4array_sa::get_word(unsigned index) const
 {
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
       if (index >= words_)
 	    return vvp_vector4_t(width_, BIT4_X);
 
-      assert(index < words_);
+      const page_s*page = pages_[index / PAGE_WORDS];
+      unsigned pos = index % PAGE_WORDS;
+      if (page == 0 || ! (page->valid[pos / BPW] & (1UL << (pos % BPW))))
+	    return vvp_vector4_t(width_, BIT4_X);
 
-      v4cell*cell = &array_[index];
+      vvp_vector4_t res (width_, BIT4_0);
+      unsigned long off = (unsigned long)pos * width_;
+      if (width_ <= BPW) {
+	    get_plane_bits(page->abits, off, &res.abits_val_, width_);
+	    if (page->bbits)
+		  get_plane_bits(page->bbits, off, &res.bbits_val_, width_);
+      } else {
+	    get_plane_bits(page->abits, off, res.abits_ptr_, width_);
+	    if (page->bbits)
+		  get_plane_bits(page->bbits, off, res.bbits_ptr_, width_);
+      }
 
-      return get_word_(cell);
+      return res;
 }
 
 vvp_vector4array_aa::vvp_vector4array_aa(unsigned width__, unsigned words__)
@@ -2712,46 +3370,6 @@ vvp_vector2_t pow(const vvp_vector2_t&x, vvp_vector2_t&y)
       return res;
 }
 
-static void multiply_long(unsigned long a, unsigned long b,
-			  unsigned long&low, unsigned long&high)
-{
-      assert(sizeof(unsigned long) %2 == 0);
-
-      const unsigned long word_mask = (1UL << 4UL*sizeof(a)) - 1UL;
-      unsigned long tmpa;
-      unsigned long tmpb;
-      unsigned long res[4];
-
-      tmpa = a & word_mask;
-      tmpb = b & word_mask;
-      res[0] = tmpa * tmpb;
-      res[1] = res[0] >> 4UL*sizeof(unsigned long);
-      res[0] &= word_mask;
-
-      tmpa = (a >> 4UL*sizeof(unsigned long)) & word_mask;
-      tmpb = b & word_mask;
-      res[1] += tmpa * tmpb;
-      res[2] = res[1] >> 4UL*sizeof(unsigned long);
-      res[1] &= word_mask;
-
-      tmpa = a & word_mask;
-      tmpb = (b >> 4UL*sizeof(unsigned long)) & word_mask;
-      res[1] += tmpa * tmpb;
-      res[2] += res[1] >> 4UL*sizeof(unsigned long);
-      res[3]  = res[2] >> 4UL*sizeof(unsigned long);
-      res[1] &= word_mask;
-      res[2] &= word_mask;
-
-      tmpa = (a >> 4UL*sizeof(unsigned long)) & word_mask;
-      tmpb = (b >> 4UL*sizeof(unsigned long)) & word_mask;
-      res[2] += tmpa * tmpb;
-      res[3] += res[2] >> 4UL*sizeof(unsigned long);
-      res[2] &= word_mask;
-
-      high = (res[3] << 4UL*sizeof(unsigned long)) | res[2];
-      low  = (res[1] << 4UL*sizeof(unsigned long)) | res[0];
-}
-
 vvp_vector2_t operator * (const vvp_vector2_t&a, const vvp_vector2_t&b)
 {
       const unsigned bits_per_word = 8 * sizeof(a.vec_[0]);
@@ -2761,77 +3379,11 @@ vvp_vector2_t operator * (const vvp_vector2_t&a, const vvp_vector2_t&b)
       vvp_vector2_t r (0, a.size());
 
       unsigned words = (r.wid_ + bits_per_word - 1) / bits_per_word;
-
-      for (unsigned bdx = 0 ;  bdx < words ;  bdx += 1) {
-	    unsigned long tmpb = b.vec_[bdx];
-	    if (tmpb == 0)
-		  continue;
-
-	    for (unsigned adx = 0 ;  adx < words ;  adx += 1) {
-		  unsigned long tmpa = a.vec_[adx];
-		  if (tmpa == 0)
-			continue;
-
-		  unsigned long low, hig;
-		  multiply_long(tmpa, tmpb, low, hig);
-
-		  unsigned long carry = 0;
-		  for (unsigned sdx = 0
-			     ; (adx+bdx+sdx) < words
-			     ;  sdx += 1) {
-
-			r.vec_[adx+bdx+sdx] = add_carry(r.vec_[adx+bdx+sdx],
-							low, carry);
-			low = hig;
-			hig = 0;
-		  }
-	    }
-      }
+      multiply_words(r.vec_, a.vec_, b.vec_, words);
 
       return r;
 }
 
-static void div_mod (vvp_vector2_t dividend, vvp_vector2_t divisor,
-		     vvp_vector2_t&quotient, vvp_vector2_t&remainder)
-{
-
-      quotient = vvp_vector2_t(0, dividend.size());
-
-      if (divisor == quotient) {
-	    cerr << "ERROR: division by zero, exiting." << endl;
-	    exit(255);
-      }
-
-      if (dividend < divisor) {
-	    remainder = dividend;
-	    return;
-      }
-
-      vvp_vector2_t mask (1, dividend.size());
-
-	// Make the dividend 1 bit larger to prevent overflow of
-	// divtmp in startup.
-      dividend = vvp_vector2_t(dividend, dividend.size()+1);
-      vvp_vector2_t divtmp (divisor, dividend.size());
-
-      while (divtmp < dividend) {
-	    divtmp <<= 1;
-	    mask <<= 1;
-      }
-
-      while (dividend >= divisor) {
-	    if (divtmp <= dividend) {
-		  dividend -= divtmp;
-		  quotient += mask;
-	    }
-
-	    divtmp >>= 1;
-	    mask >>= 1;
-      }
-
-      remainder = vvp_vector2_t(dividend, mask.size());
-}
-
 vvp_vector2_t operator - (const vvp_vector2_t&that)
 {
       vvp_vector2_t neg(that);
@@ -2847,19 +3399,50 @@ vvp_vector2_t operator - (const vvp_vector2_t&that)
       return neg;
 }
 
+/*
+ * Divide the dividend by the divisor, both with the width of the
+ * dividend. If the divisor is wider, then it is first reduced to the
+ * width of the dividend, which is only safe if it is not larger than
+ * the dividend.
+ */
+static bool div_mod_prep (const vvp_vector2_t&dividend,
+			  const vvp_vector2_t&divisor)
+{
+      if (divisor.is_zero()) {
+	    cerr << "ERROR: division by zero, exiting." << endl;
+	    exit(255);
+      }
+
+      return !(dividend < divisor);
+}
+
 vvp_vector2_t operator / (const vvp_vector2_t&dividend,
 			  const vvp_vector2_t&divisor)
 {
-      vvp_vector2_t quot, rem;
-      div_mod(dividend, divisor, quot, rem);
+      vvp_vector2_t quot (0, dividend.size());
+      if (! div_mod_prep(dividend, divisor))
+	    return quot;
+
+      vvp_vector2_t rem (0, dividend.size());
+      vvp_vector2_t tmp (divisor, dividend.size());
+      unsigned words = (dividend.wid_ + vvp_vector2_t::BITS_PER_WORD-1) /
+	    vvp_vector2_t::BITS_PER_WORD;
+      divide_words(quot.vec_, rem.vec_, dividend.vec_, tmp.vec_, words);
       return quot;
 }
 
 vvp_vector2_t operator % (const vvp_vector2_t&dividend,
 			  const vvp_vector2_t&divisor)
 {
-      vvp_vector2_t quot, rem;
-      div_mod(dividend, divisor, quot, rem);
+      if (! div_mod_prep(dividend, divisor))
+	    return dividend;
+
+      vvp_vector2_t quot (0, dividend.size());
+      vvp_vector2_t rem (0, dividend.size());
+      vvp_vector2_t tmp (divisor, dividend.size());
+      unsigned words = (dividend.wid_ + vvp_vector2_t::BITS_PER_WORD-1) /
+	    vvp_vector2_t::BITS_PER_WORD;
+      divide_words(quot.vec_, rem.vec_, dividend.vec_, tmp.vec_, words);
       return rem;
 }
 
@@ -3151,6 +3734,109 @@ void vvp_vector8_t::set_vec(unsigned base, const vvp_vector8_t&that)
 	    set_bit(base+idx, that.value(idx));
 }
 
+/*
+ * The vvp_vector8_t resolver works on a machine word of vvp_scalar_t
+ * bytes at a time. Words that are identical, or where one side is
+ * all HiZ, are resolved without looking at the individual bytes. If
+ * all the bytes of both words are unambiguous (which is the common
+ * case of drivers that drive 0, 1 or Z) then the bytes are resolved
+ * in parallel by the same rules as fully_featured_resolv_() uses:
+ * the stronger value wins, and equal strengths with different values
+ * give an X of that strength. Anything else is resolved a byte at a
+ * time by the scalar resolver.
+ */
+static const unsigned long RESOLV_M01 = ~0UL / 0xff;
+static const unsigned long RESOLV_M07 = RESOLV_M01 * 0x07;
+static const unsigned long RESOLV_M08 = RESOLV_M01 * 0x08;
+static const unsigned long RESOLV_M0F = RESOLV_M01 * 0x0f;
+static const unsigned long RESOLV_M77 = RESOLV_M01 * 0x77;
+static const unsigned long RESOLV_M7F = RESOLV_M01 * 0x7f;
+static const unsigned long RESOLV_M80 = RESOLV_M01 * 0x80;
+
+  // Turn a mask with bit 3 set in the selected bytes into a mask with
+  // all the bits of the selected bytes set.
+static inline unsigned long resolv_expand_mask(unsigned long mask)
+{
+      return (mask >> 3) * 0xff;
+}
+
+static inline bool resolv_word(unsigned long a, unsigned long b,
+			       unsigned long&res)
+{
+      if (a == b) {
+	    res = a;
+	    return true;
+      }
+      if ((a & RESOLV_M77) == 0) {
+	    res = b;
+	    return true;
+      }
+      if ((b & RESOLV_M77) == 0) {
+	      // HiZ bytes of a still give way to b, as they do in the
+	      // scalar resolver, even though both are HiZ.
+	    unsigned long hiz = ~((a & RESOLV_M77) + RESOLV_M7F) & RESOLV_M80;
+	    hiz = (hiz >> 7) * 0xff;
+	    res = (a & ~hiz) | (b & hiz);
+	    return true;
+      }
+
+      if ((((a >> 4) ^ a) & RESOLV_M0F) != 0)
+	    return false;
+      if ((((b >> 4) ^ b) & RESOLV_M0F) != 0)
+	    return false;
+
+      unsigned long sa = a & RESOLV_M07;
+      unsigned long sb = b & RESOLV_M07;
+	// Bit 3 of each byte is set if the strength of that byte of a
+	// is non-zero, or if it is at least the strength of b (and
+	// the other way around).
+      unsigned long nza = (sa + RESOLV_M07) & RESOLV_M08;
+      unsigned long ge_a = ((sa | RESOLV_M08) - sb) & RESOLV_M08;
+      unsigned long ge_b = ((sb | RESOLV_M08) - sa) & RESOLV_M08;
+
+      unsigned long take_b = (ge_b & ~ge_a) | (~nza & RESOLV_M08);
+      unsigned long take_x = ge_a & ge_b & nza & (a ^ b);
+
+      unsigned long mb = resolv_expand_mask(take_b);
+      unsigned long mx = resolv_expand_mask(take_x);
+      res = (b & mb)
+	  | (((a & RESOLV_M77) | RESOLV_M80) & mx)
+	  | (a & ~(mb | mx));
+      return true;
+}
+
+vvp_vector8_t resolve(const vvp_vector8_t&a, const vvp_vector8_t&b)
+{
+      assert(a.size() == b.size());
+      vvp_vector8_t out (a.size());
+
+      unsigned char*out_ptr = out.size_ <= sizeof(out.val_) ? out.val_ : out.ptr_;
+      const unsigned char*a_ptr = a.size_ <= sizeof(a.val_) ? a.val_ : a.ptr_;
+      const unsigned char*b_ptr = b.size_ <= sizeof(b.val_) ? b.val_ : b.ptr_;
+
+	// The bytes are copied in and out of the words so that the
+	// byte order and alignment of the vectors do not matter.
+      for (unsigned idx = 0 ; idx < out.size_ ; idx += sizeof(unsigned long)) {
+	    unsigned cnt = out.size_ - idx;
+	    if (cnt > sizeof(unsigned long))
+		  cnt = sizeof(unsigned long);
+
+	    unsigned long wa = 0, wb = 0;
+	    memcpy(&wa, a_ptr+idx, cnt);
+	    memcpy(&wb, b_ptr+idx, cnt);
+	    unsigned long wo;
+	    if (resolv_word(wa, wb, wo)) {
+		  memcpy(out_ptr+idx, &wo, cnt);
+		  continue;
+	    }
+
+	    for (unsigned pdx = idx ; pdx < idx+cnt ; pdx += 1)
+		  out.set_bit(pdx, resolve(a.value(pdx), b.value(pdx)));
+      }
+
+      return out;
+}
+
 vvp_vector8_t part_expand(const vvp_vector8_t&that, unsigned wid, unsigned off)
 {
       assert(off < wid);
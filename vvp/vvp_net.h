@@ -232,6 +232,26 @@ static inline unsigned long add_with_carry(unsigned long a, unsigned long b,
 extern unsigned long multiply_with_carry(unsigned long a, unsigned long b,
 					 unsigned long&carry);
 
+/*
+ * These functions work on wide unsigned values stored in arrays of
+ * words, least significant word first, all of the same size. The
+ * multiply keeps the low words of the product. The divide returns
+ * false if the divisor is zero.
+ */
+extern void multiply_words(unsigned long*res, const unsigned long*a,
+			   const unsigned long*b, unsigned words);
+extern bool divide_words(unsigned long*quot, unsigned long*rem,
+			 const unsigned long*a, const unsigned long*b,
+			 unsigned words);
+
+/*
+ * Products of at least this many words are calculated by the
+ * Karatsuba method instead of the basic long multiplication. This is
+ * set with the -k flag. Values below 4 are treated as 4, since the
+ * Karatsuba split does not get any smaller than that.
+ */
+extern unsigned long karatsuba_words;
+
 /*
  * This class represents scalar values collected into vectors. The
  * vector values can be accessed individually, or treated as a
@@ -267,6 +287,12 @@ class vvp_vector4_t {
       vvp_vector4_t(const vvp_vector4_t&that);
       vvp_vector4_t(const vvp_vector4_t&that, bool invert_flag);
       vvp_vector4_t& operator= (const vvp_vector4_t&that);
+#if __cplusplus >= 201103L
+	// Moving a wide vector steals the word array, and leaves the
+	// source as an empty (zero width) vector.
+      vvp_vector4_t(vvp_vector4_t&&that) noexcept;
+      vvp_vector4_t& operator= (vvp_vector4_t&&that) noexcept;
+#endif
 
       ~vvp_vector4_t();
 
@@ -282,6 +308,20 @@ class vvp_vector4_t {
 	// in the array.
       unsigned long*subarray(unsigned idx, unsigned size, bool xz_to_0 =false) const;
       void setarray(unsigned idx, unsigned size, const unsigned long*val);
+	// Get the 2-value bits of a vector that fits in a single
+	// word. This is like subarray(0,size()) without the array
+	// allocation. Return false if the vector is too wide, or if
+	// there are XZ bits.
+      bool get_word2(unsigned long&val) const;
+	// Set a vector that fits in a single word to the 2-value bits
+	// of val. This is the reverse of get_word2.
+      void set_word2(unsigned long val);
+	// Get the a and b bits of the subvector, packed into words
+	// the same way the vector holds them. Each array must have
+	// room for (wid+BITS_PER_WORD-1)/BITS_PER_WORD words. The
+	// bits past wid in the last word are set to zero.
+      void get_words(unsigned adr, unsigned wid,
+		     unsigned long*abits, unsigned long*bbits) const;
 
 	// Set a 4-value bit or subvector into the vector. Return true
 	// if any bits of the vector change as a result of this operation.
@@ -306,6 +346,12 @@ class vvp_vector4_t {
 	// Test that the vectors are exactly equal
       bool eeq(const vvp_vector4_t&that) const;
 
+	// Assign that to this vector, and return true if that changed
+	// the value (i.e. the vectors were not eeq). This compares and
+	// copies in one pass, and writes nothing if the value is the
+	// same, so it is cheaper than eeq() followed by operator=.
+      bool update(const vvp_vector4_t&that);
+
 	// Test that the vectors are equal, with xz comparing as equal.
       bool eq_xz(const vvp_vector4_t&that) const;
 
@@ -324,6 +370,7 @@ class vvp_vector4_t {
       void invert();
       vvp_vector4_t& operator &= (const vvp_vector4_t&that);
       vvp_vector4_t& operator |= (const vvp_vector4_t&that);
+      vvp_vector4_t& operator ^= (const vvp_vector4_t&that);
       vvp_vector4_t& operator += (int64_t);
 
     private:
@@ -356,6 +403,30 @@ class vvp_vector4_t {
       void copy_inverted_from_(const vvp_vector4_t&that);
 
       void allocate_words_(unsigned long inita, unsigned long initb);
+      void allocate_words_big_(unsigned long inita, unsigned long initb);
+      bool update_big_(const vvp_vector4_t&that);
+
+	// The word arrays of vectors wider than BITS_PER_WORD are
+	// recycled through per-size free lists instead of going back
+	// to the heap. Vectors are created and destroyed at a high
+	// rate on the thread stack, so this keeps the common widths
+	// from calling new/delete for every instruction. Each array
+	// holds cnt abits words followed by cnt bbits words. The lists
+	// are global and not locked, so wide vectors must only be made
+	// and destroyed on the main thread.
+      enum { POOL_WORDS = 8 };
+      static unsigned long*array_pool_[POOL_WORDS+1];
+      static unsigned long*allocate_array_(unsigned cnt);
+      static void release_array_(unsigned long*ptr, unsigned cnt);
+
+    public:
+      static unsigned long count_array_allocs;
+      static unsigned long count_array_heap;
+#ifdef CHECK_WITH_VALGRIND
+      static void delete_pool(void);
+#endif
+
+    private:
 
 	// Values in the vvp_vector4_t are stored split across two
 	// arrays. For each bit in the vector, there is an abit and a
@@ -392,6 +463,16 @@ inline vvp_vector4_t::vvp_vector4_t(const vvp_vector4_t&that, bool invert_flag)
 	    copy_from_(that);
 }
 
+inline void vvp_vector4_t::allocate_words_(unsigned long inita, unsigned long initb)
+{
+      if (size_ > BITS_PER_WORD) {
+	    allocate_words_big_(inita, initb);
+      } else {
+	    abits_val_ = inita;
+	    bbits_val_ = initb;
+      }
+}
+
 inline vvp_vector4_t::vvp_vector4_t(unsigned size__, vvp_bit4_t val)
 : size_(size__)
 {
@@ -413,7 +494,7 @@ inline vvp_vector4_t::vvp_vector4_t(unsigned size__, vvp_bit4_t val)
 inline vvp_vector4_t::~vvp_vector4_t()
 {
       if (size_ > BITS_PER_WORD) {
-	    delete[] abits_ptr_;
+	    release_array_(abits_ptr_, (size_+BITS_PER_WORD-1) / BITS_PER_WORD);
 	      // bbits_ptr_ actually points half-way into a
 	      // double-length array started at abits_ptr_
       }
@@ -424,14 +505,73 @@ inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
       if (this == &that)
 	    return *this;
 
-      if (size_ > BITS_PER_WORD)
-	    delete[] abits_ptr_;
+      if (size_ > BITS_PER_WORD) {
+	    unsigned cnt = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
+	      // Assigning a vector with the same number of words can
+	      // reuse the array that is already here.
+	    if (cnt == (that.size_+BITS_PER_WORD-1) / BITS_PER_WORD) {
+		  size_ = that.size_;
+		  for (unsigned idx = 0 ;  idx < 2*cnt ;  idx += 1)
+			abits_ptr_[idx] = that.abits_ptr_[idx];
+		  return *this;
+	    }
+	    release_array_(abits_ptr_, cnt);
+      }
 
       copy_from_(that);
 
       return *this;
 }
 
+inline bool vvp_vector4_t::update(const vvp_vector4_t&that)
+{
+      if (size_ != that.size_ || size_ > BITS_PER_WORD)
+	    return update_big_(that);
+
+      unsigned long mask = size_ < BITS_PER_WORD? (1UL << size_) - 1 : ~0UL;
+      if ((((abits_val_ ^ that.abits_val_) | (bbits_val_ ^ that.bbits_val_)) & mask) == 0)
+	    return false;
+
+      abits_val_ = that.abits_val_;
+      bbits_val_ = that.bbits_val_;
+      return true;
+}
+
+#if __cplusplus >= 201103L
+inline vvp_vector4_t::vvp_vector4_t(vvp_vector4_t&&that) noexcept
+: size_(that.size_)
+{
+      if (size_ > BITS_PER_WORD) {
+	    abits_ptr_ = that.abits_ptr_;
+	    bbits_ptr_ = that.bbits_ptr_;
+      } else {
+	    abits_val_ = that.abits_val_;
+	    bbits_val_ = that.bbits_val_;
+      }
+      that.size_ = 0;
+}
+
+inline vvp_vector4_t& vvp_vector4_t::operator= (vvp_vector4_t&&that) noexcept
+{
+      if (this == &that)
+	    return *this;
+
+      if (size_ > BITS_PER_WORD)
+	    release_array_(abits_ptr_, (size_+BITS_PER_WORD-1) / BITS_PER_WORD);
+
+      size_ = that.size_;
+      if (size_ > BITS_PER_WORD) {
+	    abits_ptr_ = that.abits_ptr_;
+	    bbits_ptr_ = that.bbits_ptr_;
+      } else {
+	    abits_val_ = that.abits_val_;
+	    bbits_val_ = that.bbits_val_;
+      }
+      that.size_ = 0;
+      return *this;
+}
+#endif
+
 inline void vvp_vector4_t::copy_from_(const vvp_vector4_t&that)
 {
       size_ = that.size_;
@@ -469,6 +609,28 @@ inline vvp_bit4_t vvp_vector4_t::value(unsigned idx) const
       return (vvp_bit4_t)tmp;
 }
 
+inline bool vvp_vector4_t::get_word2(unsigned long&val) const
+{
+      if (size_ > BITS_PER_WORD)
+	    return false;
+
+      unsigned long mask = size_ < BITS_PER_WORD? (1UL << size_) - 1 : ~0UL;
+      if (bbits_val_ & mask)
+	    return false;
+
+      val = abits_val_ & mask;
+      return true;
+}
+
+inline void vvp_vector4_t::set_word2(unsigned long val)
+{
+      assert(size_ <= BITS_PER_WORD);
+
+      unsigned long mask = size_ < BITS_PER_WORD? (1UL << size_) - 1 : ~0UL;
+      abits_val_ = val & mask;
+      bbits_val_ = 0;
+}
+
 inline vvp_vector4_t vvp_vector4_t::subvalue(unsigned adr, unsigned wid) const
 {
       return vvp_vector4_t(*this, adr, wid);
@@ -614,6 +776,17 @@ class vvp_vector4array_t {
 
 /*
  * Statically allocated vvp_vector4array_t
+ *
+ * The words of a static array are packed end to end into pages of
+ * PAGE_WORDS words, so a word takes width bits of the page and not a
+ * whole cell. A page holds a plane of the abits of its words, a bit
+ * for each word that has been written, and a plane of the bbits. The
+ * bbits plane is only allocated when an X or Z bit is written into
+ * the page, so a page of words that only hold 0 and 1 takes 1 bit per
+ * bit. A page is not allocated at all until a word in it is written,
+ * and the words of a missing page (or words that were not written)
+ * read as X. This keeps large memories that are only partly used
+ * small.
  */
 class vvp_vector4array_sa : public vvp_vector4array_t {
 
@@ -625,7 +798,19 @@ class vvp_vector4array_sa : public vvp_vector4array_t {
       void set_word(unsigned idx, const vvp_vector4_t&that);
 
     private:
-      v4cell* array_;
+      enum { PAGE_WORDS = 1024 };
+      struct page_s {
+	    unsigned long*abits;
+	    unsigned long*bbits;
+	    unsigned long*valid;
+      };
+
+      page_s*make_page_(unsigned pdx);
+      unsigned long*make_plane_() const;
+
+	// Number of unsigned longs in a bit plane of a page.
+      unsigned long plane_cnt_;
+      page_s**pages_;
 };
 
 /*
@@ -659,6 +844,10 @@ class vvp_vector2_t {
 				       const vvp_vector2_t&);
       friend vvp_vector2_t operator * (const vvp_vector2_t&,
 				       const vvp_vector2_t&);
+      friend vvp_vector2_t operator / (const vvp_vector2_t&,
+				       const vvp_vector2_t&);
+      friend vvp_vector2_t operator % (const vvp_vector2_t&,
+				       const vvp_vector2_t&);
       friend bool operator >  (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator >= (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator <  (const vvp_vector2_t&, const vvp_vector2_t&);
@@ -909,6 +1098,7 @@ extern ostream& operator<< (ostream&, vvp_scalar_t);
 class vvp_vector8_t {
 
       friend vvp_vector8_t part_expand(const vvp_vector8_t&, unsigned, unsigned);
+      friend vvp_vector8_t resolve(const vvp_vector8_t&, const vvp_vector8_t&);
 
     public:
       explicit vvp_vector8_t(unsigned size =0);
@@ -949,17 +1139,7 @@ class vvp_vector8_t {
 
   /* Resolve uses the default Verilog resolver algorithm to resolve
      two drive vectors to a single output. */
-inline vvp_vector8_t resolve(const vvp_vector8_t&a, const vvp_vector8_t&b)
-{
-      assert(a.size() == b.size());
-      vvp_vector8_t out (a.size());
-
-      for (unsigned idx = 0 ;  idx < out.size() ;  idx += 1) {
-	    out.set_bit(idx, resolve(a.value(idx), b.value(idx)));
-      }
-
-      return out;
-}
+extern vvp_vector8_t resolve(const vvp_vector8_t&a, const vvp_vector8_t&b);
 
   /* This lookup tabke implements the strength reduction implied by
      Verilog standard switch devices. The major dimension selects
@@ -1115,7 +1295,26 @@ template <class T> ostream& operator << (ostream&out, vvp_sub_pointer_t<T> val)
  * all the fan-out chain, delivering the specified value. The send_*()
  * methods of the vvp_net_t class are similar, but they follow the
  * output, possibly filtered, from the vvp_net_t.
+ *
+ * Following the chain touches every receiving vvp_net_t only to find
+ * the next link, so after compile the vvp_net_freeze_fanout() function
+ * may copy the chain of a net with more than one receiver into an array
+ * of vvp_fanout_s entries. The send_*() methods then walk that array
+ * instead. Any link() or unlink() on the net drops the array again and
+ * the net goes back to using the chain.
+ *
+ * There is no room in the vvp_net_t for a pointer to the array, and
+ * there are too many nets to make them bigger just for this, so the
+ * out_ of a frozen net points into the table of arrays instead of to
+ * a receiver. The entry just before the array keeps the chain head.
+ * Only the set_frozen_fanout_(), frozen_fanout_() and frozen_chain_()
+ * methods know about this encoding, everything else goes through them.
  */
+struct vvp_fanout_s {
+      vvp_net_fun_t*fun;
+      vvp_net_ptr_t port;
+};
+
 class vvp_net_t {
     public:
       vvp_net_t();
@@ -1161,9 +1360,48 @@ class vvp_net_t {
     public: // Method to support $countdrivers
       void count_drivers(unsigned idx, unsigned counts[4]);
 
+	// Return the input that the output of this net drives, or nil
+	// if the output drives no input or more than one input.
+      vvp_net_ptr_t single_receiver(void) const;
+
     private:
       vvp_net_ptr_t out_;
 
+	// Make out_ refer to the frozen copy of the chain. The entry
+	// before list must be free, and gets the current chain head.
+      void set_frozen_fanout_(vvp_fanout_s*list);
+	// Return the frozen copy of the chain, terminated by a nil
+	// fun, or nil if the chain is not frozen.
+      const vvp_fanout_s*frozen_fanout_() const;
+	// Return the chain head that was saved with a frozen copy.
+      static vvp_net_ptr_t frozen_chain_(const vvp_fanout_s*list);
+	// Return the head of the chain, frozen or not.
+      vvp_net_ptr_t out_chain_() const;
+	// Go back to using the chain.
+      void thaw_fanout_();
+
+	// The range of addresses of the frozen fanout table.
+      static uintptr_t fanout_table_base_;
+      static uintptr_t fanout_table_size_;
+
+      void out_vec4_(const vvp_vector4_t&val, vvp_context_t context);
+      void out_vec4_pv_(const vvp_vector4_t&val,
+			unsigned base, unsigned wid, unsigned vwid,
+			vvp_context_t context);
+      void out_vec8_(const vvp_vector8_t&val);
+      void out_real_(double val, vvp_context_t context);
+
+      friend void vvp_net_freeze_fanout(void);
+
+    public: // Statistics for the frozen fanout arrays.
+      static unsigned long count_fanout_nets;
+      static unsigned long count_fanout_targets;
+
+    public: // Statistics for the vec4 values sent through filters,
+	    // and the number of those that needed a replacement copy.
+      static unsigned long count_filter_sends;
+      static unsigned long count_filter_copies;
+
     public: // Need a better new for these objects.
       static void* operator new(std::size_t size);
       static void operator delete(void*); // not implemented
@@ -1174,6 +1412,17 @@ class vvp_net_t {
 #endif
 };
 
+/*
+ * Freeze the fan-out of all the nets allocated so far into arrays. This
+ * is called once at the end of compile, if enabled.
+ */
+extern void vvp_net_freeze_fanout(void);
+
+/*
+ * Call the function for each vvp_net_t allocated so far.
+ */
+extern void vvp_net_scan(void (*fun)(vvp_net_t*net, void*cd), void*cd);
+
 /*
  * Instances of this class represent the functionality of a
  * node. vvp_net_t objects hold pointers to the vvp_net_fun_t
@@ -1291,6 +1540,12 @@ class vvp_net_fil_t  : public vvp_vpi_callback {
 	// value instead. If the function returns STOP, then all the
 	// output bits are filtered by the force mask and there is
 	// nothing to propagate.
+	//
+	// The rep is written only for REPL, so in the common PROP case
+	// the caller passes its own bit value (by reference) to all
+	// the receivers, and the value is not copied at all. The
+	// caller's rep is empty until then, so it costs nothing to
+	// construct.
       virtual prop_t filter_vec4(const vvp_vector4_t&bit, vvp_vector4_t&rep,
 				 unsigned base, unsigned vwid);
       virtual prop_t filter_vec8(const vvp_vector8_t&val, vvp_vector8_t&rep,
@@ -1692,22 +1947,100 @@ inline void vvp_send_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&val,
       }
 }
 
+/*
+ * These deliver the (already filtered) output of the net, either by
+ * walking the frozen fanout array or by following the chain. The list
+ * pointer is held locally so that a link change made by one of the
+ * receivers takes effect with the next value sent.
+ */
+inline const vvp_fanout_s* vvp_net_t::frozen_fanout_() const
+{
+      uintptr_t addr = reinterpret_cast<uintptr_t>(out_.ptr());
+      if (addr - fanout_table_base_ < fanout_table_size_)
+	    return reinterpret_cast<const vvp_fanout_s*>(addr);
+      else
+	    return 0;
+}
+
+inline vvp_net_ptr_t vvp_net_t::frozen_chain_(const vvp_fanout_s*list)
+{
+      return list[-1].port;
+}
+
+inline vvp_net_ptr_t vvp_net_t::out_chain_() const
+{
+      const vvp_fanout_s*list = frozen_fanout_();
+      return list? frozen_chain_(list) : out_;
+}
+
+inline void vvp_net_t::out_vec4_(const vvp_vector4_t&val, vvp_context_t context)
+{
+      const vvp_fanout_s*list = frozen_fanout_();
+      if (list == 0) {
+	    vvp_send_vec4(out_, val, context);
+	    return;
+      }
+
+      for (const vvp_fanout_s*cur = list ; cur->fun ; cur += 1)
+	    cur->fun->recv_vec4(cur->port, val, context);
+}
+
+inline void vvp_net_t::out_vec4_pv_(const vvp_vector4_t&val,
+				    unsigned base, unsigned wid, unsigned vwid,
+				    vvp_context_t context)
+{
+      const vvp_fanout_s*list = frozen_fanout_();
+      if (list == 0) {
+	    vvp_send_vec4_pv(out_, val, base, wid, vwid, context);
+	    return;
+      }
+
+      for (const vvp_fanout_s*cur = list ; cur->fun ; cur += 1)
+	    cur->fun->recv_vec4_pv(cur->port, val, base, wid, vwid, context);
+}
+
+inline void vvp_net_t::out_vec8_(const vvp_vector8_t&val)
+{
+      const vvp_fanout_s*list = frozen_fanout_();
+      if (list == 0) {
+	    vvp_send_vec8(out_, val);
+	    return;
+      }
+
+      for (const vvp_fanout_s*cur = list ; cur->fun ; cur += 1)
+	    cur->fun->recv_vec8(cur->port, val);
+}
+
+inline void vvp_net_t::out_real_(double val, vvp_context_t context)
+{
+      const vvp_fanout_s*list = frozen_fanout_();
+      if (list == 0) {
+	    vvp_send_real(out_, val, context);
+	    return;
+      }
+
+      for (const vvp_fanout_s*cur = list ; cur->fun ; cur += 1)
+	    cur->fun->recv_real(cur->port, val, context);
+}
+
 inline void vvp_net_t::send_vec4(const vvp_vector4_t&val, vvp_context_t context)
 {
       if (fil == 0) {
-	    vvp_send_vec4(out_, val, context);
+	    out_vec4_(val, context);
 	    return;
       }
 
+      count_filter_sends += 1;
       vvp_vector4_t rep;
       switch (fil->filter_vec4(val, rep, 0, val.size())) {
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec4(out_, val, context);
+	    out_vec4_(val, context);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec4(out_, rep, context);
+	    count_filter_copies += 1;
+	    out_vec4_(rep, context);
 	    break;
       }
 }
@@ -1717,20 +2050,22 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
 				    vvp_context_t context)
 {
       if (fil == 0) {
-	    vvp_send_vec4_pv(out_, val, base, wid, vwid, context);
+	    out_vec4_pv_(val, base, wid, vwid, context);
 	    return;
       }
 
       assert(val.size() == wid);
+      count_filter_sends += 1;
       vvp_vector4_t rep;
       switch (fil->filter_vec4(val, rep, base, vwid)) {
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec4_pv(out_, val, base, wid, vwid, context);
+	    out_vec4_pv_(val, base, wid, vwid, context);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec4_pv(out_, rep, base, wid, vwid, context);
+	    count_filter_copies += 1;
+	    out_vec4_pv_(rep, base, wid, vwid, context);
 	    break;
       }
 }
@@ -1738,7 +2073,7 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
 inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 {
       if (fil == 0) {
-	    vvp_send_vec8(out_, val);
+	    out_vec8_(val);
 	    return;
       }
 
@@ -1747,10 +2082,10 @@ inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec8(out_, val);
+	    out_vec8_(val);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec8(out_, rep);
+	    out_vec8_(rep);
 	    break;
       }
 }
@@ -1759,7 +2094,7 @@ inline void vvp_net_t::send_vec8_pv(const vvp_vector8_t&val,
 				    unsigned base, unsigned wid, unsigned vwid)
 {
       if (fil == 0) {
-	    vvp_send_vec8_pv(out_, val, base, wid, vwid);
+	    vvp_send_vec8_pv(out_chain_(), val, base, wid, vwid);
 	    return;
       }
 
@@ -1769,10 +2104,10 @@ inline void vvp_net_t::send_vec8_pv(const vvp_vector8_t&val,
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec8_pv(out_, val, base, wid, vwid);
+	    vvp_send_vec8_pv(out_chain_(), val, base, wid, vwid);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec8_pv(out_, rep, base, wid, vwid);
+	    vvp_send_vec8_pv(out_chain_(), rep, base, wid, vwid);
 	    break;
       }
 }
@@ -1782,7 +2117,7 @@ inline void vvp_net_t::send_real(double val, vvp_context_t context)
       if (fil && ! fil->filter_real(val))
 	    return;
 
-      vvp_send_real(out_, val, context);
+      out_real_(val, context);
 }
 
 
@@ -1791,7 +2126,7 @@ inline void vvp_net_t::send_string(const std::string&val, vvp_context_t context)
       if (fil && !fil->filter_string(val))
 	    return;
 
-      vvp_send_string(out_, val, context);
+      vvp_send_string(out_chain_(), val, context);
 }
 
 
@@ -1800,7 +2135,7 @@ inline void vvp_net_t::send_object(vvp_object_t val, vvp_context_t context)
       if (fil && ! fil->filter_object(val))
 	    return;
 
-      vvp_send_object(out_, val, context);
+      vvp_send_object(out_chain_(), val, context);
 }
 
 
@@ -117,12 +117,20 @@ double vvp_signal_value::real_value() const
       return 0;
 }
 
+void vvp_signal_value::vec4_words(unsigned adr, unsigned wid,
+				  unsigned long*abits, unsigned long*bbits) const
+{
+      vvp_vector4_t tmp;
+      vec4_value(tmp);
+      tmp.get_words(adr, wid, abits, bbits);
+}
+
 void vvp_net_t::force_vec4(const vvp_vector4_t&val, const vvp_vector2_t&mask)
 {
       assert(fil);
       fil->force_fil_vec4(val, mask);
       fun->force_flag(false);
-      vvp_send_vec4(out_, val, 0);
+      vvp_send_vec4(out_chain_(), val, 0);
 }
 
 void vvp_net_t::force_vec8(const vvp_vector8_t&val, const vvp_vector2_t&mask)
@@ -130,7 +138,7 @@ void vvp_net_t::force_vec8(const vvp_vector8_t&val, const vvp_vector2_t&mask)
       assert(fil);
       fil->force_fil_vec8(val, mask);
       fun->force_flag(false);
-      vvp_send_vec8(out_, val);
+      vvp_send_vec8(out_chain_(), val);
 }
 
 void vvp_net_t::force_real(double val, const vvp_vector2_t&mask)
@@ -138,7 +146,7 @@ void vvp_net_t::force_real(double val, const vvp_vector2_t&mask)
       assert(fil);
       fil->force_fil_real(val, mask);
       fun->force_flag(false);
-      vvp_send_real(out_, val, 0);
+      vvp_send_real(out_chain_(), val, 0);
 }
 
 /* **** vvp_fun_signal methods **** */
@@ -177,9 +185,8 @@ void vvp_fun_signal4_sa::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 		 copy the bits, otherwise we need to see if there are
 		 any holes in the mask so we can set those bits. */
 	    if (assign_mask_.size() == 0) {
-                  if (needs_init_ || !bits4_.eeq(bit)) {
-			assert(bit.size() == bits4_.size());
-			bits4_ = bit;
+		  assert(bit.size() == bits4_.size());
+		  if (bits4_.update(bit) || needs_init_) {
 			needs_init_ = false;
 			ptr.ptr()->send_vec4(bits4_, 0);
 		  }
@@ -382,8 +389,7 @@ void vvp_fun_signal4_aa::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       vvp_vector4_t*bits4 = static_cast<vvp_vector4_t*>
             (vvp_get_context_item(context, context_idx_));
 
-      if (!bits4->eeq(bit)) {
-            *bits4 = bit;
+      if (bits4->update(bit)) {
             ptr.ptr()->send_vec4(*bits4, context);
       }
 }
@@ -436,6 +442,15 @@ void vvp_fun_signal4_aa::vec4_value(vvp_vector4_t&val) const
       val = *bits4;
 }
 
+void vvp_fun_signal4_aa::vec4_words(unsigned adr, unsigned wid,
+				    unsigned long*abits, unsigned long*bbits) const
+{
+      vvp_vector4_t*bits4 = static_cast<vvp_vector4_t*>
+            (vthread_get_rd_context_item(context_idx_));
+
+      bits4->get_words(adr, wid, abits, bbits);
+}
+
 const vvp_vector4_t&vvp_fun_signal4_aa::vec4_unfiltered_value() const
 {
       vvp_vector4_t*bits4 = static_cast<vvp_vector4_t*>
@@ -904,8 +919,7 @@ vvp_net_fil_t::prop_t vvp_wire_vec4::filter_vec4(const vvp_vector4_t&bit, vvp_ve
 	// Keep track of the value being driven from this net, even if
 	// it is not ultimately what survives the force filter.
       if (base==0 && bit.size()==vwid) {
-	    if (bits4_ .eeq( bit ) && !needs_init_) return STOP;
-	    bits4_ = bit;
+	    if (! bits4_.update(bit) && !needs_init_) return STOP;
       } else {
 	    bool rc = bits4_.set_vec(base, bit);
 	    if (rc == false && !needs_init_) return STOP;
@@ -1046,6 +1060,17 @@ void vvp_wire_vec4::vec4_value(vvp_vector4_t&val) const
 	    val.set_bit(idx, filtered_value_(idx));
 }
 
+void vvp_wire_vec4::vec4_words(unsigned adr, unsigned wid,
+			       unsigned long*abits, unsigned long*bbits) const
+{
+      if (! test_force_mask_is_zero()) {
+	    vvp_signal_value::vec4_words(adr, wid, abits, bbits);
+	    return;
+      }
+
+      bits4_.get_words(adr, wid, abits, bbits);
+}
+
 vvp_bit4_t vvp_wire_vec4::driven_value(unsigned idx) const
 {
       return bits4_.value(idx);
@@ -103,6 +103,11 @@ class vvp_signal_value {
       virtual vvp_scalar_t scalar_value(unsigned idx) const =0;
       virtual void vec4_value(vvp_vector4_t&) const =0;
       virtual double real_value() const;
+	// Get the a/b bits of the part [adr, adr+wid) of the value,
+	// packed into words like vvp_vector4_t::get_words(). This
+	// default gets the whole vec4_value() first.
+      virtual void vec4_words(unsigned adr, unsigned wid,
+			      unsigned long*abits, unsigned long*bbits) const;
 
       virtual void get_signal_value(struct t_vpi_value*vp);
 };
@@ -185,6 +190,8 @@ class vvp_fun_signal4_aa : public vvp_fun_signal_vec, public automatic_signal_ba
       vvp_bit4_t value(unsigned idx) const;
       vvp_scalar_t scalar_value(unsigned idx) const;
       void vec4_value(vvp_vector4_t&) const;
+      void vec4_words(unsigned adr, unsigned wid,
+		      unsigned long*abits, unsigned long*bbits) const;
       const vvp_vector4_t& vec4_unfiltered_value() const;
 
     public: // These objects are only permallocated.
@@ -448,6 +455,8 @@ class vvp_wire_vec4 : public vvp_wire_base {
       vvp_bit4_t value(unsigned idx) const;
       vvp_scalar_t scalar_value(unsigned idx) const;
       void vec4_value(vvp_vector4_t&) const;
+      void vec4_words(unsigned adr, unsigned wid,
+		      unsigned long*abits, unsigned long*bbits) const;
 
         // Support for $countdrivers
       vvp_bit4_t driven_value(unsigned idx) const;